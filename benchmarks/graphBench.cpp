@@ -0,0 +1,732 @@
+// Times the public operations of GraphMatrix and MixedGraphMatrix, and the algorithms, on a
+// generated graph and prints one JSON document, so runs of two versions can be diffed.
+//
+//   g++ -std=c++17 -O2 -pthread benchmarks/graphBench.cpp -o graphBench
+//   ./graphBench --graph rmat --vertices 4096 --degree 8 --seed 1 --threads 4 > before.json
+//
+// Options: --graph er|rmat|grid, --vertices N (at least 1), --degree D (average out-degree),
+// --seed S, --threads T (batch, algorithm and generator threads), --repeat R (best of R runs),
+// --path-depth L (findAllPaths and forEachPath limit).
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+#include "../include/GraphMatrix.h"
+#include "../include/MixedGraph.h"
+#include "../include/GraphCSR.h"
+#include "../include/GraphGenerators.h"
+#include "../include/Dijkstra.h"
+#include "../include/BFS.h"
+#include "../include/AllPairs.h"
+#include "../include/Reachability.h"
+#include "../include/Triangles.h"
+
+using namespace Appledore;
+
+using Matrix = GraphMatrix<size_t, uint32_t, DirectedG>;
+using HashedMatrix = GraphMatrix<size_t, uint32_t, DirectedG, HashedVertexIndex<size_t>>;
+using UndirectedMatrix = GraphMatrix<size_t, uint32_t, UndirectedG>;
+using Mixed = MixedGraphMatrix<size_t, uint32_t>;
+using Sparse = GraphCSR<size_t, uint32_t, DirectedG>;
+
+struct Config
+{
+    std::string graph = "rmat";
+    size_t vertices = 1024;
+    size_t degree = 8;
+    uint64_t seed = 1;
+    unsigned threads = 1;
+    size_t repeat = 3;
+    size_t pathDepth = 4;
+};
+
+struct Result
+{
+    std::string name;
+    size_t ops;
+    double seconds;
+    // How far the benchmark, setup included, raised the process peak RSS; 0 when it stayed
+    // under an earlier peak.
+    long peakRssGrowthKiB;
+};
+
+// Peak resident set size of the process so far, 0 where getrusage is unavailable.
+long peakRssKiB()
+{
+#if defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+#elif defined(__unix__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+// Keeps results alive so the optimizer cannot drop the measured work.
+volatile size_t sink = 0;
+
+class Bench
+{
+public:
+    explicit Bench(size_t repeat) : repeat(std::max<size_t>(repeat, 1)) {}
+
+    // run() returns the number of operations it performed; the fastest of `repeat` runs counts.
+    void measure(const std::string &name, const std::function<size_t()> &run)
+    {
+        measure(name, [] { return 0; }, [&](int) { return run(); });
+    }
+
+    // prepare() builds untimed state for each run, run(state) is timed.
+    template <typename Prepare, typename Run>
+    void measure(const std::string &name, Prepare &&prepare, Run &&run)
+    {
+        Result result{name, 0, 0.0, 0};
+        long peakBefore = peakRssKiB();
+        for (size_t attempt = 0; attempt < repeat; ++attempt)
+        {
+            auto state = prepare();
+            auto start = std::chrono::steady_clock::now();
+            size_t ops = run(state);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (attempt == 0 || seconds < result.seconds)
+            {
+                result.seconds = seconds;
+                result.ops = ops;
+            }
+        }
+        result.peakRssGrowthKiB = peakRssKiB() - peakBefore;
+        results.push_back(result);
+        std::cerr << name << ": " << result.ops << " ops, " << result.seconds * 1e3 << " ms\n";
+    }
+
+    void print(const Config &config, const GeneratedGraph &graph, std::ostream &out) const
+    {
+        out << "{\n  \"library\": \"Appledore\",\n  \"config\": {\"graph\": \"" << config.graph
+            << "\", \"vertices\": " << graph.vertexCount << ", \"edges\": " << graph.edges.size()
+            << ", \"degree\": " << config.degree << ", \"seed\": " << config.seed
+            << ", \"threads\": " << config.threads << ", \"repeat\": " << repeat << "},\n";
+        out << "  \"peakRssKiB\": " << peakRssKiB() << ",\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &result = results[i];
+            double nsPerOp = result.ops ? result.seconds * 1e9 / result.ops : 0.0;
+            double opsPerSecond = result.seconds > 0 ? result.ops / result.seconds : 0.0;
+            out << "    {\"name\": \"" << result.name << "\", \"ops\": " << result.ops << ", \"seconds\": " << result.seconds
+                << ", \"nsPerOp\": " << nsPerOp << ", \"opsPerSecond\": " << opsPerSecond
+                << ", \"peakRssGrowthKiB\": " << result.peakRssGrowthKiB << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+private:
+    size_t repeat;
+    std::vector<Result> results;
+};
+
+Config parseArguments(int argc, char **argv)
+{
+    Config config;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string flag = argv[i];
+        std::string value = argv[i + 1];
+        if (flag == "--graph")
+            config.graph = value;
+        else if (flag == "--vertices")
+            config.vertices = std::stoull(value);
+        else if (flag == "--degree")
+            config.degree = std::stoull(value);
+        else if (flag == "--seed")
+            config.seed = std::stoull(value);
+        else if (flag == "--threads")
+            config.threads = static_cast<unsigned>(std::stoul(value));
+        else if (flag == "--repeat")
+            config.repeat = std::stoull(value);
+        else if (flag == "--path-depth")
+            config.pathDepth = std::stoull(value);
+        else
+            throw std::invalid_argument("Unknown option " + flag);
+    }
+    if (config.vertices == 0)
+        throw std::invalid_argument("--vertices must be at least 1");
+    return config;
+}
+
+GeneratedGraph generate(const Config &config, bool undirected)
+{
+    GeneratorOptions options;
+    options.seed = config.seed;
+    options.threads = config.threads;
+    options.undirected = undirected;
+    if (config.graph == "er")
+        return erdosRenyi(config.vertices, std::min(1.0, double(config.degree) / std::max<size_t>(config.vertices, 1)), options);
+    if (config.graph == "grid")
+    {
+        size_t side = static_cast<size_t>(std::ceil(std::sqrt(double(config.vertices))));
+        return grid(side, side, options);
+    }
+    if (config.graph == "rmat")
+    {
+        unsigned scale = 0;
+        while ((size_t(1) << scale) < config.vertices)
+        {
+            ++scale;
+        }
+        return rmat(scale, config.degree, options);
+    }
+    throw std::invalid_argument("Unknown graph " + config.graph);
+}
+
+template <typename Graph>
+Graph withVertices(size_t count)
+{
+    Graph graph;
+    graph.reserveVertices(count);
+    for (size_t vertex = 0; vertex < count; ++vertex)
+    {
+        graph.addVertex(vertex);
+    }
+    return graph;
+}
+
+int main(int argc, char **argv)
+{
+    Config config;
+    try
+    {
+        config = parseArguments(argc, argv);
+    }
+    catch (const std::exception &error)
+    {
+        std::cerr << "graphBench: " << error.what() << "\n";
+        return 2;
+    }
+    Bench bench(config.repeat);
+
+    GeneratedGraph generated;
+    bench.measure("generate." + config.graph, [&]
+                  {
+                      generated = generate(config, false);
+                      return generated.edges.size(); });
+    const size_t n = generated.vertexCount;
+    const auto &edges = generated.edges;
+
+    // random probes, half of them existing edges
+    std::vector<std::pair<size_t, size_t>> probes;
+    {
+        detail::SplitMix64 rng(config.seed + 1);
+        for (size_t i = 0; i < std::max<size_t>(edges.size(), 1024); ++i)
+        {
+            if (!edges.empty() && i % 2 == 0)
+            {
+                const GeneratedEdge &edge = edges[rng.next() % edges.size()];
+                probes.emplace_back(edge.src, edge.dest);
+            }
+            else
+            {
+                probes.emplace_back(rng.next() % n, rng.next() % n);
+            }
+        }
+    }
+    std::vector<std::tuple<size_t, size_t, uint32_t>> batch;
+    batch.reserve(edges.size());
+    for (const GeneratedEdge &edge : edges)
+    {
+        batch.emplace_back(edge.src, edge.dest, edge.weight);
+    }
+    std::vector<size_t> doomed;
+    for (size_t vertex = 0; vertex < n; vertex += 4)
+    {
+        doomed.push_back(vertex);
+    }
+
+    // GraphMatrix
+    bench.measure("matrix.addVertex", [] { return Matrix(); }, [&](Matrix &graph)
+                  {
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          graph.addVertex(vertex);
+                      }
+                      return n; });
+    bench.measure("matrix.addEdge(key)", [&] { return withVertices<Matrix>(n); }, [&](Matrix &graph)
+                  {
+                      for (const GeneratedEdge &edge : edges)
+                      {
+                          graph.addEdge(edge.src, edge.dest, edge.weight);
+                      }
+                      return edges.size(); });
+    bench.measure("matrix.addEdge(handle)", [&] { return withVertices<Matrix>(n); }, [&](Matrix &graph)
+                  {
+                      for (const GeneratedEdge &edge : edges)
+                      {
+                          graph.addEdge(VertexHandle(edge.src), VertexHandle(edge.dest), edge.weight);
+                      }
+                      return edges.size(); });
+    bench.measure("matrix.addEdges", [&] { return withVertices<Matrix>(n); }, [&](Matrix &graph)
+                  {
+                      graph.addEdges(batch, {config.threads});
+                      return batch.size(); });
+
+    const Matrix matrix = buildGraph<Matrix>(generated);
+    bench.measure("matrix.copy", [&]
+                  {
+                      Matrix copy(matrix);
+                      sink = sink + copy.getVertices().size();
+                      return size_t(1); });
+    bench.measure("matrix.findVertex", [&]
+                  {
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          sink = sink + matrix.findVertex(vertex)->index;
+                      }
+                      return n; });
+    bench.measure("matrix.hasEdge(key)", [&]
+                  {
+                      for (const auto &[src, dest] : probes)
+                      {
+                          sink = sink + matrix.hasEdge(src, dest);
+                      }
+                      return probes.size(); });
+    bench.measure("matrix.hasEdge(handle)", [&]
+                  {
+                      for (const auto &[src, dest] : probes)
+                      {
+                          sink = sink + matrix.hasEdge(VertexHandle(src), VertexHandle(dest));
+                      }
+                      return probes.size(); });
+    bench.measure("matrix.operator()", [&]
+                  {
+                      for (const auto &[src, dest] : probes)
+                      {
+                          sink = sink + matrix(src, dest);
+                      }
+                      return probes.size(); });
+    bench.measure("matrix.getEdge", [&]
+                  {
+                      for (const GeneratedEdge &edge : edges)
+                      {
+                          sink = sink + matrix.getEdge(edge.src, edge.dest);
+                      }
+                      return edges.size(); });
+    bench.measure("matrix.degree(key)", [&]
+                  {
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          sink = sink + matrix.indegree(vertex) + matrix.outdegree(vertex) + matrix.totalDegree(vertex);
+                      }
+                      return 3 * n; });
+    bench.measure("matrix.degrees", [&]
+                  {
+                      sink = sink + matrix.degrees().size();
+                      return n; });
+    bench.measure("matrix.getNeighbors(key)", [&]
+                  {
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          sink = sink + matrix.getNeighbors(vertex).size();
+                      }
+                      return n; });
+    bench.measure("matrix.getNeighbors(handle)", [&]
+                  {
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          sink = sink + matrix.getNeighbors(VertexHandle(vertex)).size();
+                      }
+                      return n; });
+    bench.measure("matrix.forEachOutEdge", [&]
+                  {
+                      size_t visited = 0;
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          matrix.forEachOutEdge(VertexHandle(vertex), [&](VertexHandle, const uint32_t &value)
+                                                { visited += value != 0; });
+                      }
+                      sink = sink + visited;
+                      return visited; });
+    bench.measure("matrix.forEachInEdge", [&]
+                  {
+                      size_t visited = 0;
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          matrix.forEachInEdge(VertexHandle(vertex), [&](VertexHandle, const uint32_t &value)
+                                               { visited += value != 0; });
+                      }
+                      sink = sink + visited;
+                      return visited; });
+    bench.measure("matrix.neighbors", [&]
+                  {
+                      size_t visited = 0;
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          for (VertexHandle dest : matrix.neighbors(VertexHandle(vertex)))
+                          {
+                              visited += dest.index != vertex;
+                          }
+                      }
+                      sink = sink + visited;
+                      return visited; });
+    bench.measure("matrix.outEdges", [&]
+                  {
+                      size_t visited = 0;
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          for (const auto &edge : matrix.outEdges(VertexHandle(vertex)))
+                          {
+                              visited += edge.value != 0;
+                          }
+                      }
+                      sink = sink + visited;
+                      return visited; });
+    bench.measure("matrix.inEdges", [&]
+                  {
+                      size_t visited = 0;
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          for (const auto &edge : matrix.inEdges(VertexHandle(vertex)))
+                          {
+                              visited += edge.value != 0;
+                          }
+                      }
+                      sink = sink + visited;
+                      return visited; });
+    bench.measure("matrix.edges", [&]
+                  {
+                      size_t visited = 0;
+                      for (const auto &edge : matrix.edges())
+                      {
+                          visited += edge.value != 0;
+                      }
+                      sink = sink + visited;
+                      return visited; });
+    bench.measure("matrix.getAllEdges", [&]
+                  {
+                      size_t count = matrix.getAllEdges().size();
+                      sink = sink + count;
+                      return count; });
+    bench.measure("matrix.findAllPaths", [&]
+                  {
+                      PathOptions options;
+                      options.maxDepth = config.pathDepth;
+                      options.maxPaths = 100000;
+                      size_t found = 0;
+                      for (size_t src = 0; src < std::min<size_t>(n, 8); ++src)
+                      {
+                          found += matrix.findAllPaths(src, n - 1 - src, options).size();
+                      }
+                      sink = sink + found;
+                      return found; });
+    bench.measure("matrix.forEachPath", [&]
+                  {
+                      PathOptions options;
+                      options.maxDepth = config.pathDepth;
+                      options.maxPaths = 100000;
+                      size_t found = 0;
+                      for (size_t src = 0; src < std::min<size_t>(n, 8); ++src)
+                      {
+                          found += matrix.forEachPath(VertexHandle(src), VertexHandle(n - 1 - src), [&](const std::vector<VertexHandle> &path)
+                                                      { sink = sink + path.size(); }, options);
+                      }
+                      return found; });
+    bench.measure("matrix.memoryUsage", [&]
+                  {
+                      sink = sink + matrix.memoryUsage().storedCells;
+                      return size_t(1); });
+    bench.measure("matrix.updateEdge", [&] { return Matrix(matrix); }, [&](Matrix &graph)
+                  {
+                      for (const GeneratedEdge &edge : edges)
+                      {
+                          graph.updateEdge(edge.src, edge.dest, edge.weight + 1);
+                      }
+                      return edges.size(); });
+    bench.measure("matrix.updateEdges", [&] { return Matrix(matrix); }, [&](Matrix &graph)
+                  {
+                      graph.updateEdges(batch, {config.threads});
+                      return batch.size(); });
+    bench.measure("matrix.removeEdge", [&] { return Matrix(matrix); }, [&](Matrix &graph)
+                  {
+                      for (const GeneratedEdge &edge : edges)
+                      {
+                          graph.removeEdge(edge.src, edge.dest);
+                      }
+                      return edges.size(); });
+    bench.measure("matrix.removeEdges", [&] { return Matrix(matrix); }, [&](Matrix &graph)
+                  {
+                      graph.removeEdges(batch, {config.threads});
+                      return batch.size(); });
+    bench.measure("matrix.removeVertex", [&] { return Matrix(matrix); }, [&](Matrix &graph)
+                  {
+                      for (size_t vertex : doomed)
+                      {
+                          graph.removeVertex(vertex);
+                      }
+                      return doomed.size(); });
+    bench.measure("matrix.removeVertices", [&] { return Matrix(matrix); }, [&](Matrix &graph)
+                  {
+                      graph.removeVertices(doomed);
+                      return doomed.size(); });
+    {
+        std::string path = (std::filesystem::temp_directory_path() / "graphBench.appledore").string();
+        bench.measure("matrix.save", [&]
+                      {
+                          matrix.save(path);
+                          return size_t(1); });
+        bench.measure("matrix.load", [&]
+                      {
+                          sink = sink + Matrix::load(path).getVertices().size();
+                          return size_t(1); });
+        std::filesystem::remove(path);
+    }
+
+    // GraphMatrix with HashedVertexIndex, the lookup-heavy calls only
+    bench.measure("hashedMatrix.addVertex", [] { return HashedMatrix(); }, [&](HashedMatrix &graph)
+                  {
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          graph.addVertex(vertex);
+                      }
+                      return n; });
+    {
+        const HashedMatrix hashed = buildGraph<HashedMatrix>(generated);
+        bench.measure("hashedMatrix.hasEdge(key)", [&]
+                      {
+                          for (const auto &[src, dest] : probes)
+                          {
+                              sink = sink + hashed.hasEdge(src, dest);
+                          }
+                          return probes.size(); });
+    }
+
+    // MixedGraphMatrix: odd edges directed, even edges undirected
+    bench.measure("mixed.addVertex", [] { return Mixed(); }, [&](Mixed &graph)
+                  {
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          graph.addVertex(vertex);
+                      }
+                      return n; });
+    bench.measure("mixed.addEdge(key)", [&] { return withVertices<Mixed>(n); }, [&](Mixed &graph)
+                  {
+                      for (size_t i = 0; i < edges.size(); ++i)
+                      {
+                          graph.addEdge(edges[i].src, edges[i].dest, edges[i].weight, i % 2 == 1);
+                      }
+                      return edges.size(); });
+    std::vector<std::tuple<size_t, size_t, uint32_t, bool>> mixedBatch;
+    for (size_t i = 0; i < edges.size(); ++i)
+    {
+        mixedBatch.emplace_back(edges[i].src, edges[i].dest, edges[i].weight, i % 2 == 1);
+    }
+    bench.measure("mixed.addEdges", [&] { return withVertices<Mixed>(n); }, [&](Mixed &graph)
+                  {
+                      graph.addEdges(mixedBatch, {config.threads});
+                      return mixedBatch.size(); });
+
+    Mixed mixed = withVertices<Mixed>(n);
+    mixed.addEdges(mixedBatch);
+    bench.measure("mixed.copy", [&]
+                  {
+                      Mixed copy(mixed);
+                      sink = sink + copy.getVertices().size();
+                      return size_t(1); });
+    bench.measure("mixed.findVertex", [&]
+                  {
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          sink = sink + mixed.findVertex(vertex)->index;
+                      }
+                      return n; });
+    bench.measure("mixed.hasEdge(key)", [&]
+                  {
+                      for (const auto &[src, dest] : probes)
+                      {
+                          sink = sink + mixed.hasEdge(src, dest);
+                      }
+                      return probes.size(); });
+    bench.measure("mixed.operator()", [&]
+                  {
+                      for (const auto &[src, dest] : probes)
+                      {
+                          sink = sink + mixed(src, dest);
+                      }
+                      return probes.size(); });
+    bench.measure("mixed.getEdgeValue", [&]
+                  {
+                      for (const GeneratedEdge &edge : edges)
+                      {
+                          sink = sink + mixed.getEdgeValue(edge.src, edge.dest);
+                      }
+                      return edges.size(); });
+    bench.measure("mixed.degree(key)", [&]
+                  {
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          sink = sink + mixed.indegree(vertex) + mixed.outdegree(vertex) + mixed.totalDegree(vertex);
+                      }
+                      return 3 * n; });
+    bench.measure("mixed.degrees", [&]
+                  {
+                      sink = sink + mixed.degrees().size();
+                      return n; });
+    bench.measure("mixed.forEachOutEdge", [&]
+                  {
+                      size_t visited = 0;
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          mixed.forEachOutEdge(VertexHandle(vertex), [&](VertexHandle, const uint32_t &value)
+                                               { visited += value != 0; });
+                      }
+                      sink = sink + visited;
+                      return visited; });
+    bench.measure("mixed.forEachInEdge", [&]
+                  {
+                      size_t visited = 0;
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          mixed.forEachInEdge(VertexHandle(vertex), [&](VertexHandle, const uint32_t &value)
+                                              { visited += value != 0; });
+                      }
+                      sink = sink + visited;
+                      return visited; });
+    bench.measure("mixed.neighbors", [&]
+                  {
+                      size_t visited = 0;
+                      for (size_t vertex = 0; vertex < n; ++vertex)
+                      {
+                          for (VertexHandle dest : mixed.neighbors(VertexHandle(vertex)))
+                          {
+                              visited += dest.index != vertex;
+                          }
+                      }
+                      sink = sink + visited;
+                      return visited; });
+    bench.measure("mixed.edges", [&]
+                  {
+                      size_t visited = 0;
+                      for (const auto &edge : mixed.edges())
+                      {
+                          visited += edge.value != 0;
+                      }
+                      sink = sink + visited;
+                      return visited; });
+    bench.measure("mixed.getEdges", [&]
+                  {
+                      size_t count = mixed.getEdges().size();
+                      sink = sink + count;
+                      return count; });
+    bench.measure("mixed.updateEdge", [&] { return Mixed(mixed); }, [&](Mixed &graph)
+                  {
+                      for (const GeneratedEdge &edge : edges)
+                      {
+                          graph.updateEdge(edge.src, edge.dest, edge.weight + 1);
+                      }
+                      return edges.size(); });
+    bench.measure("mixed.updateEdges", [&] { return Mixed(mixed); }, [&](Mixed &graph)
+                  {
+                      graph.updateEdges(batch, {config.threads});
+                      return batch.size(); });
+    bench.measure("mixed.removeEdge", [&] { return Mixed(mixed); }, [&](Mixed &graph)
+                  {
+                      for (const GeneratedEdge &edge : edges)
+                      {
+                          graph.removeEdge(edge.src, edge.dest);
+                      }
+                      return edges.size(); });
+    bench.measure("mixed.removeEdges", [&] { return Mixed(mixed); }, [&](Mixed &graph)
+                  {
+                      graph.removeEdges(mixedBatch, {config.threads});
+                      return mixedBatch.size(); });
+    bench.measure("mixed.removeVertex", [&] { return Mixed(mixed); }, [&](Mixed &graph)
+                  {
+                      for (size_t vertex : doomed)
+                      {
+                          graph.removeVertex(vertex);
+                      }
+                      return doomed.size(); });
+    bench.measure("mixed.removeVertices", [&] { return Mixed(mixed); }, [&](Mixed &graph)
+                  {
+                      graph.removeVertices(doomed);
+                      return doomed.size(); });
+    {
+        std::string path = (std::filesystem::temp_directory_path() / "graphBench-mixed.appledore").string();
+        bench.measure("mixed.save", [&]
+                      {
+                          mixed.save(path);
+                          return size_t(1); });
+        bench.measure("mixed.load", [&]
+                      {
+                          sink = sink + Mixed::load(path).getVertices().size();
+                          return size_t(1); });
+        std::filesystem::remove(path);
+    }
+
+    // Algorithms, from up to 8 sources
+    const size_t sources = std::min<size_t>(n, 8);
+    bench.measure("dijkstra.matrix", [&]
+                  {
+                      for (size_t src = 0; src < sources; ++src)
+                      {
+                          sink = sink + dijkstra(matrix, VertexHandle(src)).distance.size();
+                      }
+                      return sources; });
+    bench.measure("bfs.matrix", [&]
+                  {
+                      BFSOptions options;
+                      options.threads = config.threads;
+                      for (size_t src = 0; src < sources; ++src)
+                      {
+                          sink = sink + bfs(matrix, VertexHandle(src), options).maxDepth;
+                      }
+                      return sources; });
+    {
+        const Sparse sparse = buildGraph<Sparse>(generated);
+        bench.measure("dijkstra.csr", [&]
+                      {
+                          for (size_t src = 0; src < sources; ++src)
+                          {
+                              sink = sink + dijkstra(sparse, VertexHandle(src)).distance.size();
+                          }
+                          return sources; });
+    }
+    if (n <= 4096)
+    {
+        bench.measure("allPairs.matrix", [&]
+                      {
+                          AllPairsOptions options;
+                          options.threads = config.threads;
+                          sink = sink + allPairsShortestPaths(matrix, EdgeValue(), options).distance.size();
+                          return n * n; });
+    }
+    bench.measure("reachability.build", [&]
+                  {
+                      ReachabilityOptions options;
+                      options.threads = config.threads;
+                      ReachabilityIndex index(matrix, options);
+                      sink = sink + index.reachable(VertexHandle(0), VertexHandle(n - 1));
+                      return n; });
+    {
+        const UndirectedMatrix undirected = buildGraph<UndirectedMatrix>(generate(config, true));
+        bench.measure("triangles.matrix", [&]
+                      {
+                          TriangleOptions options;
+                          options.threads = config.threads;
+                          TriangleCounts counts = countTriangles(undirected, options);
+                          sink = sink + counts.triangles;
+                          return n; });
+    }
+
+    bench.print(config, generated, std::cout);
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <iostream>
+#include <string>
+#include "../include/GraphList.h"
+
+using namespace Appledore;
+
+class Friendship
+{
+public:
+    int sinceYear;
+    std::string friendshipType;
+
+    Friendship(int sinceYear = 0, const std::string &friendshipType = "")
+        : sinceYear(sinceYear), friendshipType(friendshipType) {}
+
+    friend std::ostream &operator<<(std::ostream &os, const Friendship &friendship)
+    {
+        os << "{ Since: " << friendship.sinceYear << ", Type: \"" << friendship.friendshipType << "\" }";
+        return os;
+    }
+};
+
+int main()
+{
+    // Same API as GraphMatrix, only the type changes
+    GraphList<std::string, Friendship, UndirectedG> socialGraph;
+
+    socialGraph.addVertex(std::string("Alice"), std::string("Bob"), std::string("Charlie"), std::string("David"));
+
+    socialGraph.addEdge("Alice", "Bob", Friendship(2015, "Best Friends"));
+    socialGraph.addEdge("Alice", "Charlie", Friendship(2018, "Work Friends"));
+    socialGraph.addEdge("Bob", "David", Friendship(2020, "College Friends"));
+    socialGraph.addEdge("Charlie", "David", Friendship(2018, "Work Friends"));
+
+    std::cout << "Friends of Alice:\n";
+    for (const auto &friendName : socialGraph.getNeighbors("Alice"))
+    {
+        std::cout << " - " << friendName << "\n";
+    }
+
+    // Removing an edge swaps the last entry of the row into its slot
+    socialGraph.removeEdge("Alice", "Bob");
+    std::cout << "\nAre Alice and Bob still friends? " << (socialGraph("Alice", "Bob") ? "Yes" : "No") << "\n";
+    std::cout << "Total No. of friends Alice has: " << socialGraph.totalDegree("Alice") << "\n";
+
+    // Same API as MixedGraphMatrix, each edge keeps its own directed flag
+    MixedGraphList<std::string, int> roads;
+    roads.addVertex("A");
+    roads.addVertex("B");
+    roads.addVertex("C");
+
+    roads.addEdge("A", "B", 5, true);  // A -> B
+    roads.addEdge("B", "C", 10, false); // B <-> C
+
+    std::cout << "\nEdge C -> B exists? " << (roads.hasEdge("C", "B") ? "Yes" : "No") << "\n";
+    std::cout << "Edge B -> A exists? " << (roads.hasEdge("B", "A") ? "Yes" : "No") << "\n";
+
+    roads.updateEdge("C", "B", 12);
+    std::cout << "Weight of B -> C after update: " << roads.getEdgeValue("B", "C") << "\n";
+
+    std::cout << "Edges in the graph: ";
+    for (const auto &edge : roads.getEdges())
+    {
+        std::cout << edge << " ";
+    }
+    std::cout << "\n";
+
+    return 0;
+}
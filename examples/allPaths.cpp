@@ -1,5 +1,4 @@
 #include <iostream>
-#include <stack>
 #include "../include/GraphMatrix.h"
 
 using namespace Appledore;
@@ -103,5 +102,21 @@ int main()
         std::cout << "END\n";
     }
 
+    // Stream paths instead of collecting them: at most 3 flights, stop after the first 2 routes
+    std::cout << "\nFirst two routes from LAX to ATL with at most 3 flights:\n";
+    PathOptions options;
+    options.maxDepth = 3;
+    options.maxPaths = 2;
+    auto LAXHandle = *AirportsGraph.findVertex(LAX);
+    auto ATLHandle = *AirportsGraph.findVertex(ATL);
+    AirportsGraph.forEachPath(LAXHandle, ATLHandle, [&](const std::vector<VertexHandle> &path)
+                              {
+                                  for (const auto &vertex : path)
+                                  {
+                                      std::cout << AirportsGraph.getVertex(vertex) << " -> ";
+                                  }
+                                  std::cout << "END\n"; },
+                              options);
+
     return 0;
 }
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <string>
+#include <filesystem>
+#include "../include/GraphCSR.h"
+
+using namespace Appledore;
+
+class Flight
+{
+public:
+    int distance;
+
+    Flight(int dis = 0) : distance(dis) {}
+
+    friend std::ostream &operator<<(std::ostream &os, const Flight &flight)
+    {
+        os << flight.distance << " miles";
+        return os;
+    }
+};
+
+int main()
+{
+    // Sparse route network, memory grows with the number of routes instead of airports^2
+    GraphCSR<std::string, Flight, DirectedG> routes;
+
+    routes.addVertex(std::string("LAX"), std::string("JFK"), std::string("DEN"), std::string("ATL"), std::string("SEA"));
+
+    routes.addEdge("LAX", "ATL", Flight(1945));
+    routes.addEdge("LAX", "JFK", Flight(2475));
+    routes.addEdge("JFK", "ATL", Flight(761));
+    routes.addEdge("JFK", "DEN", Flight(1631));
+    routes.addEdge("DEN", "ATL", Flight(1199));
+    routes.addEdge("SEA", "DEN", Flight(1021));
+
+    // Compact the staged routes before querying
+    routes.finalize();
+
+    std::cout << "Routes in the graph:\n";
+    for (const auto &[src, dest, edge] : routes.getAllEdges())
+    {
+        std::cout << src << " -> " << dest << " : " << edge << "\n";
+    }
+
+    std::cout << "\nJFK to DEN: " << (routes("JFK", "DEN") ? "Exists" : "Does not exist") << "\n";
+    std::cout << "DEN to JFK: " << (routes("DEN", "JFK") ? "Exists" : "Does not exist") << "\n";
+    std::cout << "LAX to JFK distance: " << routes.getEdge("LAX", "JFK") << "\n";
+
+    std::cout << "\nDestinations from JFK:\n";
+    for (const auto &airport : routes.getNeighbors("JFK"))
+    {
+        std::cout << " - " << airport << "\n";
+    }
+
+    std::cout << "\nFlights into ATL: " << routes.indegree("ATL") << "\n";
+    std::cout << "Flights out of LAX: " << routes.outdegree("LAX") << "\n";
+
+    // Adding a route after finalize() stages it until the next finalize()
+    routes.addEdge("ATL", "SEA", Flight(2182));
+    routes.finalize();
+
+    std::cout << "\nAll paths from LAX to DEN:\n";
+    for (const auto &path : routes.findAllPaths("LAX", "DEN"))
+    {
+        for (const auto &airport : path)
+        {
+            std::cout << airport << " -> ";
+        }
+        std::cout << "END\n";
+    }
+
+    // Snapshot the network; Flight is trivially copyable, so a MappedGraph can query the
+    // file in place after a restart instead of rebuilding the graph.
+    std::string snapshot = (std::filesystem::temp_directory_path() / "routes.appledore").string();
+    routes.save(snapshot);
+
+    MappedGraph<std::string, Flight> mapped(snapshot);
+    VertexHandle jfk = *mapped.findVertex("JFK");
+    std::cout << "\nFrom the snapshot, routes out of JFK:\n";
+    mapped.forEachOutEdge(jfk, [&](VertexHandle dest, const Flight &flight)
+                          { std::cout << " - " << mapped.getVertices()[dest.index] << " : " << flight << "\n"; });
+
+    auto reloaded = GraphCSR<std::string, Flight, DirectedG>::load(snapshot);
+    std::cout << "Reloaded routes: " << reloaded.edgeCount() << "\n";
+    std::filesystem::remove(snapshot);
+
+    return 0;
+}
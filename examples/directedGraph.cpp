@@ -82,8 +82,9 @@ int main()
     std::cout << "\nRemoving edge JFK -> DEN...\n";
     AirportsGraph.removeEdge(JFK, DEN);
 
+    // edges() walks the matrix lazily, without copying airports or flights
     std::cout << "\nUpdated edges in the graph:\n";
-    for (const auto &[src, dest, edge] : AirportsGraph.getAllEdges())
+    for (const auto &[src, dest, edge] : AirportsGraph.edges())
     {
         std::cout << src << " -> " << dest << " : " << edge << "\n";
     }
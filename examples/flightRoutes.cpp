@@ -26,7 +26,12 @@ public:
 int main()
 {
     // Create a graph to represent flight routes
-    Appledore::MixedGraphMatrix<std::string, FlightRoute> flightGraph;
+    // HashedVertexIndex gives O(1) city lookups, and string literals are looked up without
+    // building a temporary std::string. PooledEdges keeps the string-carrying routes out of the
+    // matrix, which then holds a 32-bit slot per cell, and a two-way route stores one FlightRoute.
+    Appledore::MixedGraphMatrix<std::string, FlightRoute, Appledore::HashedVertexIndex<std::string>,
+                                Appledore::PooledEdges>
+        flightGraph;
 
     // Add cities as vertices
     flightGraph.addVertex("New York");
@@ -66,5 +71,14 @@ int main()
     // Check for a non-existent route
     // flightGraph.getEdgeValue("Paris", "New York"); //throws error, handle carefully
 
+    // London closes: its routes go with it, and Tokyo takes over its slot in the matrix
+    flightGraph.removeVertex("London");
+    std::cout << "Cities after London closes: ";
+    for (const auto &city : flightGraph.getVertices())
+    {
+        std::cout << city << ", ";
+    }
+    std::cout << "\nRoutes touching Paris: " << flightGraph.totalDegree("Paris") << "\n";
+
     return 0;
 }
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <string>
+#include "../include/GraphMatrix.h"
+#include "../include/Dijkstra.h"
+#include "../include/BFS.h"
+#include "../include/AllPairs.h"
+#include "../include/Reachability.h"
+
+using namespace Appledore;
+
+class Flight
+{
+public:
+    int distance;
+
+    Flight(int dis = 0) : distance(dis) {}
+
+    friend std::ostream &operator<<(std::ostream &os, const Flight &flight)
+    {
+        os << flight.distance << " miles";
+        return os;
+    }
+};
+
+int main()
+{
+    GraphMatrix<std::string, Flight, DirectedG> routes;
+
+    auto [LAX, JFK, DEN, ATL, SEA] = routes.addVertex(std::string("LAX"), std::string("JFK"), std::string("DEN"),
+                                                      std::string("ATL"), std::string("SEA"));
+
+    routes.addEdge(LAX, ATL, Flight(1945));
+    routes.addEdge(LAX, JFK, Flight(2475));
+    routes.addEdge(LAX, DEN, Flight(862));
+    routes.addEdge(JFK, ATL, Flight(761));
+    routes.addEdge(DEN, ATL, Flight(1199));
+    routes.addEdge(DEN, JFK, Flight(1631));
+    routes.addEdge(SEA, DEN, Flight(1021));
+
+    // Single source: every airport reachable from LAX, weighted by Flight::distance
+    auto fromLAX = dijkstra(routes, LAX, &Flight::distance);
+
+    std::cout << "Shortest distances from LAX:\n";
+    for (size_t index = 0; index < routes.getVertices().size(); ++index)
+    {
+        VertexHandle airport(index);
+        std::cout << routes.getVertex(airport) << ": ";
+        if (fromLAX.reached(airport))
+            std::cout << fromLAX.distance[index] << " miles\n";
+        else
+            std::cout << "unreachable\n";
+    }
+
+    // Point to point with the radix heap, the search stops once JFK is settled
+    DijkstraOptions options;
+    options.queue = PriorityQueue::RadixHeap;
+    auto toJFK = shortestPath(routes, SEA, JFK, &Flight::distance, options);
+
+    std::cout << "\nCheapest route SEA -> JFK (" << toJFK.distance[JFK.index] << " miles):\n";
+    for (VertexHandle airport : toJFK.pathTo(JFK))
+    {
+        std::cout << routes.getVertex(airport) << " -> ";
+    }
+    std::cout << "END\n";
+
+    // Hop counts: airports within 2 connections of SEA
+    BFSOptions hops;
+    hops.maxDepth = 2;
+    auto fromSEA = bfs(routes, SEA, hops);
+
+    std::cout << "\nWithin 2 flights of SEA:\n";
+    for (size_t index = 0; index < routes.getVertices().size(); ++index)
+    {
+        if (index != SEA.index && fromSEA.reached(VertexHandle(index)))
+            std::cout << routes.getVertices()[index] << " (" << fromSEA.level[index] << " flights)\n";
+    }
+
+    // Full distance table, tiled Floyd-Warshall
+    AllPairsOptions tableOptions;
+    tableOptions.nextHop = true;
+    auto table = allPairsShortestPaths(routes, &Flight::distance, tableOptions);
+
+    std::cout << "\nDistance table:\n";
+    for (size_t src = 0; src < table.vertexCount; ++src)
+    {
+        std::cout << routes.getVertices()[src] << ":";
+        for (size_t dest = 0; dest < table.vertexCount; ++dest)
+        {
+            if (table.reachable(VertexHandle(src), VertexHandle(dest)))
+                std::cout << " " << table.at(VertexHandle(src), VertexHandle(dest));
+            else
+                std::cout << " -";
+        }
+        std::cout << "\n";
+    }
+
+    std::cout << "\nSEA -> ATL via:";
+    for (VertexHandle airport : table.path(SEA, ATL))
+    {
+        std::cout << " " << routes.getVertex(airport);
+    }
+    std::cout << "\n";
+
+    // Yes/no reachability, answered from a prebuilt index instead of enumerating paths
+    ReachabilityIndex reach(routes);
+    std::cout << "\nSEA can reach ATL: " << (reach.reachable(SEA, ATL) ? "yes" : "no") << "\n";
+    std::cout << "ATL can reach SEA: " << (reach.reachable(ATL, SEA) ? "yes" : "no") << "\n";
+
+    return 0;
+}
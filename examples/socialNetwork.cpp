@@ -2,6 +2,7 @@
 #include <string>
 #include <set>
 #include "../include/GraphMatrix.h" 
+#include "../include/Triangles.h"
 
 // Custom edge type for friendship details
 class Friendship
@@ -85,5 +86,16 @@ int main()
     }
     std::cout << "Total No. of friends Alice has:" << socialGraph.totalDegree( "Alice");
 
+    // Bob and Charlie meet, closing two friend triangles
+    socialGraph.addEdge("Bob", "Charlie", Friendship{2023, "Gym Friends"});
+
+    auto triangles = Appledore::countTriangles(socialGraph);
+    std::cout << "\n\nFriend triangles: " << triangles.triangles << "\n";
+    for (size_t index = 0; index < socialGraph.getVertices().size(); ++index)
+    {
+        std::cout << socialGraph.getVertices()[index] << ": " << triangles.perVertex[index]
+                  << " triangles, clustering " << triangles.clustering[index] << "\n";
+    }
+
     return 0;
 }
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <functional>
+#include <algorithm>
+#include "GraphCommon.h"
+#include "Parallel.h"
+
+namespace Appledore
+{
+    struct AllPairsOptions
+    {
+        // Tile edge in vertices; three tiles should fit in L1/L2 (64 x 64 ints = 16 KB each).
+        size_t blockSize = 64;
+        // Threads for the row/column and remaining-tile phases, 0 = one per hardware thread.
+        unsigned threads = 1;
+        // Also record next hops so that path() can rebuild routes.
+        bool nextHop = false;
+    };
+
+    // Flat row-major all-pairs result, distance[src * vertexCount + dest].
+    template <typename Distance>
+    struct DistanceMatrix
+    {
+        static constexpr size_t noHop = static_cast<size_t>(-1);
+
+        size_t vertexCount = 0;
+        std::vector<Distance> distance;
+        // next[src * vertexCount + dest] is the vertex after src on a shortest route, noHop if
+        // dest is unreachable; empty unless AllPairsOptions::nextHop was set.
+        std::vector<size_t> next;
+
+        // Unreachable pairs hold infinity(); integer infinity is halved so that adding two of
+        // them in the min-plus kernel cannot overflow. Integer graphs whose paths could reach
+        // it are rejected by allPairsShortestPaths.
+        static constexpr Distance infinity()
+        {
+            if constexpr (std::numeric_limits<Distance>::has_infinity)
+                return std::numeric_limits<Distance>::infinity();
+            else
+                return std::numeric_limits<Distance>::max() / 2;
+        }
+
+        const Distance &at(VertexHandle src, VertexHandle dest) const
+        {
+            return distance[src.index * vertexCount + dest.index];
+        }
+
+        bool reachable(VertexHandle src, VertexHandle dest) const
+        {
+            return at(src, dest) != infinity();
+        }
+
+        // Vertices from src to dest, empty if unreachable. Requires next hops.
+        std::vector<VertexHandle> path(VertexHandle src, VertexHandle dest) const
+        {
+            if (next.empty())
+                throw std::logic_error("Next hops were not recorded, set AllPairsOptions::nextHop");
+
+            std::vector<VertexHandle> route;
+            if (!reachable(src, dest))
+                return route;
+            route.push_back(src);
+            for (size_t vertex = src.index; vertex != dest.index; vertex = next[vertex * vertexCount + dest.index])
+            {
+                route.emplace_back(next[vertex * vertexCount + dest.index]);
+            }
+            return route;
+        }
+    };
+
+    namespace detail
+    {
+        // Min-plus update of tile C by tiles A and B: C[i][j] = min(C[i][j], A[i][k] + B[k][j]).
+        // The j loop is a plain min of a broadcast plus a contiguous row, which compilers turn
+        // into SIMD min/add; rows where A[i][k] is infinite are skipped.
+        template <typename Distance>
+        void minPlusTile(Distance *c, const Distance *a, const Distance *b, size_t stride, size_t block, Distance infinity)
+        {
+            for (size_t k = 0; k < block; ++k)
+            {
+                const Distance *bRow = b + k * stride;
+                for (size_t i = 0; i < block; ++i)
+                {
+                    const Distance aik = a[i * stride + k];
+                    if (aik == infinity)
+                        continue;
+                    Distance *cRow = c + i * stride;
+                    for (size_t j = 0; j < block; ++j)
+                    {
+                        cRow[j] = std::min(cRow[j], aik + bRow[j]);
+                    }
+                }
+            }
+        }
+
+        // Same update, also copying the next hop toward k whenever a cell improves.
+        template <typename Distance>
+        void minPlusTileWithHops(Distance *c, const Distance *a, const Distance *b,
+                                 size_t *cHop, const size_t *aHop, size_t stride, size_t block, Distance infinity)
+        {
+            for (size_t k = 0; k < block; ++k)
+            {
+                const Distance *bRow = b + k * stride;
+                for (size_t i = 0; i < block; ++i)
+                {
+                    const Distance aik = a[i * stride + k];
+                    if (aik == infinity)
+                        continue;
+                    const size_t hop = aHop[i * stride + k];
+                    Distance *cRow = c + i * stride;
+                    size_t *hopRow = cHop + i * stride;
+                    for (size_t j = 0; j < block; ++j)
+                    {
+                        Distance candidate = aik + bRow[j];
+                        if (candidate < cRow[j])
+                        {
+                            cRow[j] = candidate;
+                            hopRow[j] = hop;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // All-pairs shortest paths by tiled Floyd-Warshall. For every diagonal tile the three phases
+    // run in order: the tile itself, then its row and column tiles, then all remaining tiles;
+    // the last two are spread over threads. Weights must be non-negative; with integer weights,
+    // every vertex's longest out-edge summed must stay below DistanceMatrix::infinity(), which
+    // bounds every shortest path, or std::invalid_argument is thrown.
+    // Graph needs getVertices() and forEachOutEdge (GraphMatrix, MixedGraphMatrix).
+    template <typename Graph, typename Weight = EdgeValue>
+    auto allPairsShortestPaths(const Graph &graph, const Weight &weight = {}, const AllPairsOptions &options = {})
+    {
+        using Edge = typename Graph::EdgeValueType;
+        using Distance = std::decay_t<std::invoke_result_t<const Weight &, const Edge &>>;
+        static_assert(std::is_arithmetic_v<Distance>, "the weight projection must yield an arithmetic type");
+        static_assert(!std::is_same_v<Distance, bool>, "a bool distance cannot tell 1 from unreachable, project bool edges to an integer");
+
+        if (options.blockSize == 0)
+            throw std::invalid_argument("Block size must be positive");
+
+        const Distance infinity = DistanceMatrix<Distance>::infinity();
+        const size_t vertexCount = graph.getVertices().size();
+        const size_t block = std::min(options.blockSize, std::max<size_t>(vertexCount, 1));
+        const size_t blocks = (vertexCount + block - 1) / block;
+        const size_t stride = blocks * block;
+        const bool withHops = options.nextHop;
+
+        // padded to whole tiles, padding rows/columns stay at infinity and never improve anything
+        std::vector<Distance> dist(stride * stride, infinity);
+        std::vector<size_t> hops(withHops ? stride * stride : 0, DistanceMatrix<Distance>::noHop);
+
+        // sum of every vertex's longest out-edge: no simple path is longer
+        [[maybe_unused]] Distance pathBound = Distance{};
+        for (size_t src = 0; src < vertexCount; ++src)
+        {
+            Distance longestOut = Distance{};
+            dist[src * stride + src] = Distance{};
+            if (withHops)
+                hops[src * stride + src] = src;
+
+            graph.forEachOutEdge(VertexHandle(src), [&](VertexHandle dest, const Edge &edge)
+                                 {
+                                     Distance length = static_cast<Distance>(std::invoke(weight, edge));
+                                     if constexpr (std::is_signed_v<Distance>)
+                                     {
+                                         if (length < Distance{})
+                                             throw std::invalid_argument("All-pairs shortest paths require non-negative edge weights");
+                                     }
+                                     longestOut = std::max(longestOut, length);
+                                     Distance &cell = dist[src * stride + dest.index];
+                                     if (length < cell)
+                                     {
+                                         cell = length;
+                                         if (withHops)
+                                             hops[src * stride + dest.index] = dest.index;
+                                     } });
+
+            if constexpr (std::is_integral_v<Distance>)
+            {
+                if (longestOut >= infinity - pathBound)
+                    throw std::invalid_argument("Edge weights are too large: path lengths could reach DistanceMatrix::infinity()");
+                pathBound += longestOut;
+            }
+        }
+
+        auto tile = [&](size_t row, size_t column)
+        {
+            return row * block * stride + column * block;
+        };
+        auto update = [&](size_t c, size_t a, size_t b)
+        {
+            if (withHops)
+                detail::minPlusTileWithHops(dist.data() + c, dist.data() + a, dist.data() + b,
+                                            hops.data() + c, hops.data() + a, stride, block, infinity);
+            else
+                detail::minPlusTile(dist.data() + c, dist.data() + a, dist.data() + b, stride, block, infinity);
+        };
+
+        for (size_t pivot = 0; pivot < blocks; ++pivot)
+        {
+            size_t diagonal = tile(pivot, pivot);
+            update(diagonal, diagonal, diagonal);
+
+            // item < blocks: row tile (pivot, item), otherwise column tile (item - blocks, pivot)
+            detail::parallelFor(2 * blocks, options.threads, [&](size_t item, unsigned)
+                                {
+                                    size_t other = item < blocks ? item : item - blocks;
+                                    if (other == pivot)
+                                        return;
+                                    if (item < blocks)
+                                        update(tile(pivot, other), diagonal, tile(pivot, other));
+                                    else
+                                        update(tile(other, pivot), tile(other, pivot), diagonal); });
+
+            detail::parallelFor(blocks, options.threads, [&](size_t row, unsigned)
+                                {
+                                    if (row == pivot)
+                                        return;
+                                    for (size_t column = 0; column < blocks; ++column)
+                                    {
+                                        if (column != pivot)
+                                            update(tile(row, column), tile(row, pivot), tile(pivot, column));
+                                    } });
+        }
+
+        DistanceMatrix<Distance> result;
+        result.vertexCount = vertexCount;
+        result.distance.resize(vertexCount * vertexCount);
+        if (withHops)
+            result.next.resize(vertexCount * vertexCount);
+        for (size_t row = 0; row < vertexCount; ++row)
+        {
+            std::copy_n(dist.begin() + row * stride, vertexCount, result.distance.begin() + row * vertexCount);
+            if (withHops)
+                std::copy_n(hops.begin() + row * stride, vertexCount, result.next.begin() + row * vertexCount);
+        }
+        return result;
+    }
+}
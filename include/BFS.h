@@ -0,0 +1,168 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include "GraphCommon.h"
+#include "Parallel.h"
+
+namespace Appledore
+{
+    enum class BFSDirection
+    {
+        // Switch between the two per level, see BFSOptions::alpha / beta.
+        Auto,
+        // Expand the out-edges of the frontier.
+        TopDown,
+        // Let every unvisited vertex look for a parent among its in-edges (column scans).
+        BottomUp
+    };
+
+    struct BFSOptions
+    {
+        // Stop after this many levels, e.g. 2 for "within 2 connections".
+        size_t maxDepth = std::numeric_limits<size_t>::max();
+        // Threads per level, 0 = one per hardware thread.
+        unsigned threads = 1;
+        BFSDirection direction = BFSDirection::Auto;
+        // Go bottom-up once frontier * alpha exceeds the unvisited vertices,
+        // back to top-down once frontier * beta drops below the vertex count.
+        double alpha = 14.0;
+        double beta = 24.0;
+    };
+
+    // Levels and BFS tree, indexed by VertexHandle::index.
+    struct BFSResult
+    {
+        static constexpr size_t unreached = static_cast<size_t>(-1);
+
+        // Hop count from the source, unreached for vertices not found.
+        std::vector<size_t> level;
+        // Parent in the BFS tree, an invalid handle for the source and unreached vertices.
+        std::vector<VertexHandle> parent;
+        // Deepest level reached.
+        size_t maxDepth = 0;
+
+        bool reached(VertexHandle vertex) const
+        {
+            return level[vertex.index] != unreached;
+        }
+    };
+
+    // Direction-optimizing breadth-first search over vertex indices.
+    // Graph needs getVertices(), forEachOutEdge and forEachInEdge (GraphMatrix, MixedGraphMatrix).
+    template <typename Graph>
+    BFSResult bfs(const Graph &graph, VertexHandle source, const BFSOptions &options = {})
+    {
+        constexpr size_t npos = BFSResult::unreached;
+        constexpr size_t chunk = 256;
+
+        size_t vertexCount = graph.getVertices().size();
+        if (source.index >= vertexCount)
+            throw std::invalid_argument("Vertex handle does not belong to the graph");
+
+        BFSResult result;
+        result.level.assign(vertexCount, npos);
+        result.level[source.index] = 0;
+
+        // the parent slot doubles as the visited flag, the source is its own parent while running
+        std::vector<std::atomic<size_t>> parent(vertexCount);
+        for (auto &slot : parent)
+        {
+            slot.store(npos, std::memory_order_relaxed);
+        }
+        parent[source.index].store(source.index, std::memory_order_relaxed);
+
+        std::vector<size_t> frontier{source.index};
+        std::vector<char> inFrontier(vertexCount, 0);
+        std::vector<std::vector<size_t>> next(detail::parallelWorkers(std::max<size_t>(1, (vertexCount + chunk - 1) / chunk), options.threads));
+        size_t unvisited = vertexCount - 1;
+        bool bottomUp = options.direction == BFSDirection::BottomUp;
+
+        for (size_t depth = 0; !frontier.empty() && depth < options.maxDepth; ++depth)
+        {
+            if (options.direction == BFSDirection::Auto)
+            {
+                if (!bottomUp && frontier.size() * options.alpha > unvisited)
+                    bottomUp = true;
+                else if (bottomUp && frontier.size() * options.beta < vertexCount)
+                    bottomUp = false;
+            }
+
+            for (auto &local : next)
+            {
+                local.clear();
+            }
+
+            if (bottomUp)
+            {
+                for (size_t vertex : frontier)
+                {
+                    inFrontier[vertex] = 1;
+                }
+
+                // each vertex is owned by exactly one chunk, so no claim is needed
+                detail::parallelFor((vertexCount + chunk - 1) / chunk, options.threads, [&](size_t item, unsigned worker)
+                                    {
+                                        size_t end = std::min(vertexCount, (item + 1) * chunk);
+                                        for (size_t vertex = item * chunk; vertex < end; ++vertex)
+                                        {
+                                            if (parent[vertex].load(std::memory_order_relaxed) != npos)
+                                                continue;
+                                            graph.forEachInEdge(VertexHandle(vertex), [&](VertexHandle src, const auto &)
+                                                                {
+                                                                    if (!inFrontier[src.index])
+                                                                        return true;
+                                                                    parent[vertex].store(src.index, std::memory_order_relaxed);
+                                                                    result.level[vertex] = depth + 1;
+                                                                    next[worker].push_back(vertex);
+                                                                    return false; });
+                                        } });
+
+                for (size_t vertex : frontier)
+                {
+                    inFrontier[vertex] = 0;
+                }
+            }
+            else
+            {
+                detail::parallelFor((frontier.size() + chunk - 1) / chunk, options.threads, [&](size_t item, unsigned worker)
+                                    {
+                                        size_t end = std::min(frontier.size(), (item + 1) * chunk);
+                                        for (size_t pos = item * chunk; pos < end; ++pos)
+                                        {
+                                            size_t vertex = frontier[pos];
+                                            graph.forEachOutEdge(VertexHandle(vertex), [&](VertexHandle dest, const auto &)
+                                                                 {
+                                                                     size_t expected = npos;
+                                                                     if (parent[dest.index].load(std::memory_order_relaxed) == npos &&
+                                                                         parent[dest.index].compare_exchange_strong(expected, vertex, std::memory_order_relaxed))
+                                                                     {
+                                                                         result.level[dest.index] = depth + 1;
+                                                                         next[worker].push_back(dest.index);
+                                                                     } });
+                                        } });
+            }
+
+            frontier.clear();
+            for (const auto &local : next)
+            {
+                frontier.insert(frontier.end(), local.begin(), local.end());
+            }
+            unvisited -= frontier.size();
+            if (!frontier.empty())
+                result.maxDepth = depth + 1;
+        }
+
+        result.parent.assign(vertexCount, VertexHandle());
+        for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            size_t index = parent[vertex].load(std::memory_order_relaxed);
+            if (index != npos && vertex != source.index)
+                result.parent[vertex] = VertexHandle(index);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+
+namespace Appledore
+{
+    namespace detail
+    {
+        // Slot a reader thread tries first, spread by thread id so readers rarely share a line.
+        inline size_t readerSlotHint()
+        {
+            thread_local size_t hint = std::hash<std::thread::id>{}(std::this_thread::get_id());
+            return hint;
+        }
+    }
+
+    // Read-mostly wrapper around any graph class: readers take an immutable snapshot without
+    // locks, one writer at a time applies a batch of mutations to a private copy and publishes
+    // it with a single pointer swap.
+    //
+    // Reclamation is epoch based. A reader announces the current epoch in its own cache line,
+    // then loads the published version. Publishing bumps the epoch, and a replaced version is
+    // freed once every announced epoch is newer than its retirement. Readers never wait or write
+    // shared lines, so read throughput scales with cores; a reader that holds a snapshot only
+    // delays freeing old versions.
+    //
+    // Every batch starts from a copy of the graph. With PagedEdges storage that copy shares the
+    // adjacency pages, and the batch clones only the 64-row pages it writes, plus the O(V)
+    // vertex arrays; any other storage copies the whole O(capacity^2) matrix per batch. Either
+    // way, group mutations into as few update() calls as the staleness you can accept allows.
+    template <typename Graph>
+    class ConcurrentGraph
+    {
+        struct Version
+        {
+            Graph graph;
+            uint64_t number;
+        };
+
+        struct alignas(64) ReaderSlot
+        {
+            // announced epoch, 0 while the slot is free
+            std::atomic<uint64_t> epoch{0};
+        };
+
+    public:
+        // Pinned, immutable view of one published version. Move-only; release it promptly,
+        // since no version replaced while it lives can be freed.
+        class Snapshot
+        {
+        public:
+            Snapshot(Snapshot &&other) noexcept
+                : slot(std::exchange(other.slot, nullptr)), version(other.version) {}
+
+            Snapshot &operator=(Snapshot &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    release();
+                    slot = std::exchange(other.slot, nullptr);
+                    version = other.version;
+                }
+                return *this;
+            }
+
+            Snapshot(const Snapshot &) = delete;
+            Snapshot &operator=(const Snapshot &) = delete;
+
+            ~Snapshot()
+            {
+                release();
+            }
+
+            const Graph &operator*() const
+            {
+                return version->graph;
+            }
+
+            const Graph *operator->() const
+            {
+                return &version->graph;
+            }
+
+            // Number of updates published before this snapshot, 0 for the initial graph.
+            uint64_t versionNumber() const
+            {
+                return version->number;
+            }
+
+        private:
+            friend class ConcurrentGraph;
+
+            ReaderSlot *slot;
+            const Version *version;
+
+            Snapshot(ReaderSlot *slot, const Version *version) : slot(slot), version(version) {}
+
+            void release()
+            {
+                if (slot)
+                    slot->epoch.store(0, std::memory_order_release);
+                slot = nullptr;
+            }
+        };
+
+        // readerSlots bounds how many snapshots can be held at once; further readers spin
+        // until a slot frees up. 0 picks four per hardware thread.
+        explicit ConcurrentGraph(Graph initial = Graph(), size_t readerSlots = 0)
+            : slots(std::max<size_t>(readerSlots ? readerSlots : 4 * std::max(1u, std::thread::hardware_concurrency()), 1))
+        {
+            current.store(new Version{std::move(initial), 0});
+        }
+
+        ConcurrentGraph(const ConcurrentGraph &) = delete;
+        ConcurrentGraph &operator=(const ConcurrentGraph &) = delete;
+
+        // Every snapshot must have been released.
+        ~ConcurrentGraph()
+        {
+            delete current.load();
+        }
+
+        // Lock-free: claims a reader slot, announces the epoch and loads the current version.
+        Snapshot snapshot() const
+        {
+            size_t start = detail::readerSlotHint();
+            for (size_t attempt = 0;; ++attempt)
+            {
+                ReaderSlot &slot = slots[(start + attempt) % slots.size()];
+                uint64_t idle = 0;
+                uint64_t announced = epoch.load();
+                if (slot.epoch.load(std::memory_order_relaxed) == 0 && slot.epoch.compare_exchange_strong(idle, announced))
+                {
+                    // seq_cst: either the writer's slot scan sees this announcement or this
+                    // load sees the version it published
+                    return Snapshot(&slot, current.load());
+                }
+                if (attempt % slots.size() == slots.size() - 1)
+                    std::this_thread::yield();
+            }
+        }
+
+        // Applies batch(Graph &) to a copy of the current version and publishes it; the copy
+        // shares PagedEdges pages with the current version until batch writes them. Writers are
+        // serialized; if batch throws, nothing is published and the exception propagates.
+        // Returns the new version number.
+        template <typename Fn>
+        uint64_t update(Fn &&batch)
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            const Version *previous = current.load();
+            std::unique_ptr<Version> next(new Version{previous->graph, previous->number + 1});
+            batch(next->graph);
+            uint64_t number = next->number;
+            // nothing may throw once the new version is visible
+            retired.reserve(retired.size() + 1);
+
+            current.store(next.release());
+            uint64_t retiredAt = epoch.fetch_add(1) + 1;
+            retired.emplace_back(retiredAt, std::unique_ptr<const Version>(previous));
+            collect();
+            return number;
+        }
+
+        // Frees replaced versions no snapshot can still reach, returns how many remain.
+        // update() does this itself; call it after long-lived snapshots are released.
+        size_t reclaim()
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            collect();
+            return retired.size();
+        }
+
+        uint64_t versionNumber() const
+        {
+            return current.load()->number;
+        }
+
+    private:
+        std::atomic<Version *> current{nullptr};
+        std::atomic<uint64_t> epoch{1};
+        mutable std::vector<ReaderSlot> slots;
+        std::mutex writerMutex;
+        // versions replaced by update(), with the epoch their replacement was published in
+        std::vector<std::pair<uint64_t, std::unique_ptr<const Version>>> retired;
+
+        // Caller holds writerMutex.
+        void collect()
+        {
+            uint64_t oldest = UINT64_MAX;
+            for (const ReaderSlot &slot : slots)
+            {
+                uint64_t announced = slot.epoch.load();
+                if (announced != 0)
+                    oldest = std::min(oldest, announced);
+            }
+            // a reader that announced an epoch at or past the retirement loaded the newer version
+            retired.erase(std::remove_if(retired.begin(), retired.end(), [&](const auto &entry)
+                                         { return entry.first <= oldest; }),
+                          retired.end());
+        }
+    };
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <limits>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include "GraphCommon.h"
+#include "MatrixStorage.h"
+
+namespace Appledore
+{
+    enum class PriorityQueue
+    {
+        // 4-ary heap, any ordered weight type.
+        DaryHeap,
+        // Monotone radix heap, integer weights only; O(1) push and amortized O(log C) pop.
+        RadixHeap
+    };
+
+    struct DijkstraOptions
+    {
+        PriorityQueue queue = PriorityQueue::DaryHeap;
+    };
+
+    // Result of a shortest path search, indexed by VertexHandle::index.
+    template <typename Distance>
+    struct ShortestPaths
+    {
+        VertexHandle source;
+        // distance[v] is infinity() for vertices the search did not reach. Integer path lengths
+        // saturate: a path as long as infinity() or longer counts as unreached.
+        std::vector<Distance> distance;
+        // predecessor[v] is the previous vertex on a shortest path, an invalid handle for the source
+        // and for unreached vertices.
+        std::vector<VertexHandle> predecessor;
+
+        static constexpr Distance infinity()
+        {
+            if constexpr (std::numeric_limits<Distance>::has_infinity)
+                return std::numeric_limits<Distance>::infinity();
+            else
+                return std::numeric_limits<Distance>::max();
+        }
+
+        bool reached(VertexHandle vertex) const
+        {
+            return distance[vertex.index] != infinity();
+        }
+
+        // Vertices from the source to target, empty if target was not reached.
+        std::vector<VertexHandle> pathTo(VertexHandle target) const
+        {
+            std::vector<VertexHandle> path;
+            if (!reached(target))
+                return path;
+            for (VertexHandle vertex = target; vertex != VertexHandle(); vertex = predecessor[vertex.index])
+            {
+                path.push_back(vertex);
+            }
+            std::reverse(path.begin(), path.end());
+            return path;
+        }
+    };
+
+    namespace detail
+    {
+        // Min-heap of (key, vertex) with Arity children per node; stale entries are skipped by the caller.
+        template <typename Key, size_t Arity = 4>
+        class DaryHeap
+        {
+        public:
+            bool empty() const
+            {
+                return heap.empty();
+            }
+
+            void push(const Key &key, size_t vertex)
+            {
+                heap.emplace_back(key, vertex);
+                size_t child = heap.size() - 1;
+                while (child > 0)
+                {
+                    size_t parent = (child - 1) / Arity;
+                    if (!(heap[child].first < heap[parent].first))
+                        break;
+                    std::swap(heap[child], heap[parent]);
+                    child = parent;
+                }
+            }
+
+            std::pair<Key, size_t> pop()
+            {
+                std::pair<Key, size_t> top = std::move(heap.front());
+                if (heap.size() > 1)
+                    heap.front() = std::move(heap.back());
+                heap.pop_back();
+
+                size_t parent = 0;
+                while (true)
+                {
+                    size_t first = parent * Arity + 1;
+                    if (first >= heap.size())
+                        break;
+                    size_t last = std::min(first + Arity, heap.size());
+                    size_t best = first;
+                    for (size_t child = first + 1; child < last; ++child)
+                    {
+                        if (heap[child].first < heap[best].first)
+                            best = child;
+                    }
+                    if (!(heap[best].first < heap[parent].first))
+                        break;
+                    std::swap(heap[best], heap[parent]);
+                    parent = best;
+                }
+                return top;
+            }
+
+        private:
+            std::vector<std::pair<Key, size_t>> heap;
+        };
+
+        // Monotone priority queue for unsigned keys: keys pushed are never below the last popped key.
+        // Bucket i holds keys whose highest bit differing from the last popped key is bit i - 1.
+        class RadixHeap
+        {
+        public:
+            bool empty() const
+            {
+                return count == 0;
+            }
+
+            void push(uint64_t key, size_t vertex)
+            {
+                buckets[bucketFor(key)].emplace_back(key, vertex);
+                count++;
+            }
+
+            std::pair<uint64_t, size_t> pop()
+            {
+                if (buckets[0].empty())
+                {
+                    size_t bucket = 1;
+                    while (buckets[bucket].empty())
+                    {
+                        ++bucket;
+                    }
+
+                    last = buckets[bucket].front().first;
+                    for (const auto &entry : buckets[bucket])
+                    {
+                        last = std::min(last, entry.first);
+                    }
+                    for (const auto &entry : buckets[bucket])
+                    {
+                        buckets[bucketFor(entry.first)].push_back(entry);
+                    }
+                    buckets[bucket].clear();
+                }
+
+                std::pair<uint64_t, size_t> top = buckets[0].back();
+                buckets[0].pop_back();
+                count--;
+                return top;
+            }
+
+        private:
+            std::array<std::vector<std::pair<uint64_t, size_t>>, 65> buckets;
+            uint64_t last = 0;
+            size_t count = 0;
+
+            size_t bucketFor(uint64_t key) const
+            {
+                return bitWidth64(key ^ last);
+            }
+        };
+
+        template <typename Distance, typename Queue, typename Graph, typename Weight>
+        ShortestPaths<Distance> runDijkstra(const Graph &graph, VertexHandle source, VertexHandle target, const Weight &weight)
+        {
+            size_t vertexCount = graph.getVertices().size();
+            if (source.index >= vertexCount || (target != VertexHandle() && target.index >= vertexCount))
+                throw std::invalid_argument("Vertex handle does not belong to the graph");
+
+            ShortestPaths<Distance> result;
+            result.source = source;
+            result.distance.assign(vertexCount, ShortestPaths<Distance>::infinity());
+            result.predecessor.assign(vertexCount, VertexHandle());
+            std::vector<bool> settled(vertexCount, false);
+
+            Queue queue;
+            result.distance[source.index] = Distance{};
+            queue.push(Distance{}, source.index);
+
+            while (!queue.empty())
+            {
+                auto top = queue.pop();
+                Distance distance = static_cast<Distance>(top.first);
+                size_t vertex = top.second;
+                if (settled[vertex])
+                    continue;
+                settled[vertex] = true;
+                if (vertex == target.index)
+                    break;
+
+                graph.forEachOutEdge(VertexHandle(vertex), [&](VertexHandle dest, const auto &edge)
+                                     {
+                                         Distance length = static_cast<Distance>(std::invoke(weight, edge));
+                                         if constexpr (std::is_signed_v<Distance>)
+                                         {
+                                             if (length < Distance{})
+                                                 throw std::invalid_argument("Dijkstra requires non-negative edge weights");
+                                         }
+                                         if constexpr (std::is_integral_v<Distance>)
+                                         {
+                                             // distance + length would reach infinity() or overflow
+                                             if (length >= ShortestPaths<Distance>::infinity() - distance)
+                                                 return;
+                                         }
+                                         Distance candidate = distance + length;
+                                         if (candidate < result.distance[dest.index])
+                                         {
+                                             result.distance[dest.index] = candidate;
+                                             result.predecessor[dest.index] = VertexHandle(vertex);
+                                             queue.push(candidate, dest.index);
+                                         } });
+            }
+            return result;
+        }
+
+        template <typename Graph, typename Weight>
+        auto dijkstraWith(const Graph &graph, VertexHandle source, VertexHandle target, const Weight &weight, const DijkstraOptions &options)
+        {
+            using Edge = typename Graph::EdgeValueType;
+            using Distance = std::decay_t<std::invoke_result_t<const Weight &, const Edge &>>;
+            static_assert(std::is_arithmetic_v<Distance>, "the weight projection must yield an arithmetic type");
+            static_assert(!std::is_same_v<Distance, bool>, "a bool distance cannot tell 1 from unreached, project bool edges to an integer");
+
+            if (options.queue == PriorityQueue::RadixHeap)
+            {
+                if constexpr (std::is_integral_v<Distance>)
+                    return runDijkstra<Distance, RadixHeap>(graph, source, target, weight);
+                else
+                    throw std::invalid_argument("RadixHeap requires integer edge weights");
+            }
+            return runDijkstra<Distance, DaryHeap<Distance>>(graph, source, target, weight);
+        }
+    }
+
+    // Single-source shortest paths from source over every outgoing edge.
+    // weight maps an edge value to its length, e.g. &Flight::distance or a lambda.
+    template <typename Graph, typename Weight = EdgeValue>
+    auto dijkstra(const Graph &graph, VertexHandle source, const Weight &weight = {}, const DijkstraOptions &options = {})
+    {
+        return detail::dijkstraWith(graph, source, VertexHandle(), weight, options);
+    }
+
+    // Point-to-point search, stops as soon as target is settled; only target's distance and
+    // path are final in the result.
+    template <typename Graph, typename Weight = EdgeValue>
+    auto shortestPath(const Graph &graph, VertexHandle source, VertexHandle target, const Weight &weight = {}, const DijkstraOptions &options = {})
+    {
+        return detail::dijkstraWith(graph, source, target, weight, options);
+    }
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <tuple>
+#include <utility>
+#include <iterator>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include "GraphCommon.h"
+#include "Parallel.h"
+
+namespace Appledore
+{
+    // Outcome of one item of addEdges/removeEdges/updateEdges, in input order.
+    enum class BatchStatus : uint8_t
+    {
+        Applied,
+        // an endpoint is not in the graph (or a handle is out of range); nothing was written
+        MissingVertex,
+        // removeEdges/updateEdges on an edge that does not exist at that point of the batch
+        MissingEdge
+    };
+
+    struct BatchOptions
+    {
+        // Threads over matrix rows, 0 = one per hardware thread. Storages whose cells share
+        // state across rows (PooledEdges, TriangularEdges, PagedEdges) always apply serially.
+        unsigned threads = 1;
+    };
+
+    namespace detail
+    {
+        enum class BatchKind
+        {
+            Add,
+            Remove,
+            Update
+        };
+
+        template <typename Range>
+        using BatchItem = std::remove_cv_t<std::remove_reference_t<decltype(*std::begin(std::declval<const Range &>()))>>;
+
+        // One cell write of a batch item; undirected items also write their mirror cell.
+        struct CellOp
+        {
+            size_t row;
+            size_t column;
+            size_t item;
+            bool mirror;
+        };
+
+        // Resolves a batch endpoint: a VertexHandle is range checked, anything else is looked up.
+        template <typename Key, typename Find>
+        size_t batchEndpoint(const Key &key, size_t vertexCount, Find &&find)
+        {
+            if constexpr (std::is_same_v<std::decay_t<Key>, VertexHandle>)
+                return key.index < vertexCount ? key.index : static_cast<size_t>(-1);
+            else
+                return find(key);
+        }
+
+        // Collects the items of a batch and resolves both endpoints of each, in parallel since
+        // lookups only read the vertex index. Items with a missing endpoint get MissingVertex.
+        template <typename Range, typename Find>
+        auto resolveBatch(const Range &range, size_t vertexCount, unsigned threads, Find &&find,
+                          std::vector<std::pair<size_t, size_t>> &endpoints, std::vector<BatchStatus> &status)
+        {
+            using Item = std::remove_reference_t<decltype(*std::begin(range))>;
+            std::vector<Item *> items;
+            for (auto &item : range)
+            {
+                items.push_back(&item);
+            }
+
+            constexpr size_t chunk = 4096;
+            endpoints.resize(items.size());
+            status.assign(items.size(), BatchStatus::Applied);
+            parallelFor((items.size() + chunk - 1) / chunk, threads, [&](size_t block, unsigned)
+                        {
+                            size_t end = std::min(items.size(), (block + 1) * chunk);
+                            for (size_t item = block * chunk; item < end; ++item)
+                            {
+                                size_t src = batchEndpoint(std::get<0>(*items[item]), vertexCount, find);
+                                size_t dest = batchEndpoint(std::get<1>(*items[item]), vertexCount, find);
+                                endpoints[item] = {src, dest};
+                                if (src == static_cast<size_t>(-1) || dest == static_cast<size_t>(-1))
+                                    status[item] = BatchStatus::MissingVertex;
+                            } });
+            return items;
+        }
+
+        // Runs fn(op, worker) for every op. Ops are bucketed by row with a stable counting
+        // sort, so each cell sees its ops in input order, and contiguous row ranges of about
+        // equal work go to the workers: no cell, and no row of a row-padded bitmap, is written
+        // by two threads. worker stays below parallelWorkers(ops.size(), threads).
+        template <typename Fn>
+        void applyByRow(const std::vector<CellOp> &ops, size_t rows, unsigned threads, Fn &&fn)
+        {
+            size_t workers = parallelWorkers(ops.size(), threads);
+            if (workers <= 1)
+            {
+                for (const CellOp &op : ops)
+                {
+                    fn(op, 0u);
+                }
+                return;
+            }
+
+            std::vector<size_t> rowStart(rows + 1, 0);
+            for (const CellOp &op : ops)
+            {
+                rowStart[op.row + 1]++;
+            }
+            for (size_t row = 0; row < rows; ++row)
+            {
+                rowStart[row + 1] += rowStart[row];
+            }
+            std::vector<size_t> order(ops.size());
+            {
+                std::vector<size_t> fill(rowStart.begin(), rowStart.end() - 1);
+                for (size_t op = 0; op < ops.size(); ++op)
+                {
+                    order[fill[ops[op].row]++] = op;
+                }
+            }
+
+            // row blocks of roughly ops / (4 * workers) ops each, cut at row boundaries
+            size_t target = std::max<size_t>(1, ops.size() / (4 * workers));
+            std::vector<size_t> blockRows{0};
+            for (size_t row = 0; row < rows; ++row)
+            {
+                if (rowStart[row + 1] - rowStart[blockRows.back()] >= target)
+                    blockRows.push_back(row + 1);
+            }
+            if (blockRows.back() != rows)
+                blockRows.push_back(rows);
+
+            // the tail block may hold no ops, so blocks can outnumber ops: cap the workers here
+            parallelFor(blockRows.size() - 1, static_cast<unsigned>(workers), [&](size_t block, unsigned worker)
+                        {
+                            for (size_t pos = rowStart[blockRows[block]]; pos < rowStart[blockRows[block + 1]]; ++pos)
+                            {
+                                fn(ops[order[pos]], worker);
+                            } });
+        }
+
+        // Edge value of a batch item: the third field, or a default value for (src, dest) items.
+        template <typename EdgeType, typename Item>
+        EdgeType batchValue(const Item &item)
+        {
+            if constexpr (std::tuple_size_v<std::remove_cv_t<Item>> >= 3)
+                return EdgeType(std::get<2>(item));
+            else
+                return EdgeType();
+        }
+    }
+}
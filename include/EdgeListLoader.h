@@ -0,0 +1,357 @@
+#pragma once
+
+#include <array>
+#include <queue>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <algorithm>
+#include "GraphCommon.h"
+#include "Serialization.h"
+#include "Parallel.h"
+
+namespace Appledore
+{
+    struct EdgeListOptions
+    {
+        // Field separator; spaces and tabs around fields are ignored.
+        char delimiter = ',';
+        // Skip the first line (column names).
+        bool header = false;
+        // Threads for parsing and interning, 0 = one per hardware thread.
+        unsigned threads = 1;
+        // Target chunk size; the file is cut at the first line break after each boundary.
+        size_t chunkBytes = size_t(4) << 20;
+    };
+
+    // Where the time went, for throughput reporting.
+    struct EdgeListStats
+    {
+        size_t bytes = 0;
+        size_t edges = 0;
+        size_t vertices = 0;
+        size_t chunks = 0;
+        unsigned threads = 1;
+        // map the file, parse every line and intern its vertex keys
+        double parseSeconds = 0.0;
+        // order the interned keys and rewrite edge endpoints as vertex indices
+        double indexSeconds = 0.0;
+        // add vertices and edges to the graph
+        double buildSeconds = 0.0;
+        double totalSeconds = 0.0;
+
+        double megabytesPerSecond() const
+        {
+            return totalSeconds > 0 ? bytes / (1024.0 * 1024.0) / totalSeconds : 0.0;
+        }
+
+        double edgesPerSecond() const
+        {
+            return totalSeconds > 0 ? edges / totalSeconds : 0.0;
+        }
+    };
+
+    namespace detail
+    {
+        // Keys while parsing: numbers as parsed, strings as views into the mapped file.
+        template <typename VertexType>
+        using ParseKey = std::conditional_t<std::is_arithmetic_v<VertexType>, VertexType, std::string_view>;
+
+        // Key -> id table split into shards with one lock each, so threads rarely contend.
+        // Ids are (shard << 32) | position-in-shard until finalIds() ranks the keys.
+        template <typename Key>
+        class ShardedInterner
+        {
+        public:
+            static constexpr size_t shardCount = 64;
+
+            uint64_t intern(const Key &key)
+            {
+                size_t shard = (std::hash<Key>{}(key) * 0x9E3779B97F4A7C15ull) >> 58;
+                Shard &target = shards[shard];
+                std::lock_guard<std::mutex> lock(target.mutex);
+                auto [it, inserted] = target.ids.emplace(key, static_cast<uint32_t>(target.keys.size()));
+                if (inserted)
+                {
+                    if (target.keys.size() == UINT32_MAX)
+                        throw std::length_error("Too many vertices in one interning shard");
+                    target.keys.push_back(key);
+                }
+                return (uint64_t(shard) << 32) | it->second;
+            }
+
+            // Sorts every shard in parallel and merges them, so vertex indices follow key order
+            // whatever the thread count. Returns the keys in index order and fills remap[shard]
+            // with the index of every interned position.
+            std::vector<Key> finalIds(unsigned threads, std::array<std::vector<size_t>, shardCount> &remap)
+            {
+                std::array<std::vector<uint32_t>, shardCount> order;
+                parallelFor(shardCount, threads, [&](size_t shard, unsigned)
+                            {
+                                const std::vector<Key> &keys = shards[shard].keys;
+                                order[shard].resize(keys.size());
+                                for (uint32_t local = 0; local < keys.size(); ++local)
+                                {
+                                    order[shard][local] = local;
+                                }
+                                std::sort(order[shard].begin(), order[shard].end(), [&](uint32_t a, uint32_t b)
+                                          { return keys[a] < keys[b]; });
+                                remap[shard].assign(keys.size(), 0); });
+
+                // k-way merge of the sorted shards
+                using Head = std::pair<size_t, size_t>; // shard, position in order[shard]
+                auto after = [&](const Head &a, const Head &b)
+                {
+                    return shards[b.first].keys[order[b.first][b.second]] < shards[a.first].keys[order[a.first][a.second]];
+                };
+                std::priority_queue<Head, std::vector<Head>, decltype(after)> heads(after);
+                size_t total = 0;
+                for (size_t shard = 0; shard < shardCount; ++shard)
+                {
+                    total += order[shard].size();
+                    if (!order[shard].empty())
+                        heads.push({shard, 0});
+                }
+
+                std::vector<Key> sorted;
+                sorted.reserve(total);
+                while (!heads.empty())
+                {
+                    Head head = heads.top();
+                    heads.pop();
+                    uint32_t local = order[head.first][head.second];
+                    remap[head.first][local] = sorted.size();
+                    sorted.push_back(shards[head.first].keys[local]);
+                    if (++head.second < order[head.first].size())
+                        heads.push(head);
+                }
+                return sorted;
+            }
+
+        private:
+            struct Shard
+            {
+                std::mutex mutex;
+                std::unordered_map<Key, uint32_t> ids;
+                std::vector<Key> keys;
+            };
+
+            std::array<Shard, shardCount> shards;
+        };
+
+        template <typename Number>
+        bool parseNumber(std::string_view text, Number &value)
+        {
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc() && end == text.data() + text.size();
+        }
+
+        // Next field of a line starting at pos, trimmed of spaces and tabs; pos moves past the
+        // delimiter. Returns false when the line has no more fields.
+        inline bool nextField(std::string_view line, size_t &pos, char delimiter, std::string_view &field)
+        {
+            auto blank = [](char c)
+            {
+                return c == ' ' || c == '\t';
+            };
+            while (pos < line.size() && blank(line[pos]) && line[pos] != delimiter)
+            {
+                ++pos;
+            }
+            if (pos >= line.size())
+                return false;
+
+            size_t end = line.find(delimiter, pos);
+            if (end == std::string_view::npos)
+                end = line.size();
+            size_t last = end;
+            while (last > pos && blank(line[last - 1]))
+            {
+                --last;
+            }
+            field = line.substr(pos, last - pos);
+            pos = end < line.size() ? end + 1 : end;
+            return true;
+        }
+    }
+
+    // Builds a Graph from a text edge list with one `src<delimiter>dest[<delimiter>weight]` per line.
+    // Blank lines and lines starting with '#' are skipped. The file is memory-mapped and cut
+    // into line-aligned chunks; threads parse chunks with std::from_chars and intern vertex
+    // keys into sharded tables. Vertices are then numbered in key order and the graph is built
+    // in one pass, sized up front, with edges added by handle in file order (a repeated edge
+    // keeps its last weight).
+    //
+    // Graph::VertexValueType must be arithmetic or constructible from std::string_view, and
+    // Graph::EdgeValueType arithmetic (the weight column) or UnweightedG (no weight column).
+    // Works with GraphMatrix, MixedGraphMatrix (edges are undirected) and GraphCSR.
+    template <typename Graph>
+    Graph loadEdgeList(const std::string &path, const EdgeListOptions &options = {}, EdgeListStats *stats = nullptr)
+    {
+        using VertexType = typename Graph::VertexValueType;
+        using EdgeType = typename Graph::EdgeValueType;
+        using Key = detail::ParseKey<VertexType>;
+        constexpr bool weighted = !std::is_same_v<EdgeType, UnweightedG>;
+        static_assert(std::is_arithmetic_v<VertexType> || std::is_constructible_v<VertexType, std::string_view>,
+                      "edge list vertices must be numbers or strings");
+        static_assert(!weighted || std::is_arithmetic_v<EdgeType>, "edge list weights must be numbers");
+
+        struct ParsedEdge
+        {
+            uint64_t src;
+            uint64_t dest;
+            EdgeType value;
+        };
+
+        using Clock = std::chrono::steady_clock;
+        auto seconds = [](Clock::time_point from)
+        {
+            return std::chrono::duration<double>(Clock::now() - from).count();
+        };
+        const auto start = Clock::now();
+
+        MappedFile file(path);
+        const char *data = file.data();
+        const size_t size = file.size();
+
+        size_t begin = 0;
+        if (options.header)
+        {
+            const char *newline = size ? static_cast<const char *>(std::memchr(data, '\n', size)) : nullptr;
+            begin = newline ? static_cast<size_t>(newline - data) + 1 : size;
+        }
+
+        // line-aligned chunk boundaries
+        const size_t chunkBytes = std::max<size_t>(options.chunkBytes, 1);
+        std::vector<size_t> bounds{begin};
+        while (bounds.back() < size)
+        {
+            size_t next = std::min(size, bounds.back() + chunkBytes);
+            const char *newline = next < size ? static_cast<const char *>(std::memchr(data + next, '\n', size - next)) : nullptr;
+            bounds.push_back(newline ? static_cast<size_t>(newline - data) + 1 : size);
+        }
+        const size_t chunks = bounds.size() - 1;
+
+        detail::ShardedInterner<Key> interner;
+        std::vector<std::vector<ParsedEdge>> parsed(chunks);
+        // per-worker caches of recently seen keys skip the shard locks for hot vertices
+        std::vector<std::unordered_map<Key, uint64_t>> caches(detail::parallelWorkers(chunks, options.threads));
+        constexpr size_t cacheLimit = size_t(1) << 16;
+
+        detail::parallelFor(chunks, options.threads, [&](size_t chunk, unsigned worker)
+                            {
+                                auto &cache = caches[worker];
+                                auto intern = [&](std::string_view field, size_t at)
+                                {
+                                    Key key;
+                                    if constexpr (std::is_arithmetic_v<VertexType>)
+                                    {
+                                        if (!detail::parseNumber(field, key))
+                                            throw std::runtime_error("Malformed vertex in edge list at byte " + std::to_string(at));
+                                    }
+                                    else
+                                    {
+                                        key = field;
+                                    }
+                                    auto cached = cache.find(key);
+                                    if (cached != cache.end())
+                                        return cached->second;
+                                    if (cache.size() >= cacheLimit)
+                                        cache.clear();
+                                    uint64_t id = interner.intern(key);
+                                    cache.emplace(key, id);
+                                    return id;
+                                };
+
+                                auto &edges = parsed[chunk];
+                                size_t pos = bounds[chunk];
+                                const size_t end = bounds[chunk + 1];
+                                while (pos < end)
+                                {
+                                    const char *newline = static_cast<const char *>(std::memchr(data + pos, '\n', end - pos));
+                                    size_t lineEnd = newline ? static_cast<size_t>(newline - data) : end;
+                                    std::string_view line(data + pos, lineEnd - pos);
+                                    size_t lineStart = pos;
+                                    pos = lineEnd + 1;
+
+                                    if (!line.empty() && line.back() == '\r')
+                                        line.remove_suffix(1);
+                                    size_t cursor = 0;
+                                    std::string_view srcField, destField, weightField;
+                                    if (!detail::nextField(line, cursor, options.delimiter, srcField) || srcField.empty() || srcField[0] == '#')
+                                        continue;
+                                    if (!detail::nextField(line, cursor, options.delimiter, destField) ||
+                                        (weighted && !detail::nextField(line, cursor, options.delimiter, weightField)))
+                                        throw std::runtime_error("Malformed edge list line at byte " + std::to_string(lineStart));
+
+                                    ParsedEdge edge{intern(srcField, lineStart), intern(destField, lineStart), EdgeType()};
+                                    if constexpr (weighted)
+                                    {
+                                        if (!detail::parseNumber(weightField, edge.value))
+                                            throw std::runtime_error("Malformed weight in edge list at byte " + std::to_string(lineStart));
+                                    }
+                                    edges.push_back(edge);
+                                } });
+        caches.clear();
+
+        const auto indexStart = Clock::now();
+        std::array<std::vector<size_t>, detail::ShardedInterner<Key>::shardCount> remap;
+        std::vector<Key> keys = interner.finalIds(options.threads, remap);
+        size_t edgeCount = 0;
+        for (const auto &edges : parsed)
+        {
+            edgeCount += edges.size();
+        }
+        detail::parallelFor(chunks, options.threads, [&](size_t chunk, unsigned)
+                            {
+                                for (ParsedEdge &edge : parsed[chunk])
+                                {
+                                    edge.src = remap[edge.src >> 32][edge.src & UINT32_MAX];
+                                    edge.dest = remap[edge.dest >> 32][edge.dest & UINT32_MAX];
+                                } });
+        const double indexSeconds = seconds(indexStart);
+
+        const auto buildStart = Clock::now();
+        Graph graph;
+        if constexpr (detail::HasReserveVertices<Graph>::value)
+            graph.reserveVertices(keys.size());
+        for (const Key &key : keys)
+        {
+            graph.addVertex(VertexType(key));
+        }
+        if constexpr (detail::HasReserveEdges<Graph>::value)
+            graph.reserveEdges(edgeCount);
+        for (auto &edges : parsed)
+        {
+            for (const ParsedEdge &edge : edges)
+            {
+                graph.addEdge(VertexHandle(static_cast<size_t>(edge.src)), VertexHandle(static_cast<size_t>(edge.dest)), edge.value);
+            }
+            std::vector<ParsedEdge>().swap(edges);
+        }
+        if constexpr (detail::HasFinalize<Graph>::value)
+            graph.finalize();
+
+        if (stats)
+        {
+            stats->bytes = size;
+            stats->edges = edgeCount;
+            stats->vertices = keys.size();
+            stats->chunks = chunks;
+            stats->threads = static_cast<unsigned>(detail::parallelWorkers(chunks, options.threads));
+            stats->parseSeconds = std::chrono::duration<double>(indexStart - start).count();
+            stats->indexSeconds = indexSeconds;
+            stats->buildSeconds = seconds(buildStart);
+            stats->totalSeconds = seconds(start);
+        }
+        return graph;
+    }
+}
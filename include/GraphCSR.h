@@ -0,0 +1,417 @@
+#pragma once
+
+#include <vector>
+#include <stdexcept>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <set>
+#include <numeric>
+#include "GraphMatrix.h"
+
+namespace Appledore
+{
+    // GraphCSR class template
+    // Compressed sparse row storage: memory is O(V + E) and neighbor scans are O(degree).
+    // Vertices and edges are staged with addVertex/addEdge and compacted by finalize();
+    // queries require a finalized graph.
+    template <typename VertexType, typename EdgeType, typename Direction>
+    class GraphCSR
+    {
+    public:
+        using VertexValueType = VertexType;
+        using EdgeValueType = EdgeType;
+        using DirectionTag = Direction;
+
+        GraphCSR()
+            : isDirected(std::is_same_v<Direction, DirectedG>) {}
+
+        template <typename... Vertices>
+        void addVertex(Vertices &&...vertices)
+        {
+            auto add_single_vertex = [this](const VertexType &vertex)
+            {
+                if (vertexToIndex.count(vertex))
+                    return;
+                size_t newIndex = indexToVertex.size();
+                vertexToIndex[vertex] = newIndex;
+                indexToVertex.push_back(vertex);
+            };
+
+            (add_single_vertex(std::forward<Vertices>(vertices)), ...);
+
+            finalized = false;
+        }
+
+        // for weighted.
+        void addEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge)
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+                throw std::invalid_argument("One or both vertices do not exist");
+
+            pendingEdges.push_back({vertexToIndex.at(src), vertexToIndex.at(dest), edge});
+            finalized = false;
+        }
+
+        // Handles index getVertices() in insertion order; no vertex lookups, for bulk loads.
+        void addEdge(VertexHandle src, VertexHandle dest, const EdgeType &edge)
+        {
+            if (src.index >= indexToVertex.size() || dest.index >= indexToVertex.size())
+                throw std::invalid_argument("Vertex handle does not belong to the graph");
+
+            pendingEdges.push_back({src.index, dest.index, edge});
+            finalized = false;
+        }
+
+        // for unweighted
+        void addEdge(const VertexType &src, const VertexType &dest)
+        {
+            addEdge(src, dest, EdgeType());
+        }
+
+        // Reserve room for the staged edges before a bulk load.
+        void reserveEdges(size_t count)
+        {
+            pendingEdges.reserve(count);
+        }
+
+        // Compact the staged edges into the CSR arrays.
+        // Edges added after a previous finalize() are merged in; a repeated (src, dest)
+        // pair keeps the value that was added last, as GraphMatrix::addEdge overwrites.
+        void finalize()
+        {
+            if (finalized)
+                return;
+
+            size_t numVertices = indexToVertex.size();
+            std::vector<PendingEdge> staged;
+            staged.reserve(targets.size() + pendingEdges.size() * (isDirected ? 1 : 2));
+
+            // existing edges go first so that newer values win on duplicates
+            for (size_t srcIndex = 0; srcIndex + 1 < offsets.size(); ++srcIndex)
+            {
+                for (size_t pos = offsets[srcIndex]; pos < offsets[srcIndex + 1]; ++pos)
+                {
+                    staged.push_back({srcIndex, targets[pos], std::move(values[pos])});
+                }
+            }
+            for (auto &edge : pendingEdges)
+            {
+                if (!isDirected && edge.src != edge.dest)
+                {
+                    staged.push_back({edge.dest, edge.src, edge.value});
+                }
+                staged.push_back(std::move(edge));
+            }
+            pendingEdges.clear();
+            pendingEdges.shrink_to_fit();
+
+            // counting sort by source, stable so insertion order survives within a row
+            std::vector<size_t> rowStart(numVertices + 1, 0);
+            for (const auto &edge : staged)
+            {
+                rowStart[edge.src + 1]++;
+            }
+            std::partial_sum(rowStart.begin(), rowStart.end(), rowStart.begin());
+
+            std::vector<size_t> order(staged.size());
+            std::vector<size_t> cursor(rowStart.begin(), rowStart.end() - 1);
+            for (size_t i = 0; i < staged.size(); ++i)
+            {
+                order[cursor[staged[i].src]++] = i;
+            }
+
+            offsets.assign(numVertices + 1, 0);
+            targets.clear();
+            values.clear();
+            targets.reserve(staged.size());
+            values.reserve(staged.size());
+
+            for (size_t srcIndex = 0; srcIndex < numVertices; ++srcIndex)
+            {
+                auto rowBegin = order.begin() + rowStart[srcIndex];
+                auto rowEnd = order.begin() + rowStart[srcIndex + 1];
+                std::stable_sort(rowBegin, rowEnd, [&staged](size_t a, size_t b)
+                                 { return staged[a].dest < staged[b].dest; });
+
+                for (auto it = rowBegin; it != rowEnd; ++it)
+                {
+                    // keep only the last of a run of duplicates
+                    if (it + 1 != rowEnd && staged[*(it + 1)].dest == staged[*it].dest)
+                        continue;
+                    targets.push_back(staged[*it].dest);
+                    values.push_back(std::move(staged[*it].value));
+                }
+                offsets[srcIndex + 1] = targets.size();
+            }
+            targets.shrink_to_fit();
+            values.shrink_to_fit();
+
+            inDegrees.assign(numVertices, 0);
+            for (size_t destIndex : targets)
+            {
+                inDegrees[destIndex]++;
+            }
+
+            finalized = true;
+        }
+
+        bool isFinalized() const
+        {
+            return finalized;
+        }
+
+        bool operator()(const VertexType &src, const VertexType &dest) const
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            {
+                return false;
+            }
+            requireFinalized();
+            return findEdge(vertexToIndex.at(src), vertexToIndex.at(dest)) != npos;
+        }
+
+        // Check if edge exists
+        bool hasEdge(const VertexType &src, const VertexType &dest) const
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+                throw std::invalid_argument("One or both vertices do not exist");
+            requireFinalized();
+
+            return findEdge(vertexToIndex.at(src), vertexToIndex.at(dest)) != npos;
+        }
+
+        // Get vertices
+        const std::vector<VertexType> &getVertices() const
+        {
+            return indexToVertex;
+        }
+
+        const EdgeType &getEdge(const VertexType &src, const VertexType &dest) const
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            {
+                throw std::invalid_argument("One or both vertices do not exist!");
+            }
+            requireFinalized();
+
+            size_t pos = findEdge(vertexToIndex.at(src), vertexToIndex.at(dest));
+            if (pos == npos)
+            {
+                throw std::runtime_error("No Edge exists between the given vertices.");
+            }
+            return values[pos];
+        }
+
+        // Get all edges
+        std::vector<std::tuple<VertexType, VertexType, EdgeType>> getAllEdges() const
+        {
+            requireFinalized();
+            std::vector<std::tuple<VertexType, VertexType, EdgeType>> edges;
+            edges.reserve(targets.size());
+
+            for (size_t srcIndex = 0; srcIndex < indexToVertex.size(); ++srcIndex)
+            {
+                for (size_t pos = offsets[srcIndex]; pos < offsets[srcIndex + 1]; ++pos)
+                {
+                    edges.emplace_back(indexToVertex[srcIndex], indexToVertex[targets[pos]], values[pos]);
+                }
+            }
+            return edges;
+        }
+
+        // Number of stored adjacency entries (undirected edges count once per direction).
+        size_t edgeCount() const
+        {
+            requireFinalized();
+            return targets.size();
+        }
+
+        // Get indegree for a vertex, undirected graphs return the total degree like GraphMatrix.
+        [[nodiscard]] size_t indegree(const VertexType &vertex) const
+        {
+            size_t vertexIndex = requireVertex(vertex);
+            if (!isDirected)
+                return rowLength(vertexIndex);
+            return inDegrees[vertexIndex];
+        }
+
+        // Get outdegree for a vertex, undirected graphs return the total degree like GraphMatrix.
+        [[nodiscard]] size_t outdegree(const VertexType &vertex) const
+        {
+            return rowLength(requireVertex(vertex));
+        }
+
+        // Get totalDegree for a vertex
+        [[nodiscard]] size_t totalDegree(const VertexType &vertex) const
+        {
+            size_t vertexIndex = requireVertex(vertex);
+            if (isDirected)
+                return inDegrees[vertexIndex] + rowLength(vertexIndex);
+            return rowLength(vertexIndex);
+        }
+
+        // Get neighbors for a vertex, a single O(degree) scan of its row.
+        std::set<VertexType> getNeighbors(const VertexType &vertex) const
+        {
+            size_t vertexIndex = requireVertex(vertex);
+
+            std::set<VertexType> neighbors;
+            for (size_t pos = offsets[vertexIndex]; pos < offsets[vertexIndex + 1]; ++pos)
+            {
+                neighbors.insert(indexToVertex[targets[pos]]);
+            }
+            return neighbors;
+        }
+
+        // Calls f(VertexHandle dest, const EdgeType &value) for every edge in the vertex's row,
+        // handles index getVertices(). f may return false to stop.
+        template <typename Fn>
+        void forEachOutEdge(VertexHandle vertex, Fn &&f) const
+        {
+            requireFinalized();
+            if (vertex.index >= indexToVertex.size())
+                throw std::invalid_argument("Vertex handle does not belong to the graph");
+            for (size_t pos = offsets[vertex.index]; pos < offsets[vertex.index + 1]; ++pos)
+            {
+                if (!detail::keepVisiting(f, VertexHandle(targets[pos]), values[pos]))
+                    return;
+            }
+        }
+
+        // Streams every simple path from src to dest to visitor(const std::vector<VertexHandle> &path),
+        // handles index getVertices(). Returns the number of paths visited, see PathOptions for limits.
+        template <typename Visitor>
+        size_t forEachPath(const VertexType &src, const VertexType &dest, Visitor &&visitor, const PathOptions &options = {}) const
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+                throw std::invalid_argument("One or both vertices do not exist");
+            requireFinalized();
+
+            auto advance = [this](size_t vertex, size_t &cursor)
+            {
+                size_t pos = offsets[vertex] + cursor;
+                if (pos == offsets[vertex + 1])
+                    return detail::noNeighbor;
+                ++cursor;
+                return targets[pos];
+            };
+            return detail::enumeratePaths(indexToVertex.size(), vertexToIndex.at(src), vertexToIndex.at(dest),
+                                          options, advance, visitor);
+        }
+
+        // find all paths b/w two vertices
+        std::vector<std::vector<VertexType>> findAllPaths(const VertexType &src, const VertexType &dest, const PathOptions &options = {}) const
+        {
+            std::vector<std::vector<VertexType>> allPaths;
+            forEachPath(src, dest, [&](const std::vector<VertexHandle> &path)
+                        {
+                            std::vector<VertexType> vertices;
+                            vertices.reserve(path.size());
+                            for (const VertexHandle &vertex : path)
+                            {
+                                vertices.push_back(indexToVertex[vertex.index]);
+                            }
+                            allPaths.push_back(std::move(vertices)); },
+                        options);
+            return allPaths;
+        }
+
+        // Writes the finalized graph to a versioned binary file, see Serialization.h.
+        void save(const std::string &path) const
+        {
+            requireFinalized();
+            detail::writeGraphFile<VertexType, EdgeType>(path, detail::GraphFileKind::CSR, isDirected, false, indexToVertex,
+                                                         [this](size_t srcIndex, auto &&emit)
+                                                         {
+                                                             for (size_t pos = offsets[srcIndex]; pos < offsets[srcIndex + 1]; ++pos)
+                                                             {
+                                                                 emit(targets[pos], values[pos], isDirected);
+                                                             }
+                                                         });
+        }
+
+        // Builds a finalized graph from a file saved by any graph class with the same direction.
+        // The file already holds sorted CSR rows, so they are copied in without finalize().
+        static GraphCSR load(const std::string &path)
+        {
+            detail::GraphFile<VertexType, EdgeType> file(path);
+            file.requireDirection(std::is_same_v<Direction, DirectedG>);
+
+            GraphCSR graph;
+            for (const VertexType &vertex : file.readVertices())
+            {
+                graph.addVertex(vertex);
+            }
+            size_t numVertices = graph.indexToVertex.size();
+            if (numVertices != file.vertexCount())
+                throw std::runtime_error("Graph file has duplicate vertices");
+
+            graph.offsets.assign(file.offsets(), file.offsets() + numVertices + 1);
+            graph.targets.assign(file.targets(), file.targets() + file.entryCount());
+            graph.values.reserve(file.entryCount());
+            graph.inDegrees.assign(numVertices, 0);
+            for (size_t entry = 0; entry < file.entryCount(); ++entry)
+            {
+                if (graph.targets[entry] >= numVertices)
+                    throw std::runtime_error("Graph file has an edge to a missing vertex");
+                graph.values.push_back(file.value(entry));
+                graph.inDegrees[graph.targets[entry]]++;
+            }
+            graph.finalized = true;
+            return graph;
+        }
+
+    private:
+        struct PendingEdge
+        {
+            size_t src;
+            size_t dest;
+            EdgeType value;
+        };
+
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        std::map<VertexType, size_t> vertexToIndex;
+        std::vector<VertexType> indexToVertex;
+        std::vector<PendingEdge> pendingEdges;
+        std::vector<size_t> offsets;
+        std::vector<size_t> targets;
+        std::vector<EdgeType> values;
+        std::vector<size_t> inDegrees;
+        bool finalized = true;
+        bool isDirected;
+
+        void requireFinalized() const
+        {
+            if (!finalized)
+                throw std::logic_error("GraphCSR must be finalized before it can be queried");
+        }
+
+        size_t requireVertex(const VertexType &vertex) const
+        {
+            if (!vertexToIndex.count(vertex))
+            {
+                throw std::invalid_argument("Vertex does not exist in the graph");
+            }
+            requireFinalized();
+            return vertexToIndex.at(vertex);
+        }
+
+        size_t rowLength(size_t vertexIndex) const
+        {
+            return offsets[vertexIndex + 1] - offsets[vertexIndex];
+        }
+
+        // Binary search inside the sorted row of src.
+        size_t findEdge(size_t srcIndex, size_t destIndex) const
+        {
+            auto rowBegin = targets.begin() + offsets[srcIndex];
+            auto rowEnd = targets.begin() + offsets[srcIndex + 1];
+            auto it = std::lower_bound(rowBegin, rowEnd, destIndex);
+            if (it == rowEnd || *it != destIndex)
+                return npos;
+            return static_cast<size_t>(it - targets.begin());
+        }
+    };
+}
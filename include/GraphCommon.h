@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace Appledore
+{
+    // Tag structures
+    struct DirectedG
+    {
+    };
+    struct UndirectedG
+    {
+    };
+    struct UnweightedG
+    {
+    };
+    // Base for vertex types without a natural key: every construction draws a fresh id, and
+    // copies keep it. Ids are process-wide and start at 1, so vertices built on several
+    // threads never collide; loading a saved graph moves the sequence past the ids it reads.
+    // Graphs look these vertices up by id, see IdVertexIndex.
+    class GraphVertex
+    {
+    public:
+        size_t id;
+
+        inline static std::atomic<size_t> nextId{1};
+
+        GraphVertex()
+            : id(nextId.fetch_add(1, std::memory_order_relaxed)) {}
+
+        // Makes sure no vertex created from now on gets `id`, for ids that come from elsewhere,
+        // such as a graph file.
+        static void reserveId(size_t id)
+        {
+            size_t next = nextId.load(std::memory_order_relaxed);
+            while (next <= id && !nextId.compare_exchange_weak(next, id + 1, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        bool operator<(const GraphVertex &other) const
+        {
+            return id < other.id;
+        }
+    };
+
+    // Dense vertex index returned by addVertex/findVertex.
+    // Handle overloads skip the vertex lookup entirely; a handle stays valid until the vertex
+    // it names is removed.
+    struct VertexHandle
+    {
+        size_t index = static_cast<size_t>(-1);
+
+        VertexHandle() = default;
+        explicit VertexHandle(size_t index) : index(index) {}
+
+        bool operator==(const VertexHandle &other) const
+        {
+            return index == other.index;
+        }
+        bool operator!=(const VertexHandle &other) const
+        {
+            return index != other.index;
+        }
+        bool operator<(const VertexHandle &other) const
+        {
+            return index < other.index;
+        }
+    };
+
+    // Default weight projection: the edge value itself, 1 per edge for unweighted graphs and
+    // bool edges (MixedGraphMatrix's default), whose values are presence flags, not lengths.
+    struct EdgeValue
+    {
+        template <typename EdgeType>
+        auto operator()(const EdgeType &edge) const
+        {
+            if constexpr (std::is_same_v<EdgeType, UnweightedG> || std::is_same_v<EdgeType, bool>)
+                return size_t(1);
+            else
+                return edge;
+        }
+    };
+
+    // One vertex's entry in degrees(), same values as indegree/outdegree/totalDegree.
+    struct VertexDegree
+    {
+        size_t indegree = 0;
+        size_t outdegree = 0;
+        size_t totalDegree = 0;
+    };
+
+    // Edge payload shared by every graph class, isDirected is only meaningful for mixed graphs.
+    template <typename EdgeType>
+    struct EdgeInfo
+    {
+        EdgeType value;
+        bool isDirected;
+
+        EdgeInfo() : value(), isDirected(false) {}
+        EdgeInfo(const EdgeType &value, bool isDirected = false)
+            : value(value), isDirected(isDirected) {}
+    };
+
+    namespace detail
+    {
+        // Optional bulk-build hooks, used when a graph class has them.
+        template <typename Graph, typename = void>
+        struct HasReserveVertices : std::false_type
+        {
+        };
+        template <typename Graph>
+        struct HasReserveVertices<Graph, std::void_t<decltype(std::declval<Graph &>().reserveVertices(size_t()))>> : std::true_type
+        {
+        };
+
+        template <typename Graph, typename = void>
+        struct HasReserveEdges : std::false_type
+        {
+        };
+        template <typename Graph>
+        struct HasReserveEdges<Graph, std::void_t<decltype(std::declval<Graph &>().reserveEdges(size_t()))>> : std::true_type
+        {
+        };
+
+        template <typename Graph, typename = void>
+        struct HasFinalize : std::false_type
+        {
+        };
+        template <typename Graph>
+        struct HasFinalize<Graph, std::void_t<decltype(std::declval<Graph &>().finalize())>> : std::true_type
+        {
+        };
+
+        // Calls a visitor that may return bool; false asks the caller to stop, void visitors never do.
+        template <typename Fn, typename... Args>
+        bool keepVisiting(Fn &f, Args &&...args)
+        {
+            if constexpr (std::is_void_v<std::invoke_result_t<Fn &, Args...>>)
+            {
+                f(std::forward<Args>(args)...);
+                return true;
+            }
+            else
+            {
+                return static_cast<bool>(f(std::forward<Args>(args)...));
+            }
+        }
+    }
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+#include "GraphCommon.h"
+#include "Parallel.h"
+
+namespace Appledore
+{
+    struct GeneratorOptions
+    {
+        // The same seed gives the same graph whatever the thread count or platform.
+        uint64_t seed = 1;
+        // Threads over blocks of rows or edges, 0 = one per hardware thread.
+        unsigned threads = 1;
+        // Weights are drawn uniformly from [1, maxWeight].
+        uint32_t maxWeight = 100;
+        // Emit every edge once as src < dest, for undirected graphs.
+        bool undirected = false;
+        bool selfLoops = false;
+    };
+
+    // R-MAT quadrant probabilities; d = 1 - a - b - c. The defaults are Graph500's.
+    struct RMatParameters
+    {
+        double a = 0.57;
+        double b = 0.19;
+        double c = 0.19;
+    };
+
+    struct GeneratedEdge
+    {
+        size_t src;
+        size_t dest;
+        uint32_t weight;
+    };
+
+    // Vertices are 0 .. vertexCount - 1.
+    struct GeneratedGraph
+    {
+        size_t vertexCount = 0;
+        bool undirected = false;
+        std::vector<GeneratedEdge> edges;
+    };
+
+    namespace detail
+    {
+        // SplitMix64. The std distributions differ between standard libraries, this does not,
+        // so a seed names one graph everywhere.
+        class SplitMix64
+        {
+        public:
+            explicit SplitMix64(uint64_t seed) : state(seed) {}
+
+            uint64_t next()
+            {
+                uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                return z ^ (z >> 31);
+            }
+
+            // Uniform in [0, 1).
+            double uniform()
+            {
+                return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+            }
+
+            uint32_t weight(uint32_t maxWeight)
+            {
+                return 1 + static_cast<uint32_t>(next() % std::max<uint32_t>(maxWeight, 1));
+            }
+
+        private:
+            uint64_t state;
+        };
+
+        // Independent stream per block, so blocks can be generated in any order.
+        inline SplitMix64 blockStream(uint64_t seed, uint64_t block)
+        {
+            SplitMix64 mix(seed ^ (block * 0xD1B54A32D192ED03ull));
+            return SplitMix64(mix.next());
+        }
+
+        // Runs fn(block, edges) for every block in parallel and concatenates in block order.
+        template <typename Fn>
+        std::vector<GeneratedEdge> generateBlocks(size_t blocks, unsigned threads, Fn &&fn)
+        {
+            std::vector<std::vector<GeneratedEdge>> parts(blocks);
+            parallelFor(blocks, threads, [&](size_t block, unsigned)
+                        { fn(block, parts[block]); });
+
+            size_t total = 0;
+            for (const auto &part : parts)
+            {
+                total += part.size();
+            }
+            std::vector<GeneratedEdge> edges;
+            edges.reserve(total);
+            for (auto &part : parts)
+            {
+                edges.insert(edges.end(), part.begin(), part.end());
+                std::vector<GeneratedEdge>().swap(part);
+            }
+            return edges;
+        }
+
+        template <typename Graph, typename = void>
+        struct HasDirectionTag : std::false_type
+        {
+        };
+        template <typename Graph>
+        struct HasDirectionTag<Graph, std::void_t<typename Graph::DirectionTag>> : std::true_type
+        {
+        };
+    }
+
+    // G(n, p): every ordered pair (or unordered, with options.undirected) is an edge with
+    // probability p. Rows skip ahead geometrically, O(n + E) work rather than O(n^2).
+    inline GeneratedGraph erdosRenyi(size_t vertexCount, double probability, const GeneratorOptions &options = {})
+    {
+        if (!(probability >= 0.0 && probability <= 1.0))
+            throw std::invalid_argument("Edge probability must be in [0, 1]");
+
+        constexpr size_t rowsPerBlock = 64;
+        GeneratedGraph graph;
+        graph.vertexCount = vertexCount;
+        graph.undirected = options.undirected;
+        if (probability == 0.0)
+            return graph;
+
+        const double logMiss = std::log1p(-probability);
+        graph.edges = detail::generateBlocks((vertexCount + rowsPerBlock - 1) / rowsPerBlock, options.threads,
+                                             [&](size_t block, std::vector<GeneratedEdge> &edges)
+                                             {
+                                                 size_t end = std::min(vertexCount, (block + 1) * rowsPerBlock);
+                                                 for (size_t src = block * rowsPerBlock; src < end; ++src)
+                                                 {
+                                                     detail::SplitMix64 rng = detail::blockStream(options.seed, src);
+                                                     size_t dest = options.undirected ? src : 0;
+                                                     while (true)
+                                                     {
+                                                         if (probability < 1.0)
+                                                         {
+                                                             double skip = std::floor(std::log1p(-rng.uniform()) / logMiss);
+                                                             if (skip >= static_cast<double>(vertexCount - dest))
+                                                                 break;
+                                                             dest += static_cast<size_t>(skip);
+                                                         }
+                                                         if (dest >= vertexCount)
+                                                             break;
+                                                         if (dest != src || options.selfLoops)
+                                                             edges.push_back({src, dest, rng.weight(options.maxWeight)});
+                                                         ++dest;
+                                                     }
+                                                 }
+                                             });
+        return graph;
+    }
+
+    // R-MAT power-law graph: 2^scale vertices and edgeFactor * 2^scale edge draws, each picking
+    // a quadrant per bit of its endpoints. Like the reference generator it can draw an edge twice;
+    // dropped self loops make the edge count slightly smaller.
+    inline GeneratedGraph rmat(unsigned scale, size_t edgeFactor, const GeneratorOptions &options = {},
+                               const RMatParameters &parameters = {})
+    {
+        if (scale >= 8 * sizeof(size_t) - 1)
+            throw std::invalid_argument("R-MAT scale is too large");
+        if (parameters.a < 0 || parameters.b < 0 || parameters.c < 0 || parameters.a + parameters.b + parameters.c > 1.0)
+            throw std::invalid_argument("R-MAT probabilities must be non-negative and sum to at most 1");
+
+        constexpr size_t edgesPerBlock = size_t(1) << 16;
+        GeneratedGraph graph;
+        graph.vertexCount = size_t(1) << scale;
+        graph.undirected = options.undirected;
+        const size_t draws = edgeFactor * graph.vertexCount;
+        const double ab = parameters.a + parameters.b;
+        const double abc = ab + parameters.c;
+
+        graph.edges = detail::generateBlocks((draws + edgesPerBlock - 1) / edgesPerBlock, options.threads,
+                                             [&](size_t block, std::vector<GeneratedEdge> &edges)
+                                             {
+                                                 detail::SplitMix64 rng = detail::blockStream(options.seed, block);
+                                                 size_t end = std::min(draws, (block + 1) * edgesPerBlock);
+                                                 edges.reserve(end - block * edgesPerBlock);
+                                                 for (size_t draw = block * edgesPerBlock; draw < end; ++draw)
+                                                 {
+                                                     size_t src = 0, dest = 0;
+                                                     for (unsigned bit = 0; bit < scale; ++bit)
+                                                     {
+                                                         double r = rng.uniform();
+                                                         src = (src << 1) | (r >= ab ? 1 : 0);
+                                                         dest = (dest << 1) | ((r >= parameters.a && r < ab) || r >= abc ? 1 : 0);
+                                                     }
+                                                     if (options.undirected && src > dest)
+                                                         std::swap(src, dest);
+                                                     uint32_t weight = rng.weight(options.maxWeight);
+                                                     if (src != dest || options.selfLoops)
+                                                         edges.push_back({src, dest, weight});
+                                                 }
+                                             });
+        return graph;
+    }
+
+    // rows x columns lattice, vertex r * columns + c linked to its right and lower neighbors
+    // (and back, unless options.undirected).
+    inline GeneratedGraph grid(size_t rows, size_t columns, const GeneratorOptions &options = {})
+    {
+        GeneratedGraph graph;
+        graph.vertexCount = rows * columns;
+        graph.undirected = options.undirected;
+        graph.edges = detail::generateBlocks(rows, options.threads, [&](size_t row, std::vector<GeneratedEdge> &edges)
+                                             {
+                                                 detail::SplitMix64 rng = detail::blockStream(options.seed, row);
+                                                 auto link = [&](size_t src, size_t dest)
+                                                 {
+                                                     uint32_t weight = rng.weight(options.maxWeight);
+                                                     edges.push_back({src, dest, weight});
+                                                     if (!options.undirected)
+                                                         edges.push_back({dest, src, weight});
+                                                 };
+                                                 for (size_t column = 0; column < columns; ++column)
+                                                 {
+                                                     size_t vertex = row * columns + column;
+                                                     if (column + 1 < columns)
+                                                         link(vertex, vertex + 1);
+                                                     if (row + 1 < rows)
+                                                         link(vertex, vertex + columns);
+                                                 }
+                                             });
+        return graph;
+    }
+
+    // Builds a GraphMatrix, MixedGraphMatrix or GraphCSR from a generated edge list.
+    // Vertex i is VertexType(i), so VertexType must be arithmetic; weights become EdgeType(weight).
+    // Mixed graphs get directed edges unless the list is undirected.
+    template <typename Graph>
+    Graph buildGraph(const GeneratedGraph &generated)
+    {
+        using VertexType = typename Graph::VertexValueType;
+        using EdgeType = typename Graph::EdgeValueType;
+        static_assert(std::is_arithmetic_v<VertexType>, "generated vertices are numbered");
+
+        Graph graph;
+        if constexpr (detail::HasReserveVertices<Graph>::value)
+            graph.reserveVertices(generated.vertexCount);
+        for (size_t vertex = 0; vertex < generated.vertexCount; ++vertex)
+        {
+            graph.addVertex(static_cast<VertexType>(vertex));
+        }
+        if constexpr (detail::HasReserveEdges<Graph>::value)
+            graph.reserveEdges(generated.edges.size());
+
+        for (const GeneratedEdge &edge : generated.edges)
+        {
+            EdgeType value{};
+            if constexpr (!std::is_same_v<EdgeType, UnweightedG>)
+                value = static_cast<EdgeType>(edge.weight);
+            if constexpr (detail::HasDirectionTag<Graph>::value)
+                graph.addEdge(VertexHandle(edge.src), VertexHandle(edge.dest), value);
+            else
+                graph.addEdge(VertexHandle(edge.src), VertexHandle(edge.dest), value, !generated.undirected);
+        }
+        if constexpr (detail::HasFinalize<Graph>::value)
+            graph.finalize();
+        return graph;
+    }
+}
@@ -0,0 +1,649 @@
+#pragma once
+
+#include <vector>
+#include <stdexcept>
+#include <optional>
+#include <map>
+#include <tuple>
+#include <set>
+#include "GraphCommon.h"
+#include "PathEnumerator.h"
+#include "Serialization.h"
+
+namespace Appledore
+{
+    namespace detail
+    {
+        // One entry of a vertex's edge vector, the (src, dest) cell of the equivalent matrix.
+        template <typename EdgeType>
+        struct ListEdge
+        {
+            size_t dest;
+            EdgeInfo<EdgeType> info;
+        };
+
+        // Per-vertex contiguous edge vectors shared by GraphList and MixedGraphList.
+        template <typename EdgeType>
+        class AdjacencyLists
+        {
+        public:
+            static constexpr size_t npos = static_cast<size_t>(-1);
+
+            void addVertex()
+            {
+                lists.emplace_back();
+                inDegrees.push_back(0);
+            }
+
+            size_t size() const
+            {
+                return lists.size();
+            }
+
+            // Position of dest inside the edge vector of src, npos if absent. O(degree).
+            size_t find(size_t src, size_t dest) const
+            {
+                const auto &edges = lists[src];
+                for (size_t pos = 0; pos < edges.size(); ++pos)
+                {
+                    if (edges[pos].dest == dest)
+                        return pos;
+                }
+                return npos;
+            }
+
+            const EdgeInfo<EdgeType> *get(size_t src, size_t dest) const
+            {
+                size_t pos = find(src, dest);
+                return pos == npos ? nullptr : &lists[src][pos].info;
+            }
+
+            EdgeInfo<EdgeType> *get(size_t src, size_t dest)
+            {
+                size_t pos = find(src, dest);
+                return pos == npos ? nullptr : &lists[src][pos].info;
+            }
+
+            // Overwrite an existing entry or append a new one. O(degree of src): the row is
+            // scanned for an existing entry first; append() skips the scan.
+            void set(size_t src, size_t dest, const EdgeInfo<EdgeType> &info)
+            {
+                if (EdgeInfo<EdgeType> *existing = get(src, dest))
+                {
+                    *existing = info;
+                    return;
+                }
+                lists[src].push_back({dest, info});
+                inDegrees[dest]++;
+            }
+
+            // Append an entry known to be absent, amortized O(1); for bulk loads and appendEdge.
+            void append(size_t src, size_t dest, const EdgeInfo<EdgeType> &info)
+            {
+                lists[src].push_back({dest, info});
+                inDegrees[dest]++;
+            }
+
+            // Swap-remove: the last entry of the row takes the freed slot.
+            bool erase(size_t src, size_t dest)
+            {
+                size_t pos = find(src, dest);
+                if (pos == npos)
+                    return false;
+
+                auto &edges = lists[src];
+                if (pos + 1 != edges.size())
+                {
+                    edges[pos] = std::move(edges.back());
+                }
+                edges.pop_back();
+                inDegrees[dest]--;
+                return true;
+            }
+
+            const std::vector<ListEdge<EdgeType>> &row(size_t src) const
+            {
+                return lists[src];
+            }
+
+            size_t outdegree(size_t src) const
+            {
+                return lists[src].size();
+            }
+
+            size_t indegree(size_t dest) const
+            {
+                return inDegrees[dest];
+            }
+
+        private:
+            std::vector<std::vector<ListEdge<EdgeType>>> lists;
+            std::vector<size_t> inDegrees;
+        };
+    }
+
+    // GraphList class template
+    // Mutable adjacency-list counterpart of GraphMatrix, memory is O(V + E).
+    template <typename VertexType, typename EdgeType, typename Direction>
+    class GraphList
+    {
+    public:
+        using VertexValueType = VertexType;
+        using EdgeValueType = EdgeType;
+        using DirectionTag = Direction;
+
+        GraphList()
+            : isDirected(std::is_same_v<Direction, DirectedG>) {}
+
+        template <typename... Vertices>
+        void addVertex(Vertices &&...vertices)
+        {
+            auto add_single_vertex = [this](const VertexType &vertex)
+            {
+                if (vertexToIndex.count(vertex))
+                    return;
+                size_t newIndex = indexToVertex.size();
+                vertexToIndex[vertex] = newIndex;
+                indexToVertex.push_back(vertex);
+                adjacency.addVertex();
+            };
+
+            (add_single_vertex(std::forward<Vertices>(vertices)), ...);
+        }
+
+        bool operator()(const VertexType &src, const VertexType &dest) const
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            {
+                return false;
+            }
+            return adjacency.get(vertexToIndex.at(src), vertexToIndex.at(dest)) != nullptr;
+        }
+
+        // for weighted.
+        // O(degree of src), and of dest for undirected graphs: an existing (src, dest) edge is
+        // overwritten, so the edge vector is scanned first. Use appendEdge for new edges on hubs.
+        void addEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge)
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+                throw std::invalid_argument("One or both vertices do not exist");
+
+            size_t srcIndex = vertexToIndex.at(src);
+            size_t destIndex = vertexToIndex.at(dest);
+
+            adjacency.set(srcIndex, destIndex, EdgeInfo<EdgeType>(edge));
+
+            if (!isDirected && srcIndex != destIndex)
+            {
+                adjacency.set(destIndex, srcIndex, EdgeInfo<EdgeType>(edge));
+            }
+        }
+
+        // for unweighted
+        void addEdge(const VertexType &src, const VertexType &dest)
+        {
+            addEdge(src, dest, EdgeType());
+        }
+
+        // Amortized O(1) addEdge for an edge the caller knows is new: nothing is scanned, so
+        // appending an existing (src, dest) edge stores it twice.
+        void appendEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge)
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+                throw std::invalid_argument("One or both vertices do not exist");
+
+            size_t srcIndex = vertexToIndex.at(src);
+            size_t destIndex = vertexToIndex.at(dest);
+
+            adjacency.append(srcIndex, destIndex, EdgeInfo<EdgeType>(edge));
+
+            if (!isDirected && srcIndex != destIndex)
+            {
+                adjacency.append(destIndex, srcIndex, EdgeInfo<EdgeType>(edge));
+            }
+        }
+
+        void appendEdge(const VertexType &src, const VertexType &dest)
+        {
+            appendEdge(src, dest, EdgeType());
+        }
+
+        // Remove edge
+        void removeEdge(const VertexType &src, const VertexType &dest)
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+                throw std::invalid_argument("One or both vertices do not exist");
+
+            size_t srcIndex = vertexToIndex.at(src);
+            size_t destIndex = vertexToIndex.at(dest);
+
+            adjacency.erase(srcIndex, destIndex);
+
+            if (!isDirected)
+            {
+                adjacency.erase(destIndex, srcIndex);
+            }
+        }
+
+        // Check if edge exists
+        bool hasEdge(const VertexType &src, const VertexType &dest) const
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+                throw std::invalid_argument("One or both vertices do not exist");
+
+            return adjacency.get(vertexToIndex.at(src), vertexToIndex.at(dest)) != nullptr;
+        }
+
+        // Get vertices
+        const std::vector<VertexType> &getVertices() const
+        {
+            return indexToVertex;
+        }
+
+        const EdgeType &getEdge(const VertexType &src, const VertexType &dest) const
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            {
+                throw std::invalid_argument("One or both vertices do not exist!");
+            }
+
+            const EdgeInfo<EdgeType> *edgeValue = adjacency.get(vertexToIndex.at(src), vertexToIndex.at(dest));
+            if (!edgeValue)
+            {
+                throw std::runtime_error("No Edge exists between the given vertices.");
+            }
+            return edgeValue->value;
+        }
+
+        // Get all edges, rows in vertex order and each row in its storage order.
+        std::vector<std::tuple<VertexType, VertexType, EdgeType>> getAllEdges() const
+        {
+            std::vector<std::tuple<VertexType, VertexType, EdgeType>> edges;
+
+            for (size_t srcIndex = 0; srcIndex < adjacency.size(); ++srcIndex)
+            {
+                for (const auto &edge : adjacency.row(srcIndex))
+                {
+                    edges.emplace_back(indexToVertex[srcIndex], indexToVertex[edge.dest], edge.info.value);
+                }
+            }
+            return edges;
+        }
+
+        // Get indegree for a vertex, undirected graphs return the total degree like GraphMatrix.
+        [[nodiscard]] size_t indegree(const VertexType &vertex) const
+        {
+            size_t vertexIndex = requireVertex(vertex);
+            if (!isDirected)
+                return adjacency.outdegree(vertexIndex);
+            return adjacency.indegree(vertexIndex);
+        }
+
+        // Get outdegree for a vertex, undirected graphs return the total degree like GraphMatrix.
+        [[nodiscard]] size_t outdegree(const VertexType &vertex) const
+        {
+            return adjacency.outdegree(requireVertex(vertex));
+        }
+
+        // Get totalDegree for a vertex
+        [[nodiscard]] size_t totalDegree(const VertexType &vertex) const
+        {
+            size_t vertexIndex = requireVertex(vertex);
+            if (isDirected)
+                return adjacency.indegree(vertexIndex) + adjacency.outdegree(vertexIndex);
+            return adjacency.outdegree(vertexIndex);
+        }
+
+        // Get neighbors for a vertex
+        std::set<VertexType> getNeighbors(const VertexType &vertex) const
+        {
+            size_t vertexIndex = requireVertex(vertex);
+
+            std::set<VertexType> neighbors;
+            for (const auto &edge : adjacency.row(vertexIndex))
+            {
+                neighbors.insert(indexToVertex[edge.dest]);
+            }
+            return neighbors;
+        }
+
+        // Calls f(VertexHandle dest, const EdgeType &value) for every edge in the vertex's list,
+        // handles index getVertices(). f may return false to stop.
+        template <typename Fn>
+        void forEachOutEdge(VertexHandle vertex, Fn &&f) const
+        {
+            if (vertex.index >= indexToVertex.size())
+                throw std::invalid_argument("Vertex handle does not belong to the graph");
+            for (const auto &edge : adjacency.row(vertex.index))
+            {
+                if (!detail::keepVisiting(f, VertexHandle(edge.dest), edge.info.value))
+                    return;
+            }
+        }
+
+        // Streams every simple path from src to dest to visitor(const std::vector<VertexHandle> &path),
+        // handles index getVertices(). Returns the number of paths visited, see PathOptions for limits.
+        template <typename Visitor>
+        size_t forEachPath(const VertexType &src, const VertexType &dest, Visitor &&visitor, const PathOptions &options = {}) const
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+                throw std::invalid_argument("One or both vertices do not exist");
+
+            auto advance = [this](size_t vertex, size_t &cursor)
+            {
+                const auto &edges = adjacency.row(vertex);
+                if (cursor == edges.size())
+                    return detail::noNeighbor;
+                return edges[cursor++].dest;
+            };
+            return detail::enumeratePaths(indexToVertex.size(), vertexToIndex.at(src), vertexToIndex.at(dest),
+                                          options, advance, visitor);
+        }
+
+        // find all paths b/w two vertices
+        std::vector<std::vector<VertexType>> findAllPaths(const VertexType &src, const VertexType &dest, const PathOptions &options = {}) const
+        {
+            std::vector<std::vector<VertexType>> allPaths;
+            forEachPath(src, dest, [&](const std::vector<VertexHandle> &path)
+                        {
+                            std::vector<VertexType> vertices;
+                            vertices.reserve(path.size());
+                            for (const VertexHandle &vertex : path)
+                            {
+                                vertices.push_back(indexToVertex[vertex.index]);
+                            }
+                            allPaths.push_back(std::move(vertices)); },
+                        options);
+            return allPaths;
+        }
+
+        // Writes the graph to a versioned binary file, see Serialization.h.
+        void save(const std::string &path) const
+        {
+            detail::writeGraphFile<VertexType, EdgeType>(path, detail::GraphFileKind::List, isDirected, false, indexToVertex,
+                                                         [this](size_t srcIndex, auto &&emit)
+                                                         {
+                                                             for (const auto &edge : adjacency.row(srcIndex))
+                                                             {
+                                                                 emit(edge.dest, edge.info.value, isDirected);
+                                                             }
+                                                         });
+        }
+
+        // Builds a graph from a file saved by any graph class with the same direction.
+        static GraphList load(const std::string &path)
+        {
+            detail::GraphFile<VertexType, EdgeType> file(path);
+            file.requireDirection(std::is_same_v<Direction, DirectedG>);
+
+            GraphList graph;
+            for (const VertexType &vertex : file.readVertices())
+            {
+                graph.addVertex(vertex);
+            }
+            size_t numVertices = graph.indexToVertex.size();
+            if (numVertices != file.vertexCount())
+                throw std::runtime_error("Graph file has duplicate vertices");
+
+            // rows are stored entry by entry, both ends of undirected edges included
+            const uint64_t *offsets = file.offsets();
+            const uint64_t *targets = file.targets();
+            for (size_t srcIndex = 0; srcIndex < numVertices; ++srcIndex)
+            {
+                for (size_t entry = offsets[srcIndex]; entry < offsets[srcIndex + 1]; ++entry)
+                {
+                    size_t destIndex = static_cast<size_t>(targets[entry]);
+                    if (destIndex >= numVertices)
+                        throw std::runtime_error("Graph file has an edge to a missing vertex");
+                    graph.adjacency.append(srcIndex, destIndex, EdgeInfo<EdgeType>(file.value(entry), file.isDirected(entry)));
+                }
+            }
+            return graph;
+        }
+
+    private:
+        std::map<VertexType, size_t> vertexToIndex;
+        std::vector<VertexType> indexToVertex;
+        detail::AdjacencyLists<EdgeType> adjacency;
+        bool isDirected;
+
+        size_t requireVertex(const VertexType &vertex) const
+        {
+            if (!vertexToIndex.count(vertex))
+            {
+                throw std::invalid_argument("Vertex does not exist in the graph");
+            }
+            return vertexToIndex.at(vertex);
+        }
+    };
+
+    // MixedGraphList class template
+    // Adjacency-list counterpart of MixedGraphMatrix, every edge carries its own directed flag.
+    template <typename VertexType, typename EdgeType = bool>
+    class MixedGraphList
+    {
+    public:
+        void addVertex(const VertexType &vertex)
+        {
+            if (vertexToIndex.count(vertex))
+                return;
+
+            size_t newIndex = indexToVertex.size();
+            vertexToIndex[vertex] = newIndex;
+            indexToVertex.push_back(vertex);
+            adjacency.addVertex();
+        }
+
+        const std::vector<VertexType> &getVertices() const
+        {
+            return indexToVertex;
+        }
+
+        bool operator()(const VertexType &src, const VertexType &dest) const
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            {
+                return false;
+            }
+            return adjacency.get(vertexToIndex.at(src), vertexToIndex.at(dest)) != nullptr;
+        }
+
+        bool hasEdge(const VertexType &src, const VertexType &dest) const
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            {
+                throw std::invalid_argument("One or both vertices do not exist");
+            }
+            return adjacency.get(vertexToIndex.at(src), vertexToIndex.at(dest)) != nullptr;
+        }
+
+        EdgeType getEdgeValue(const VertexType &src, const VertexType &dest) const
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            {
+                throw std::invalid_argument("One or both vertices do not exist");
+            }
+
+            const EdgeInfo<EdgeType> *edgeValue = adjacency.get(vertexToIndex.at(src), vertexToIndex.at(dest));
+            if (!edgeValue)
+            {
+                throw std::runtime_error("Edge does not exist");
+            }
+            return edgeValue->value;
+        }
+
+        // Directed edges are reported once, undirected edges once from their lower-index end.
+        std::vector<EdgeType> getEdges() const
+        {
+            std::vector<EdgeType> edges;
+
+            for (size_t src = 0; src < adjacency.size(); ++src)
+            {
+                for (const auto &edge : adjacency.row(src))
+                {
+                    if (edge.info.isDirected || src <= edge.dest)
+                    {
+                        edges.push_back(edge.info.value);
+                    }
+                }
+            }
+            return edges;
+        }
+
+        // generic, being used by all overloads.
+        // O(degree) of the endpoints: existing edges are overwritten, so their rows are scanned
+        // first. appendEdge skips the scan for edges known to be new.
+        void addEdge(const VertexType &src, const VertexType &dest, std::optional<EdgeType> edgeValue, bool isDirected = false)
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            {
+                throw std::invalid_argument("One or both vertices do not exist");
+            }
+
+            size_t srcIndex = vertexToIndex.at(src);
+            size_t destIndex = vertexToIndex.at(dest);
+
+            adjacency.set(srcIndex, destIndex, EdgeInfo<EdgeType>(edgeValue.value_or(EdgeType()), isDirected));
+
+            if (!isDirected && srcIndex != destIndex)
+            {
+                adjacency.set(destIndex, srcIndex, EdgeInfo<EdgeType>(edgeValue.value_or(EdgeType()), isDirected));
+            }
+        }
+
+        // case 1: non weighted, directed/undirected edge.
+        void addEdge(const VertexType &src, const VertexType &dest, bool isDirected)
+        {
+            addEdge(src, dest, std::nullopt, isDirected);
+        }
+
+        // case 2: weighted, undirected edge.
+        void addEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge)
+        {
+            addEdge(src, dest, edge, false);
+        }
+
+        // case 3: weighted, directed/undirected edge.
+        void addEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge, bool isDirected)
+        {
+            addEdge(src, dest, std::optional<EdgeType>(edge), isDirected);
+        }
+
+        // Amortized O(1) addEdge for an edge the caller knows is absent, both ways if undirected:
+        // nothing is scanned, so appending an existing edge stores it twice.
+        void appendEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge, bool isDirected = false)
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            {
+                throw std::invalid_argument("One or both vertices do not exist");
+            }
+
+            size_t srcIndex = vertexToIndex.at(src);
+            size_t destIndex = vertexToIndex.at(dest);
+
+            adjacency.append(srcIndex, destIndex, EdgeInfo<EdgeType>(edge, isDirected));
+
+            if (!isDirected && srcIndex != destIndex)
+            {
+                adjacency.append(destIndex, srcIndex, EdgeInfo<EdgeType>(edge, isDirected));
+            }
+        }
+
+        // Removes (src, dest), and (dest, src) too unless that reverse edge is directed.
+        void removeEdge(const VertexType &src, const VertexType &dest)
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            {
+                throw std::invalid_argument("One or both vertices do not exist");
+            }
+
+            size_t srcIndex = vertexToIndex.at(src);
+            size_t destIndex = vertexToIndex.at(dest);
+
+            adjacency.erase(srcIndex, destIndex);
+
+            const EdgeInfo<EdgeType> *reverse = adjacency.get(destIndex, srcIndex);
+            if (reverse && !reverse->isDirected)
+            {
+                adjacency.erase(destIndex, srcIndex);
+            }
+        }
+
+        void updateEdge(const VertexType &src, const VertexType &dest, const EdgeType &newValue)
+        {
+            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            {
+                throw std::invalid_argument("One or both vertices do not exist");
+            }
+
+            size_t srcIndex = vertexToIndex.at(src);
+            size_t destIndex = vertexToIndex.at(dest);
+
+            EdgeInfo<EdgeType> *edgeValue = adjacency.get(srcIndex, destIndex);
+            if (!edgeValue)
+            {
+                throw std::runtime_error("Edge does not exist");
+            }
+
+            edgeValue->value = newValue;
+
+            // If the edge is undirected, update the reverse edge too
+            if (!edgeValue->isDirected)
+            {
+                if (EdgeInfo<EdgeType> *reverse = adjacency.get(destIndex, srcIndex))
+                {
+                    reverse->value = newValue;
+                }
+            }
+        }
+
+        // Writes the graph to a versioned binary file, see Serialization.h.
+        void save(const std::string &path) const
+        {
+            detail::writeGraphFile<VertexType, EdgeType>(path, detail::GraphFileKind::MixedList, false, true, indexToVertex,
+                                                         [this](size_t srcIndex, auto &&emit)
+                                                         {
+                                                             for (const auto &edge : adjacency.row(srcIndex))
+                                                             {
+                                                                 emit(edge.dest, edge.info.value, edge.info.isDirected);
+                                                             }
+                                                         });
+        }
+
+        // Builds a graph from a file saved by any graph class; edges of directed or undirected
+        // graphs keep that direction.
+        static MixedGraphList load(const std::string &path)
+        {
+            detail::GraphFile<VertexType, EdgeType> file(path);
+
+            MixedGraphList graph;
+            for (const VertexType &vertex : file.readVertices())
+            {
+                graph.addVertex(vertex);
+            }
+            size_t numVertices = graph.indexToVertex.size();
+            if (numVertices != file.vertexCount())
+                throw std::runtime_error("Graph file has duplicate vertices");
+
+            // rows are stored entry by entry, both ends of undirected edges included
+            const uint64_t *offsets = file.offsets();
+            const uint64_t *targets = file.targets();
+            for (size_t srcIndex = 0; srcIndex < numVertices; ++srcIndex)
+            {
+                for (size_t entry = offsets[srcIndex]; entry < offsets[srcIndex + 1]; ++entry)
+                {
+                    size_t destIndex = static_cast<size_t>(targets[entry]);
+                    if (destIndex >= numVertices)
+                        throw std::runtime_error("Graph file has an edge to a missing vertex");
+                    graph.adjacency.append(srcIndex, destIndex, EdgeInfo<EdgeType>(file.value(entry), file.isDirected(entry)));
+                }
+            }
+            return graph;
+        }
+
+    private:
+        std::map<VertexType, size_t> vertexToIndex;
+        std::vector<VertexType> indexToVertex;
+        detail::AdjacencyLists<EdgeType> adjacency;
+    };
+}
@@ -5,156 +5,244 @@
 #include <stdexcept>
 #include <optional>
 #include <map>
-#include <stack>
 #include <algorithm>
 #include <set>
+#include <array>
+#include "GraphCommon.h"
+#include "MatrixStorage.h"
+#include "VertexIndex.h"
+#include "PathEnumerator.h"
+#include "GraphViews.h"
+#include "Serialization.h"
+#include "EdgeBatch.h"
+#include "Instrumentation.h"
 
 namespace Appledore
 {
-    // Tag structures
-    struct DirectedG
-    {
-    };
-    struct UndirectedG
-    {
-    };
-    struct UnweightedG
-    {
-    };
-    class GraphVertex
-    {
-    public:
-        size_t id;
-
-        static size_t nextId;
-
-        GraphVertex()
-        {
-            id = nextId++;
-        }
-        bool operator<(const GraphVertex &other) const
-        {
-            return id < other.id;
-        }
-    };
-    size_t Appledore::GraphVertex::nextId = 1;
-    template <typename EdgeType>
-    struct EdgeInfo
-    {
-        EdgeType value;
-
-        EdgeInfo(const EdgeType &value) : value(value) {}
-    };
-
     // GraphMatrix class template
-    template <typename VertexType, typename EdgeType, typename Direction>
+    // VertexIndex selects the vertex lookup: OrderedVertexIndex (std::map, the default),
+    // HashedVertexIndex for O(1) lookups that also accept std::string_view / const char* keys,
+    // or IdVertexIndex, the default for GraphVertex-derived types, which indexes by id.
+    // EdgeStorage selects where edge values live: InlineEdges (the default), PooledEdges,
+    // which suits large edge types on sparse graphs, TriangularEdges for undirected graphs, or
+    // PagedEdges, whose copies share unchanged pages (for ConcurrentGraph); see MatrixStorage.h.
+    template <typename VertexType, typename EdgeType, typename Direction,
+              typename VertexIndex = DefaultVertexIndex<VertexType>, typename EdgeStorage = InlineEdges>
     class GraphMatrix
     {
+        static_assert(!std::is_same_v<EdgeStorage, TriangularEdges> || std::is_same_v<Direction, UndirectedG>,
+                      "TriangularEdges needs an undirected graph");
+
+        using Storage = MatrixStorage<EdgeType, false, EdgeStorage>;
+        // the triangle holds each undirected edge once, and edge listings follow it
+        static constexpr bool triangular = std::is_same_v<EdgeStorage, TriangularEdges>;
+
     public:
+        using VertexValueType = VertexType;
+        using EdgeValueType = EdgeType;
+        using DirectionTag = Direction;
+
         GraphMatrix()
             : isDirected(std::is_same_v<Direction, DirectedG>),
               isWeighted(!std::is_same_v<EdgeType, UnweightedG>) {}
 
+        // Returns the handle of the vertex, or an array of handles when several are added.
+        // Adding a vertex that already exists returns its existing handle.
         template <typename... Vertices>
-        void addVertex(Vertices &&...vertices)
+        auto addVertex(Vertices &&...vertices)
         {
             auto add_single_vertex = [this](const VertexType &vertex)
             {
-                if (vertexToIndex.count(vertex))
-                    return;
+                size_t index = findIndex(vertex);
+                if (index != npos)
+                    return VertexHandle(index);
                 size_t newIndex = numVertices++;
-                vertexToIndex[vertex] = newIndex;
                 indexToVertex.push_back(vertex);
+                inDegrees.push_back(0);
+                outDegrees.push_back(0);
+                vertexToIndex.insert(newIndex, indexToVertex);
+                return VertexHandle(newIndex);
             };
 
-            (add_single_vertex(std::forward<Vertices>(vertices)), ...);
+            std::array<VertexHandle, sizeof...(Vertices)> handles{add_single_vertex(std::forward<Vertices>(vertices))...};
+
+            adjacencyMatrix.ensure(numVertices);
 
-            adjacencyMatrix.resize(numVertices * numVertices, std::nullopt);
+            if constexpr (sizeof...(Vertices) == 1)
+                return handles[0];
+            else
+                return handles;
+        }
+
+        // Pre-size the matrix for `count` vertices so later addVertex calls never reallocate.
+        void reserveVertices(size_t count)
+        {
+            adjacencyMatrix.reserve(count);
+        }
+
+        // Removes a vertex and its edges in O(V): the last vertex moves into the freed index,
+        // so handles to the removed vertex and to the last one are invalidated.
+        void removeVertex(VertexHandle vertex)
+        {
+            removeIndices({checkHandle(vertex)});
+        }
+
+        template <typename Key = VertexType>
+        void removeVertex(const Key &vertex)
+        {
+            removeVertex(requireVertex(vertex));
         }
 
-        bool operator()(const VertexType src, const VertexType &dest)
+        // Removes every listed vertex in one compaction pass, O(k * V) for k vertices instead of
+        // a rebuild: survivors from the tail fill the freed indices. Duplicates are ignored, and
+        // nothing is removed if any vertex is missing. Invalidates handles past the new size.
+        void removeVertices(const std::vector<VertexHandle> &vertices)
         {
-            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            std::vector<size_t> indices;
+            indices.reserve(vertices.size());
+            for (VertexHandle vertex : vertices)
             {
-                return false;
+                indices.push_back(checkHandle(vertex));
             }
+            removeIndices(std::move(indices));
+        }
 
-            size_t srcIndex = vertexToIndex[src];
-            size_t destIndex = vertexToIndex[dest];
-
-            if (adjacencyMatrix[getIndex(srcIndex, destIndex)].has_value())
+        void removeVertices(const std::vector<VertexType> &vertices)
+        {
+            std::vector<size_t> indices;
+            indices.reserve(vertices.size());
+            for (const VertexType &vertex : vertices)
             {
-                return true;
+                indices.push_back(requireVertex(vertex).index);
             }
-            else
+            removeIndices(std::move(indices));
+        }
+
+        // Handle of a vertex, std::nullopt if it is not in the graph.
+        template <typename Key = VertexType>
+        std::optional<VertexHandle> findVertex(const Key &vertex) const
+        {
+            size_t index = findIndex(vertex);
+            if (index == npos)
+                return std::nullopt;
+            return VertexHandle(index);
+        }
+
+        // Vertex named by a handle
+        const VertexType &getVertex(VertexHandle vertex) const
+        {
+            return indexToVertex[checkHandle(vertex)];
+        }
+
+        template <typename SrcKey = VertexType, typename DestKey = VertexType>
+        bool operator()(const SrcKey &src, const DestKey &dest) const
+        {
+            size_t srcIndex = findIndex(src);
+            size_t destIndex = findIndex(dest);
+            if (srcIndex == npos || destIndex == npos)
             {
                 return false;
             }
+
+            return adjacencyMatrix.has(srcIndex, destIndex);
         }
 
         // for weighted.
         void addEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge)
         {
-            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
-                throw std::invalid_argument("One or both vertices do not exist");
-
-            size_t srcIndex = vertexToIndex.at(src);
-            size_t destIndex = vertexToIndex.at(dest);
+            addEdge(requireEndpoint(src), requireEndpoint(dest), edge);
+        }
 
-            adjacencyMatrix[getIndex(srcIndex, destIndex)] = EdgeInfo<EdgeType>(edge);
+        void addEdge(VertexHandle src, VertexHandle dest, const EdgeType &edge)
+        {
+            detail::ScopedProbe probe(InstrumentedOperation::AddEdge);
+            size_t srcIndex = checkHandle(src);
+            size_t destIndex = checkHandle(dest);
 
-            if (!isDirected)
-            {
-                adjacencyMatrix[getIndex(destIndex, srcIndex)] = EdgeInfo<EdgeType>(edge);
-            }
+            if (isDirected)
+                setCell(srcIndex, destIndex, edge);
+            else
+                setPair(srcIndex, destIndex, edge);
         }
 
         // for unweighted
         void addEdge(const VertexType &src, const VertexType &dest)
         {
-            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
-            {
-                throw std::invalid_argument("One or both vertices do not exist");
-            }
-
-            size_t srcIndex = vertexToIndex.at(src);
-            size_t destIndex = vertexToIndex.at(dest);
-
-            adjacencyMatrix[getIndex(srcIndex, destIndex)] = EdgeInfo<EdgeType>();
+            addEdge(requireEndpoint(src), requireEndpoint(dest), EdgeType());
+        }
 
-            if (!isDirected)
-            {
-                adjacencyMatrix[getIndex(destIndex, srcIndex)] = EdgeInfo<EdgeType>();
-            }
+        void addEdge(VertexHandle src, VertexHandle dest)
+        {
+            addEdge(src, dest, EdgeType());
         }
 
         // Remove edge
         void removeEdge(const VertexType &src, const VertexType &dest)
         {
-            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
-                throw std::invalid_argument("One or both vertices do not exist");
+            removeEdge(requireEndpoint(src), requireEndpoint(dest));
+        }
 
-            size_t srcIndex = vertexToIndex.at(src);
-            size_t destIndex = vertexToIndex.at(dest);
+        void removeEdge(VertexHandle src, VertexHandle dest)
+        {
+            size_t srcIndex = checkHandle(src);
+            size_t destIndex = checkHandle(dest);
 
-            adjacencyMatrix[getIndex(srcIndex, destIndex)] = std::nullopt;
+            if (isDirected)
+                resetCell(srcIndex, destIndex);
+            else
+                resetPair(srcIndex, destIndex);
+        }
 
-            if (!isDirected)
-            {
-                adjacencyMatrix[getIndex(destIndex, srcIndex)] = std::nullopt;
-            }
+        // Replaces the value of an existing edge, both directions of an undirected one.
+        void updateEdge(const VertexType &src, const VertexType &dest, const EdgeType &value)
+        {
+            updateEdge(requireEndpoint(src), requireEndpoint(dest), value);
         }
 
-        // Check if edge exists
-        bool hasEdge(const VertexType &src, const VertexType &dest) const
+        void updateEdge(VertexHandle src, VertexHandle dest, const EdgeType &value)
         {
-            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
-                throw std::invalid_argument("One or both vertices do not exist");
+            size_t srcIndex = checkHandle(src);
+            size_t destIndex = checkHandle(dest);
+            if (!adjacencyMatrix.has(srcIndex, destIndex))
+                throw std::runtime_error("No Edge exists between the given vertices.");
+            updateCell(srcIndex, destIndex, value);
+        }
+
+        // Batch mutations over a range of tuple-like items whose endpoints are vertices or
+        // VertexHandles: (src, dest[, value]) for addEdges, (src, dest, value) for updateEdges,
+        // (src, dest) for removeEdges. Endpoints are all resolved first, then the cell writes
+        // are bucketed by row and applied by options.threads workers that each own whole rows.
+        // The graph ends up as if the items were applied one by one in order; instead of
+        // throwing, each item gets a BatchStatus in the returned vector.
+        template <typename Range>
+        std::vector<BatchStatus> addEdges(const Range &edges, const BatchOptions &options = {})
+        {
+            return applyBatch(edges, options, detail::BatchKind::Add);
+        }
+
+        template <typename Range>
+        std::vector<BatchStatus> removeEdges(const Range &edges, const BatchOptions &options = {})
+        {
+            return applyBatch(edges, options, detail::BatchKind::Remove);
+        }
 
-            size_t srcIndex = vertexToIndex.at(src);
-            size_t destIndex = vertexToIndex.at(dest);
+        template <typename Range>
+        std::vector<BatchStatus> updateEdges(const Range &edges, const BatchOptions &options = {})
+        {
+            static_assert(std::tuple_size_v<detail::BatchItem<Range>> >= 3, "updateEdges items are (src, dest, value)");
+            return applyBatch(edges, options, detail::BatchKind::Update);
+        }
 
-            return adjacencyMatrix[getIndex(srcIndex, destIndex)].has_value();
+        // Check if edge exists
+        template <typename SrcKey = VertexType, typename DestKey = VertexType>
+        bool hasEdge(const SrcKey &src, const DestKey &dest) const
+        {
+            return hasEdge(requireEndpoint(src), requireEndpoint(dest));
+        }
+
+        bool hasEdge(VertexHandle src, VertexHandle dest) const
+        {
+            return adjacencyMatrix.has(checkHandle(src), checkHandle(dest));
         }
 
         // Get vertices
@@ -163,20 +251,26 @@ namespace Appledore
             return indexToVertex;
         }
 
-        const EdgeType &getEdge(const VertexType &src, const VertexType &dest) const
+        template <typename SrcKey = VertexType, typename DestKey = VertexType>
+        const EdgeType &getEdge(const SrcKey &src, const DestKey &dest) const
         {
-            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            size_t srcIndex = findIndex(src);
+            size_t destIndex = findIndex(dest);
+            if (srcIndex == npos || destIndex == npos)
             {
                 throw std::invalid_argument("One or both vertices do not exist!");
             }
-            size_t srcIndex = vertexToIndex.at(src);
-            size_t destIndex = vertexToIndex.at(dest);
+            return getEdge(VertexHandle(srcIndex), VertexHandle(destIndex));
+        }
 
-            auto &edgeValue = adjacencyMatrix[getIndex(srcIndex, destIndex)];
+        const EdgeType &getEdge(VertexHandle src, VertexHandle dest) const
+        {
+            size_t srcIndex = checkHandle(src);
+            size_t destIndex = checkHandle(dest);
 
-            if (edgeValue.has_value())
+            if (adjacencyMatrix.has(srcIndex, destIndex))
             {
-                return edgeValue.value().value;
+                return adjacencyMatrix.value(srcIndex, destIndex);
             }
             else
             {
@@ -185,178 +279,542 @@ namespace Appledore
         }
 
         // Get all edges
+        // With TriangularEdges every undirected edge is reported once, as (src, dest) with src <= dest.
         std::vector<std::tuple<VertexType, VertexType, EdgeType>> getAllEdges() const
         {
             std::vector<std::tuple<VertexType, VertexType, EdgeType>> edges;
 
             for (size_t srcIndex = 0; srcIndex < numVertices; ++srcIndex)
             {
-                for (size_t destIndex = 0; destIndex < numVertices; ++destIndex)
+                for (size_t destIndex = adjacencyMatrix.nextInRow(srcIndex, triangular ? srcIndex : 0, numVertices);
+                     destIndex < numVertices;
+                     destIndex = adjacencyMatrix.nextInRow(srcIndex, destIndex + 1, numVertices))
                 {
-                    const auto &edgeValue = adjacencyMatrix[getIndex(srcIndex, destIndex)];
-                    if (edgeValue.has_value())
-                    {
-                        edges.emplace_back(
-                            indexToVertex[srcIndex],
-                            indexToVertex[destIndex],
-                            edgeValue.value().value);
-                    }
+                    edges.emplace_back(
+                        indexToVertex[srcIndex],
+                        indexToVertex[destIndex],
+                        adjacencyMatrix.value(srcIndex, destIndex));
                 }
             }
             return edges;
         }
+        // Degrees are kept up to date by addEdge/removeEdge, so every query is O(1).
+        // Undirected graphs have no in/out split: indegree and outdegree return the total degree.
         // Get indegree for a vertex
-        [[nodiscard]] size_t indegree(const VertexType& vertex) const
+        template <typename Key = VertexType>
+        [[nodiscard]] size_t indegree(const Key &vertex) const
+        {
+            return indegree(requireVertex(vertex));
+        }
+
+        [[nodiscard]] size_t indegree(VertexHandle vertex) const
+        {
+            size_t vertexIndex = checkHandle(vertex);
+            return isDirected ? inDegrees[vertexIndex] : outDegrees[vertexIndex];
+        }
+        // Get outdegree for a vertex
+        template <typename Key = VertexType>
+        [[nodiscard]] size_t outdegree(const Key &vertex) const
         {
-            if (!vertexToIndex.count(vertex))
+            return outdegree(requireVertex(vertex));
+        }
+
+        [[nodiscard]] size_t outdegree(VertexHandle vertex) const
+        {
+            return outDegrees[checkHandle(vertex)];
+        }
+        // Get totalDegree for a vertex
+        template <typename Key = VertexType>
+        [[nodiscard]] size_t totalDegree(const Key &vertex) const
+        {
+            return totalDegree(requireVertex(vertex));
+        }
+
+        [[nodiscard]] size_t totalDegree(VertexHandle vertex) const
+        {
+            size_t vertexIndex = checkHandle(vertex);
+            // undirected rows mirror their columns, so the row count is the degree
+            return isDirected ? inDegrees[vertexIndex] + outDegrees[vertexIndex] : outDegrees[vertexIndex];
+        }
+
+        // Degrees of every vertex, indexed by VertexHandle::index.
+        std::vector<VertexDegree> degrees() const
+        {
+            std::vector<VertexDegree> result(numVertices);
+            for (size_t vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
             {
-                throw std::invalid_argument("Vertex does not exist in the graph");
+                VertexHandle vertex(vertexIndex);
+                result[vertexIndex] = {indegree(vertex), outdegree(vertex), totalDegree(vertex)};
             }
-            if (!isDirected)
+            return result;
+        }
+
+        // Heap bytes by component and matrix fill, see MemoryUsage; works with or without
+        // APPLEDORE_INSTRUMENTATION.
+        MemoryUsage memoryUsage() const
+        {
+            MemoryUsage usage;
+            usage.matrixBytes = adjacencyMatrix.memoryBytes();
+            usage.indexBytes = vertexToIndex.memoryBytes();
+            usage.vertexBytes = indexToVertex.capacity() * sizeof(VertexType);
+            usage.degreeBytes = (inDegrees.capacity() + outDegrees.capacity()) * sizeof(size_t);
+            usage.vertexCount = numVertices;
+            usage.vertexCapacity = adjacencyMatrix.capacity();
+            for (size_t count : outDegrees)
             {
-                std::cerr << "\nIndegree is not defined for undirected graphs. Returning Total Degree\n";
-                return totalDegree(vertex);
+                usage.storedCells += count;
             }
-            size_t vertexIndex = vertexToIndex.at(vertex);
-            size_t indegree = 0;
-            for (size_t srcIndex = 0; srcIndex < numVertices; ++srcIndex)
+            return usage;
+        }
+        // Get neighbors for a vertex
+        template <typename Key = VertexType>
+        std::set<VertexType> getNeighbors(const Key &vertex) const
+        {
+            detail::ScopedProbe probe(InstrumentedOperation::GetNeighbors);
+            size_t vertexIndex = checkHandle(requireVertex(vertex));
+
+            // Using a set to store neighbors
+            std::set<VertexType> neighbors;
+
+            // undirected edges are stored in both directions, so the row alone has every neighbor
+            for (size_t destIndex = adjacencyMatrix.nextInRow(vertexIndex, 0, numVertices);
+                 destIndex < numVertices;
+                 destIndex = adjacencyMatrix.nextInRow(vertexIndex, destIndex + 1, numVertices))
             {
-                if (adjacencyMatrix[getIndex(srcIndex, vertexIndex)].has_value())
-                {
-                    indegree++;
-                }
+                neighbors.insert(indexToVertex[destIndex]);
             }
-            return indegree;
+
+            return neighbors;
         }
-        // Get outdegree for a vertex
-        [[nodiscard]] size_t outdegree(const VertexType& vertex) const
+
+        // Neighbor handles in index order, one allocation and no vertex copies.
+        std::vector<VertexHandle> getNeighbors(VertexHandle vertex) const
         {
-            if (!vertexToIndex.count(vertex))
+            detail::ScopedProbe probe(InstrumentedOperation::GetNeighbors);
+            size_t vertexIndex = checkHandle(vertex);
+
+            std::vector<VertexHandle> neighbors;
+            for (size_t destIndex = adjacencyMatrix.nextInRow(vertexIndex, 0, numVertices);
+                 destIndex < numVertices;
+                 destIndex = adjacencyMatrix.nextInRow(vertexIndex, destIndex + 1, numVertices))
             {
-                throw std::invalid_argument("Vertex does not exist in the graph");
+                neighbors.emplace_back(destIndex);
             }
-            if (!isDirected)
+            return neighbors;
+        }
+
+        // Lazy views straight over the matrix: no allocation and no copies of vertices or edges.
+        // Like getAllEdges, edges() reports every stored direction of an undirected edge, which
+        // is one (src <= dest) with TriangularEdges. Views are invalidated by any change to the graph.
+        auto edges() const
+        {
+            using Cells = std::conditional_t<triangular, detail::UpperTriangle, detail::EveryCell>;
+            return EdgeView<Storage, VertexType, EdgeType, Cells>(adjacencyMatrix, indexToVertex.data(), numVertices);
+        }
+
+        // Handles of the vertices vertex has an edge to, in index order.
+        auto neighbors(VertexHandle vertex) const
+        {
+            return AdjacencyView<Storage, EdgeType, false, false>(adjacencyMatrix, checkHandle(vertex), numVertices);
+        }
+
+        template <typename Key = VertexType>
+        auto neighbors(const Key &vertex) const
+        {
+            return neighbors(requireVertex(vertex));
+        }
+
+        // AdjacentEdge{dest, value} for every edge leaving vertex.
+        auto outEdges(VertexHandle vertex) const
+        {
+            return AdjacencyView<Storage, EdgeType, false, true>(adjacencyMatrix, checkHandle(vertex), numVertices);
+        }
+
+        // AdjacentEdge{src, value} for every edge entering vertex, a column walk.
+        auto inEdges(VertexHandle vertex) const
+        {
+            return AdjacencyView<Storage, EdgeType, true, true>(adjacencyMatrix, checkHandle(vertex), numVertices);
+        }
+
+        // Calls f(VertexHandle dest, const EdgeType &value) for every outgoing edge of vertex,
+        // undirected edges included; no allocation and no vertex lookups. f may return false to stop.
+        template <typename Fn>
+        void forEachOutEdge(VertexHandle vertex, Fn &&f) const
+        {
+            size_t vertexIndex = checkHandle(vertex);
+            for (size_t destIndex = adjacencyMatrix.nextInRow(vertexIndex, 0, numVertices);
+                 destIndex < numVertices;
+                 destIndex = adjacencyMatrix.nextInRow(vertexIndex, destIndex + 1, numVertices))
             {
-                std::cerr << "\nOutdegree is not defined for undirected graphs. Returning total degree\n";
-                return totalDegree(vertex);
+                if (!detail::keepVisiting(f, VertexHandle(destIndex), adjacencyMatrix.value(vertexIndex, destIndex)))
+                    return;
             }
-            size_t vertexIndex = vertexToIndex.at(vertex);
-            size_t outdegree = 0;
-            for (size_t destIndex = 0; destIndex < numVertices; ++destIndex)
+        }
+
+        // Calls f(VertexHandle src, const EdgeType &value) for every incoming edge of vertex,
+        // a column scan. f may return false to stop.
+        template <typename Fn>
+        void forEachInEdge(VertexHandle vertex, Fn &&f) const
+        {
+            size_t vertexIndex = checkHandle(vertex);
+            for (size_t srcIndex = adjacencyMatrix.nextInColumn(vertexIndex, 0, numVertices);
+                 srcIndex < numVertices;
+                 srcIndex = adjacencyMatrix.nextInColumn(vertexIndex, srcIndex + 1, numVertices))
             {
-                if (adjacencyMatrix[getIndex(vertexIndex, destIndex)].has_value())
-                {
-                    outdegree++;
-                }
+                if (!detail::keepVisiting(f, VertexHandle(srcIndex), adjacencyMatrix.value(srcIndex, vertexIndex)))
+                    return;
             }
-            return outdegree;
         }
-        // Get totalDegree for a vertex
-        [[nodiscard]] size_t totalDegree(const VertexType& vertex) const
+
+        // Streams every simple path from src to dest to visitor(const std::vector<VertexHandle> &path).
+        // The path buffer is reused between calls, copy it to keep it. Returns the number of paths visited.
+        template <typename Visitor>
+        size_t forEachPath(VertexHandle src, VertexHandle dest, Visitor &&visitor, const PathOptions &options = {}) const
         {
-            if (!vertexToIndex.count(vertex))
+            size_t srcIndex = checkHandle(src);
+            size_t destIndex = checkHandle(dest);
+
+            auto advance = [this](size_t vertex, size_t &cursor)
             {
-                throw std::invalid_argument("Vertex does not exist in the graph");
+                size_t next = adjacencyMatrix.nextInRow(vertex, cursor, numVertices);
+                if (next == numVertices)
+                    return detail::noNeighbor;
+                cursor = next + 1;
+                return next;
+            };
+            return detail::enumeratePaths(numVertices, srcIndex, destIndex, options, advance, visitor);
+        }
+
+        template <typename Visitor>
+        size_t forEachPath(const VertexType &src, const VertexType &dest, Visitor &&visitor, const PathOptions &options = {}) const
+        {
+            return forEachPath(requireEndpoint(src), requireEndpoint(dest), visitor, options);
+        }
+
+        // find all paths b/w two vertices
+        std::vector<std::vector<VertexType>> findAllPaths(const VertexType &src, const VertexType &dest, const PathOptions &options = {}) const
+        {
+            std::vector<std::vector<VertexType>> allPaths;
+            forEachPath(src, dest, [&](const std::vector<VertexHandle> &path)
+                        {
+                            std::vector<VertexType> vertices;
+                            vertices.reserve(path.size());
+                            for (const VertexHandle &vertex : path)
+                            {
+                                vertices.push_back(indexToVertex[vertex.index]);
+                            }
+                            allPaths.push_back(std::move(vertices)); },
+                        options);
+            return allPaths;
+        }
+
+        // Writes the graph to a versioned binary file, see Serialization.h. Vertex and edge types
+        // that are not trivially copyable (or std::string) need an Appledore::Serializer.
+        void save(const std::string &path) const
+        {
+            detail::writeGraphFile<VertexType, EdgeType>(path, detail::GraphFileKind::Matrix, isDirected, false, indexToVertex,
+                                                         [this](size_t srcIndex, auto &&emit)
+                                                         {
+                                                             for (size_t destIndex = adjacencyMatrix.nextInRow(srcIndex, 0, numVertices);
+                                                                  destIndex < numVertices;
+                                                                  destIndex = adjacencyMatrix.nextInRow(srcIndex, destIndex + 1, numVertices))
+                                                             {
+                                                                 emit(destIndex, adjacencyMatrix.value(srcIndex, destIndex), isDirected);
+                                                             }
+                                                         });
+        }
+
+        // Builds a graph from a file saved by any graph class with the same direction.
+        // The matrix is sized once and edges are inserted by handle, without vertex lookups.
+        static GraphMatrix load(const std::string &path)
+        {
+            detail::GraphFile<VertexType, EdgeType> file(path);
+            file.requireDirection(std::is_same_v<Direction, DirectedG>);
+
+            GraphMatrix graph;
+            graph.reserveVertices(file.vertexCount());
+            for (const VertexType &vertex : file.readVertices())
+            {
+                graph.addVertex(vertex);
             }
-            if (isDirected)
-                return indegree(vertex) + outdegree(vertex);
-            size_t vertexIndex = vertexToIndex.at(vertex);
-            size_t totaldegree = 0;
-            for (size_t srcIndex = 0; srcIndex < numVertices; ++srcIndex)
+            if (graph.numVertices != file.vertexCount())
+                throw std::runtime_error("Graph file has duplicate vertices");
+
+            const uint64_t *offsets = file.offsets();
+            const uint64_t *targets = file.targets();
+            for (size_t srcIndex = 0; srcIndex < graph.numVertices; ++srcIndex)
             {
-                if (adjacencyMatrix[getIndex(srcIndex, vertexIndex)].has_value())
+                for (size_t entry = offsets[srcIndex]; entry < offsets[srcIndex + 1]; ++entry)
                 {
-                    totaldegree++;
+                    size_t destIndex = static_cast<size_t>(targets[entry]);
+                    // undirected edges are stored from both ends, add each once
+                    if (graph.isDirected || srcIndex <= destIndex)
+                        graph.addEdge(VertexHandle(srcIndex), VertexHandle(destIndex), file.value(entry));
                 }
             }
-            return totaldegree;
+            return graph;
         }
-        // Get neighbors for a vertex
-        std::set<VertexType> getNeighbors(const VertexType& vertex) const
+
+    private:
+        static constexpr size_t npos = VertexIndex::npos;
+
+        VertexIndex vertexToIndex;
+        std::vector<VertexType> indexToVertex;
+        Storage adjacencyMatrix;
+        // per-vertex counts of set cells in its column / row
+        std::vector<size_t> inDegrees;
+        std::vector<size_t> outDegrees;
+        size_t numVertices = 0;
+        bool isDirected;
+        bool isWeighted;
+
+        // Single probe of the vertex index, npos if the vertex is not in the graph.
+        template <typename Key>
+        size_t findIndex(const Key &vertex) const
         {
-            if (!vertexToIndex.count(vertex))
-            {
+            detail::ScopedProbe probe(InstrumentedOperation::VertexLookup);
+            return vertexToIndex.find(vertex, indexToVertex);
+        }
+
+        template <typename Key>
+        VertexHandle requireEndpoint(const Key &vertex) const
+        {
+            size_t index = findIndex(vertex);
+            if (index == npos)
+                throw std::invalid_argument("One or both vertices do not exist");
+            return VertexHandle(index);
+        }
+
+        template <typename Key>
+        VertexHandle requireVertex(const Key &vertex) const
+        {
+            size_t index = findIndex(vertex);
+            if (index == npos)
                 throw std::invalid_argument("Vertex does not exist in the graph");
+            return VertexHandle(index);
+        }
+
+        // Every matrix write goes through these so the degree counters stay exact,
+        // overwriting an existing edge or removing a missing one leaves them unchanged.
+        void countNew(size_t srcIndex, size_t destIndex)
+        {
+            if (!adjacencyMatrix.has(srcIndex, destIndex))
+            {
+                outDegrees[srcIndex]++;
+                inDegrees[destIndex]++;
             }
+        }
 
-            size_t vertexIndex = vertexToIndex.at(vertex);
+        void setCell(size_t srcIndex, size_t destIndex, const EdgeType &edge)
+        {
+            countNew(srcIndex, destIndex);
+            adjacencyMatrix.set(srcIndex, destIndex, edge);
+        }
 
-            // Using a set to store neighbors
-            std::set<VertexType> neighbors;
+        // Both directions of an undirected edge, sharing one value where the storage allows.
+        void setPair(size_t srcIndex, size_t destIndex, const EdgeType &edge)
+        {
+            countNew(srcIndex, destIndex);
+            if (srcIndex != destIndex)
+                countNew(destIndex, srcIndex);
+            adjacencyMatrix.setPair(srcIndex, destIndex, edge);
+        }
 
-            for (size_t destIndex = 0; destIndex < numVertices; ++destIndex)
+        void resetCell(size_t srcIndex, size_t destIndex)
+        {
+            if (adjacencyMatrix.has(srcIndex, destIndex))
             {
-                if (adjacencyMatrix[getIndex(vertexIndex, destIndex)].has_value())
-                {
-                    neighbors.insert(indexToVertex[destIndex]);
-                }
+                outDegrees[srcIndex]--;
+                inDegrees[destIndex]--;
+                adjacencyMatrix.reset(srcIndex, destIndex);
+            }
+        }
 
-                // Check reverse direction only if the graph is undirected
-                if (!isDirected && adjacencyMatrix[getIndex(destIndex, vertexIndex)].has_value())
-                {
-                    neighbors.insert(indexToVertex[destIndex]);
-                }
+        // Undirected pairs are always written together, so one presence check covers both;
+        // triangular storage drops the pair with its first reset.
+        void resetPair(size_t srcIndex, size_t destIndex)
+        {
+            if (!adjacencyMatrix.has(srcIndex, destIndex))
+                return;
+            outDegrees[srcIndex]--;
+            inDegrees[destIndex]--;
+            if (srcIndex != destIndex)
+            {
+                outDegrees[destIndex]--;
+                inDegrees[srcIndex]--;
             }
+            adjacencyMatrix.reset(srcIndex, destIndex);
+            adjacencyMatrix.reset(destIndex, srcIndex);
+        }
 
-            return neighbors;
+        void updateCell(size_t srcIndex, size_t destIndex, const EdgeType &value)
+        {
+            adjacencyMatrix.value(srcIndex, destIndex) = value;
+            if (!isDirected && srcIndex != destIndex && !adjacencyMatrix.shared(srcIndex, destIndex))
+                adjacencyMatrix.value(destIndex, srcIndex) = value;
         }
 
-        // find all paths b/w two vertices
-        std::vector<std::vector<VertexType>> findAllPaths(const VertexType &src, const VertexType &dest)
+        template <typename Range>
+        std::vector<BatchStatus> applyBatch(const Range &range, const BatchOptions &options, detail::BatchKind kind)
         {
-            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
-                throw std::invalid_argument("One or both vertices do not exist");
+            std::vector<std::pair<size_t, size_t>> endpoints;
+            std::vector<BatchStatus> status;
+            auto items = detail::resolveBatch(range, numVertices, options.threads, [this](const auto &key)
+                                              { return findIndex(key); },
+                                              endpoints, status);
+            static_assert(std::tuple_size_v<detail::BatchItem<Range>> >= 2, "batch items are (src, dest[, value]) tuples");
+
+            // pooled slots, packed triangle words and pages are shared between rows: item by item
+            if constexpr (!std::is_same_v<EdgeStorage, InlineEdges>)
+            {
+                for (size_t item = 0; item < items.size(); ++item)
+                {
+                    if (status[item] != BatchStatus::Applied)
+                        continue;
+                    auto [srcIndex, destIndex] = endpoints[item];
+                    if (kind == detail::BatchKind::Add)
+                    {
+                        addEdge(VertexHandle(srcIndex), VertexHandle(destIndex), detail::batchValue<EdgeType>(*items[item]));
+                    }
+                    else if (!adjacencyMatrix.has(srcIndex, destIndex))
+                    {
+                        status[item] = BatchStatus::MissingEdge;
+                    }
+                    else if (kind == detail::BatchKind::Remove)
+                    {
+                        isDirected ? resetCell(srcIndex, destIndex) : resetPair(srcIndex, destIndex);
+                    }
+                    else
+                    {
+                        updateCell(srcIndex, destIndex, detail::batchValue<EdgeType>(*items[item]));
+                    }
+                }
+                return status;
+            }
 
-            std::vector<std::vector<VertexType>> allPaths;
-            std::stack<std::pair<VertexType, std::vector<VertexType>>> stack;
-            std::map<VertexType, bool> visited;
+            // one op per written cell; an undirected edge also writes its mirror in the other row
+            std::vector<detail::CellOp> ops;
+            ops.reserve(items.size() * (isDirected ? 1 : 2));
+            for (size_t item = 0; item < items.size(); ++item)
+            {
+                if (status[item] != BatchStatus::Applied)
+                    continue;
+                auto [srcIndex, destIndex] = endpoints[item];
+                ops.push_back({srcIndex, destIndex, item, false});
+                if (!isDirected && srcIndex != destIndex)
+                    ops.push_back({destIndex, srcIndex, item, true});
+            }
 
-            stack.push({src, {src}});
+            // a worker owns the rows it writes, and with them outDegrees; in-degree changes land in
+            // other workers' columns, so they are summed per worker and merged afterwards
+            size_t workers = detail::parallelWorkers(ops.size(), options.threads);
+            std::vector<std::vector<size_t>> inChanges(workers > 1 ? workers : 0, std::vector<size_t>(workers > 1 ? numVertices : 0, 0));
+            auto countIn = [&](unsigned worker, size_t destIndex, size_t change)
+            {
+                (workers > 1 ? inChanges[worker][destIndex] : inDegrees[destIndex]) += change;
+            };
 
-            while (!stack.empty())
+            detail::applyByRow(ops, numVertices, options.threads, [&](const detail::CellOp &op, unsigned worker)
+                               {
+                                   bool present = adjacencyMatrix.has(op.row, op.column);
+                                   if (kind == detail::BatchKind::Add)
+                                   {
+                                       if (!present)
+                                       {
+                                           outDegrees[op.row]++;
+                                           countIn(worker, op.column, 1);
+                                       }
+                                       adjacencyMatrix.set(op.row, op.column, detail::batchValue<EdgeType>(*items[op.item]));
+                                   }
+                                   else if (!present)
+                                   {
+                                       if (!op.mirror)
+                                           status[op.item] = BatchStatus::MissingEdge;
+                                   }
+                                   else if (kind == detail::BatchKind::Remove)
+                                   {
+                                       outDegrees[op.row]--;
+                                       countIn(worker, op.column, static_cast<size_t>(-1));
+                                       adjacencyMatrix.reset(op.row, op.column);
+                                   }
+                                   else
+                                   {
+                                       adjacencyMatrix.value(op.row, op.column) = detail::batchValue<EdgeType>(*items[op.item]);
+                                   } });
+
+            for (const auto &changes : inChanges)
             {
-                auto [current, currentPath] = stack.top();
-                stack.pop();
-                visited[current] = true;
+                for (size_t vertex = 0; vertex < numVertices; ++vertex)
+                {
+                    inDegrees[vertex] += changes[vertex];
+                }
+            }
+            return status;
+        }
+
+        // Drops the edges of every removed vertex, then moves the highest surviving vertices into
+        // the freed indices below the new count, row, column, degrees and index entry together.
+        void removeIndices(std::vector<size_t> indices)
+        {
+            std::sort(indices.begin(), indices.end());
+            indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
 
-                if (current == dest)
+            for (size_t index : indices)
+            {
+                for (size_t destIndex = adjacencyMatrix.nextInRow(index, 0, numVertices);
+                     destIndex < numVertices;
+                     destIndex = adjacencyMatrix.nextInRow(index, destIndex + 1, numVertices))
                 {
-                    allPaths.push_back(currentPath);
+                    if (isDirected)
+                        resetCell(index, destIndex);
+                    else
+                        resetPair(index, destIndex);
                 }
-                else
+                if (isDirected)
                 {
-                    size_t currentIndex = vertexToIndex[current];
-                    for (size_t i = 0; i < numVertices; ++i)
+                    for (size_t srcIndex = adjacencyMatrix.nextInColumn(index, 0, numVertices);
+                         srcIndex < numVertices;
+                         srcIndex = adjacencyMatrix.nextInColumn(index, srcIndex + 1, numVertices))
                     {
-                        if (adjacencyMatrix[getIndex(currentIndex, i)].has_value())
-                        {
-                            VertexType nextVertex = indexToVertex[i];
-                            if (std::find(currentPath.begin(), currentPath.end(), nextVertex) == currentPath.end())
-                            {
-                                auto newPath = currentPath;
-                                newPath.push_back(nextVertex);
-                                stack.push({nextVertex, newPath});
-                            }
-                        }
+                        resetCell(srcIndex, index);
                     }
                 }
-                visited[current] = false;
+                vertexToIndex.erase(index, indexToVertex);
             }
 
-            return allPaths;
-        }
+            size_t remaining = numVertices - indices.size();
+            auto removed = indices.rbegin();
+            size_t last = numVertices;
+            for (size_t hole : indices)
+            {
+                if (hole >= remaining)
+                    break;
+                // highest index that survives
+                while (removed != indices.rend() && *removed == last - 1)
+                {
+                    ++removed;
+                    --last;
+                }
+                --last;
 
-    private:
-        std::map<VertexType, size_t> vertexToIndex;
-        std::vector<VertexType> indexToVertex;
-        std::vector<std::optional<EdgeInfo<EdgeType>>> adjacencyMatrix;
-        size_t numVertices = 0;
-        bool isDirected;
-        bool isWeighted;
+                adjacencyMatrix.relocate(last, hole, numVertices);
+                vertexToIndex.relocate(last, hole, indexToVertex);
+                indexToVertex[hole] = std::move(indexToVertex[last]);
+                inDegrees[hole] = inDegrees[last];
+                outDegrees[hole] = outDegrees[last];
+            }
+
+            indexToVertex.erase(indexToVertex.begin() + remaining, indexToVertex.end());
+            inDegrees.resize(remaining);
+            outDegrees.resize(remaining);
+            numVertices = remaining;
+        }
 
-        inline size_t getIndex(size_t src, size_t dest) const
+        size_t checkHandle(VertexHandle vertex) const
         {
-            return src * numVertices + dest;
+            if (vertex.index >= numVertices)
+                throw std::invalid_argument("Vertex handle does not belong to the graph");
+            return vertex.index;
         }
     };
 }
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#if __has_include(<version>)
+#include <version>
+#endif
+#if defined(__cpp_lib_ranges)
+#include <ranges>
+#endif
+#include "GraphCommon.h"
+
+namespace Appledore
+{
+    // Items produced by the views below. They refer straight into the graph, so they are only
+    // valid until the graph is modified.
+
+    // An edge seen from one endpoint: the vertex at the other end and the edge value.
+    template <typename EdgeType>
+    struct AdjacentEdge
+    {
+        VertexHandle vertex;
+        const EdgeType &value;
+    };
+
+    // A whole edge, laid out like the tuples of getAllEdges() so `auto [src, dest, edge]` works.
+    template <typename VertexType, typename EdgeType>
+    struct EdgeRef
+    {
+        const VertexType &src;
+        const VertexType &dest;
+        const EdgeType &value;
+    };
+
+    namespace detail
+    {
+#if defined(__cpp_lib_ranges)
+        // With C++20 ranges the views are std::ranges::view and compose with std::views.
+        template <typename Derived>
+        using ViewBase = std::ranges::view_interface<Derived>;
+#else
+        template <typename Derived>
+        struct ViewBase
+        {
+        };
+#endif
+
+        // Which stored cells an EdgeView reports.
+        struct EveryCell
+        {
+            template <typename Storage>
+            static bool keep(const Storage &, size_t, size_t)
+            {
+                return true;
+            }
+        };
+
+        // Triangular undirected storage: each edge once, src <= dest.
+        struct UpperTriangle
+        {
+            template <typename Storage>
+            static bool keep(const Storage &, size_t src, size_t dest)
+            {
+                return src <= dest;
+            }
+        };
+
+        // Mixed graphs: directed cells, and undirected edges once (src <= dest).
+        struct UndirectedOnce
+        {
+            template <typename Storage>
+            static bool keep(const Storage &storage, size_t src, size_t dest)
+            {
+                return src <= dest || storage.isDirected(src, dest);
+            }
+        };
+    }
+
+    // Lazy walk over one row (out-edges) or column (in-edges) of a MatrixStorage, using the
+    // storage's own scan, so bit-packed rows skip 64 empty cells at a time.
+    // WithValue selects AdjacentEdge items, otherwise the view yields VertexHandles.
+    template <typename Storage, typename EdgeType, bool Column, bool WithValue>
+    class AdjacencyView : public detail::ViewBase<AdjacencyView<Storage, EdgeType, Column, WithValue>>
+    {
+    public:
+        using Item = std::conditional_t<WithValue, AdjacentEdge<EdgeType>, VertexHandle>;
+
+        class iterator
+        {
+        public:
+            using value_type = Item;
+            using reference = Item;
+            using difference_type = std::ptrdiff_t;
+            using iterator_category = std::input_iterator_tag;
+            using iterator_concept = std::forward_iterator_tag;
+
+            iterator() = default;
+            iterator(const Storage *storage, size_t line, size_t position, size_t count)
+                : storage(storage), line(line), position(position), count(count) {}
+
+            Item operator*() const
+            {
+                if constexpr (WithValue)
+                    return Item{VertexHandle(position), Column ? storage->value(position, line) : storage->value(line, position)};
+                else
+                    return VertexHandle(position);
+            }
+
+            iterator &operator++()
+            {
+                position = next(*storage, line, position + 1, count);
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            bool operator==(const iterator &other) const
+            {
+                return position == other.position;
+            }
+            bool operator!=(const iterator &other) const
+            {
+                return position != other.position;
+            }
+
+        private:
+            const Storage *storage = nullptr;
+            size_t line = 0;
+            size_t position = 0;
+            size_t count = 0;
+        };
+
+        AdjacencyView() = default;
+        AdjacencyView(const Storage &storage, size_t line, size_t count)
+            : storage(&storage), line(line), count(count) {}
+
+        iterator begin() const
+        {
+            return iterator(storage, line, next(*storage, line, 0, count), count);
+        }
+
+        iterator end() const
+        {
+            return iterator(storage, line, count, count);
+        }
+
+    private:
+        const Storage *storage = nullptr;
+        size_t line = 0;
+        size_t count = 0;
+
+        static size_t next(const Storage &storage, size_t line, size_t from, size_t count)
+        {
+            if constexpr (Column)
+                return storage.nextInColumn(line, from, count);
+            else
+                return storage.nextInRow(line, from, count);
+        }
+    };
+
+    // Lazy walk over every stored edge, row by row.
+    template <typename Storage, typename VertexType, typename EdgeType, typename Cells = detail::EveryCell>
+    class EdgeView : public detail::ViewBase<EdgeView<Storage, VertexType, EdgeType, Cells>>
+    {
+    public:
+        class iterator
+        {
+        public:
+            using value_type = EdgeRef<VertexType, EdgeType>;
+            using reference = EdgeRef<VertexType, EdgeType>;
+            using difference_type = std::ptrdiff_t;
+            using iterator_category = std::input_iterator_tag;
+            using iterator_concept = std::forward_iterator_tag;
+
+            iterator() = default;
+            iterator(const Storage *storage, const VertexType *vertices, size_t count, size_t src, size_t dest)
+                : storage(storage), vertices(vertices), count(count), src(src), dest(dest)
+            {
+                settle();
+            }
+
+            reference operator*() const
+            {
+                return reference{vertices[src], vertices[dest], storage->value(src, dest)};
+            }
+
+            iterator &operator++()
+            {
+                ++dest;
+                settle();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            bool operator==(const iterator &other) const
+            {
+                return src == other.src && dest == other.dest;
+            }
+            bool operator!=(const iterator &other) const
+            {
+                return !(*this == other);
+            }
+
+        private:
+            const Storage *storage = nullptr;
+            const VertexType *vertices = nullptr;
+            size_t count = 0;
+            size_t src = 0;
+            size_t dest = 0;
+
+            // Move to the first kept cell at or after (src, dest); the end is (count, 0).
+            void settle()
+            {
+                while (src < count)
+                {
+                    dest = storage->nextInRow(src, dest, count);
+                    if (dest == count)
+                    {
+                        ++src;
+                        dest = 0;
+                        continue;
+                    }
+                    if (Cells::keep(*storage, src, dest))
+                        return;
+                    ++dest;
+                }
+                dest = 0;
+            }
+        };
+
+        EdgeView() = default;
+        EdgeView(const Storage &storage, const VertexType *vertices, size_t count)
+            : storage(&storage), vertices(vertices), count(count) {}
+
+        iterator begin() const
+        {
+            return iterator(storage, vertices, count, 0, 0);
+        }
+
+        iterator end() const
+        {
+            return iterator(storage, vertices, count, count, 0);
+        }
+
+    private:
+        const Storage *storage = nullptr;
+        const VertexType *vertices = nullptr;
+        size_t count = 0;
+    };
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <cmath>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// Hot-path probes are compiled in only with APPLEDORE_INSTRUMENTATION set to 1, before any
+// Appledore header is included (or -DAPPLEDORE_INSTRUMENTATION=1). Otherwise every probe is an
+// empty inline call and the graphs compile exactly as without this header.
+#ifndef APPLEDORE_INSTRUMENTATION
+#define APPLEDORE_INSTRUMENTATION 0
+#endif
+
+namespace Appledore
+{
+    // Operations the probes record.
+    enum class InstrumentedOperation : uint8_t
+    {
+        // vertex -> index lookups of GraphMatrix and MixedGraphMatrix, batch resolution included
+        VertexLookup,
+        // addEdge once its endpoints are resolved
+        AddEdge,
+        // GraphMatrix::getNeighbors, either overload
+        GetNeighbors,
+        // one forEachPath/findAllPaths call, on any graph class
+        FindAllPaths,
+        // a path extended by one vertex during path enumeration; counted, not timed
+        PathExpansion
+    };
+
+    inline constexpr size_t instrumentedOperationCount = 5;
+
+    inline const char *operationName(InstrumentedOperation operation)
+    {
+        static constexpr const char *names[instrumentedOperationCount] = {
+            "vertexLookup", "addEdge", "getNeighbors", "findAllPaths", "pathExpansion"};
+        return names[static_cast<size_t>(operation)];
+    }
+
+    struct OperationStats
+    {
+        // histogram[k] counts calls that took [2^k, 2^(k+1)) ns; bucket 0 also holds 0 ns.
+        static constexpr size_t buckets = 40;
+
+        uint64_t calls = 0;
+        uint64_t totalNanoseconds = 0;
+        std::array<uint64_t, buckets> histogram{};
+
+        double meanNanoseconds() const
+        {
+            uint64_t timed = 0;
+            for (uint64_t count : histogram)
+            {
+                timed += count;
+            }
+            return timed ? static_cast<double>(totalNanoseconds) / timed : 0.0;
+        }
+
+        // Upper bound of the bucket holding the q-quantile (0 <= q <= 1) of timed calls.
+        uint64_t percentileNanoseconds(double q) const
+        {
+            uint64_t timed = 0;
+            for (uint64_t count : histogram)
+            {
+                timed += count;
+            }
+            if (timed == 0)
+                return 0;
+            uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * timed)));
+            uint64_t seen = 0;
+            for (size_t bucket = 0; bucket < buckets; ++bucket)
+            {
+                seen += histogram[bucket];
+                if (seen >= rank)
+                    return (uint64_t(1) << (bucket + 1)) - 1;
+            }
+            return (uint64_t(1) << buckets) - 1;
+        }
+    };
+
+    // Snapshot of the process-wide counters, see instrumentationReport().
+    struct InstrumentationReport
+    {
+        // false when built without APPLEDORE_INSTRUMENTATION; every counter is then 0
+        bool enabled = APPLEDORE_INSTRUMENTATION != 0;
+        std::array<OperationStats, instrumentedOperationCount> operations{};
+
+        const OperationStats &operator[](InstrumentedOperation operation) const
+        {
+            return operations[static_cast<size_t>(operation)];
+        }
+
+        // {"enabled": ..., "operations": {"vertexLookup": {"calls", "totalNanoseconds", "meanNanoseconds",
+        // "p50Nanoseconds", "p99Nanoseconds", "histogram": [...]}, ...}}; the histogram is cut
+        // after its last non-empty bucket.
+        std::string toJson() const
+        {
+            std::ostringstream out;
+            out << "{\"enabled\": " << (enabled ? "true" : "false") << ", \"operations\": {";
+            for (size_t index = 0; index < instrumentedOperationCount; ++index)
+            {
+                const OperationStats &stats = operations[index];
+                out << (index ? ", " : "") << "\"" << operationName(static_cast<InstrumentedOperation>(index))
+                    << "\": {\"calls\": " << stats.calls << ", \"totalNanoseconds\": " << stats.totalNanoseconds
+                    << ", \"meanNanoseconds\": " << stats.meanNanoseconds()
+                    << ", \"p50Nanoseconds\": " << stats.percentileNanoseconds(0.5)
+                    << ", \"p99Nanoseconds\": " << stats.percentileNanoseconds(0.99) << ", \"histogram\": [";
+                size_t used = OperationStats::buckets;
+                while (used > 0 && stats.histogram[used - 1] == 0)
+                {
+                    --used;
+                }
+                for (size_t bucket = 0; bucket < used; ++bucket)
+                {
+                    out << (bucket ? ", " : "") << stats.histogram[bucket];
+                }
+                out << "]}";
+            }
+            out << "}}";
+            return out.str();
+        }
+    };
+
+    // Heap bytes a matrix graph holds, by component, from memoryUsage(). Sizes follow
+    // capacities, not contents; memory owned by vertex or edge values themselves (a
+    // std::string's buffer, say) is not included.
+    struct MemoryUsage
+    {
+        // adjacency bitmaps and edge values, for the allocated vertex capacity
+        size_t matrixBytes = 0;
+        // vertex -> index lookup; estimated for OrderedVertexIndex
+        size_t indexBytes = 0;
+        // the index -> vertex vector
+        size_t vertexBytes = 0;
+        // per-vertex degree counters
+        size_t degreeBytes = 0;
+        size_t vertexCount = 0;
+        size_t vertexCapacity = 0;
+        // set cells of the vertexCount x vertexCount adjacency matrix; an undirected edge sets two
+        size_t storedCells = 0;
+
+        size_t totalBytes() const
+        {
+            return matrixBytes + indexBytes + vertexBytes + degreeBytes;
+        }
+
+        // storedCells / vertexCount^2: how much of the matrix holds edges.
+        double fillRatio() const
+        {
+            return vertexCount ? static_cast<double>(storedCells) / (static_cast<double>(vertexCount) * vertexCount) : 0.0;
+        }
+
+        std::string toJson() const
+        {
+            std::ostringstream out;
+            out << "{\"matrixBytes\": " << matrixBytes << ", \"indexBytes\": " << indexBytes
+                << ", \"vertexBytes\": " << vertexBytes << ", \"degreeBytes\": " << degreeBytes
+                << ", \"totalBytes\": " << totalBytes() << ", \"vertexCount\": " << vertexCount
+                << ", \"vertexCapacity\": " << vertexCapacity << ", \"storedCells\": " << storedCells
+                << ", \"fillRatio\": " << fillRatio() << "}";
+            return out.str();
+        }
+    };
+
+    namespace detail
+    {
+        // Relaxed atomics, one cache line per operation so different operations never contend.
+        struct alignas(64) OperationCounters
+        {
+            std::atomic<uint64_t> calls;
+            std::atomic<uint64_t> totalNanoseconds;
+            std::array<std::atomic<uint64_t>, OperationStats::buckets> histogram;
+        };
+
+        // Static storage, so zero-initialized before any probe runs.
+        inline std::array<OperationCounters, instrumentedOperationCount> operationCounters;
+
+        inline void recordLatency(InstrumentedOperation operation, uint64_t nanoseconds)
+        {
+            OperationCounters &counters = operationCounters[static_cast<size_t>(operation)];
+            size_t bucket = 0;
+            for (uint64_t rest = nanoseconds; rest > 1 && bucket + 1 < OperationStats::buckets; rest >>= 1)
+            {
+                ++bucket;
+            }
+            counters.calls.fetch_add(1, std::memory_order_relaxed);
+            counters.totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+            counters.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+
+#if APPLEDORE_INSTRUMENTATION
+        // Times its scope and records it under one operation.
+        class ScopedProbe
+        {
+        public:
+            explicit ScopedProbe(InstrumentedOperation operation)
+                : operation(operation), start(std::chrono::steady_clock::now()) {}
+
+            ScopedProbe(const ScopedProbe &) = delete;
+            ScopedProbe &operator=(const ScopedProbe &) = delete;
+
+            ~ScopedProbe()
+            {
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                recordLatency(operation, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+
+        private:
+            InstrumentedOperation operation;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        // Adds untimed calls, for events too fine to time one by one.
+        inline void countOperation(InstrumentedOperation operation, uint64_t calls)
+        {
+            if (calls)
+                operationCounters[static_cast<size_t>(operation)].calls.fetch_add(calls, std::memory_order_relaxed);
+        }
+#else
+        class ScopedProbe
+        {
+        public:
+            explicit constexpr ScopedProbe(InstrumentedOperation) {}
+        };
+
+        inline void countOperation(InstrumentedOperation, uint64_t) {}
+#endif
+    }
+
+    // Counters of every graph in the process since start or the last resetInstrumentation().
+    // Safe to call while other threads run probes; each counter is read atomically, but the
+    // report as a whole is not one instant.
+    inline InstrumentationReport instrumentationReport()
+    {
+        InstrumentationReport report;
+        for (size_t index = 0; index < instrumentedOperationCount; ++index)
+        {
+            const detail::OperationCounters &counters = detail::operationCounters[index];
+            OperationStats &stats = report.operations[index];
+            stats.calls = counters.calls.load(std::memory_order_relaxed);
+            stats.totalNanoseconds = counters.totalNanoseconds.load(std::memory_order_relaxed);
+            for (size_t bucket = 0; bucket < OperationStats::buckets; ++bucket)
+            {
+                stats.histogram[bucket] = counters.histogram[bucket].load(std::memory_order_relaxed);
+            }
+        }
+        return report;
+    }
+
+    inline void resetInstrumentation()
+    {
+        for (detail::OperationCounters &counters : detail::operationCounters)
+        {
+            counters.calls.store(0, std::memory_order_relaxed);
+            counters.totalNanoseconds.store(0, std::memory_order_relaxed);
+            for (std::atomic<uint64_t> &count : counters.histogram)
+            {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
@@ -0,0 +1,1462 @@
+#pragma once
+
+#include <vector>
+#include <new>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <optional>
+#include <stdexcept>
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#if __has_include(<bit>)
+#include <bit>
+#endif
+#include "GraphCommon.h"
+
+namespace Appledore
+{
+    namespace detail
+    {
+        inline size_t popcount64(uint64_t word)
+        {
+#if defined(__cpp_lib_bitops)
+            return static_cast<size_t>(std::popcount(word));
+#elif defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(__builtin_popcountll(word));
+#else
+            return std::bitset<64>(word).count();
+#endif
+        }
+
+        // Index of the lowest set bit, word must be non-zero.
+        inline size_t countTrailingZeros64(uint64_t word)
+        {
+#if defined(__cpp_lib_bitops)
+            return static_cast<size_t>(std::countr_zero(word));
+#elif defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(__builtin_ctzll(word));
+#else
+            size_t bit = 0;
+            while (!(word & 1))
+            {
+                word >>= 1;
+                ++bit;
+            }
+            return bit;
+#endif
+        }
+
+        // Number of bits needed to represent word, 0 for 0.
+        inline size_t bitWidth64(uint64_t word)
+        {
+#if defined(__cpp_lib_bitops)
+            return static_cast<size_t>(std::bit_width(word));
+#elif defined(__GNUC__) || defined(__clang__)
+            return word == 0 ? 0 : 64 - static_cast<size_t>(__builtin_clzll(word));
+#else
+            size_t width = 0;
+            while (word)
+            {
+                word >>= 1;
+                ++width;
+            }
+            return width;
+#endif
+        }
+
+        // Presence bits, plus directed flags when TrackDirection, one bit per cell with rows
+        // padded to 64-bit words. The row stride is the allocated vertex capacity, not the
+        // vertex count, so adding a vertex within capacity touches nothing and growing keeps
+        // every cell at its (src, dest).
+        template <bool TrackDirection>
+        class CellBits
+        {
+        public:
+            CellBits() = default;
+            CellBits(const CellBits &) = default;
+            CellBits &operator=(const CellBits &) = default;
+            // a moved-from plane is left empty, not with a stale stride
+            CellBits(CellBits &&other) noexcept
+                : bits(std::move(other.bits)), directedBits(std::move(other.directedBits)),
+                  stride(std::exchange(other.stride, 0)), wordsPerRow(std::exchange(other.wordsPerRow, 0)) {}
+            CellBits &operator=(CellBits &&other) noexcept
+            {
+                bits = std::move(other.bits);
+                directedBits = std::move(other.directedBits);
+                stride = std::exchange(other.stride, 0);
+                wordsPerRow = std::exchange(other.wordsPerRow, 0);
+                return *this;
+            }
+
+            size_t capacity() const
+            {
+                return stride;
+            }
+
+            // Heap bytes held by the bitmaps.
+            size_t memoryBytes() const
+            {
+                return (bits.capacity() + directedBits.capacity()) * sizeof(uint64_t);
+            }
+
+            // Make room for at least `vertices` rows/columns, exactly.
+            void reserve(size_t vertices)
+            {
+                if (vertices <= stride)
+                    return;
+
+                size_t grownWords = (vertices + 63) / 64;
+                bits = regrow(bits, grownWords, vertices);
+                if (TrackDirection)
+                {
+                    directedBits = regrow(directedBits, grownWords, vertices);
+                }
+                wordsPerRow = grownWords;
+                stride = vertices;
+            }
+
+            bool has(size_t src, size_t dest) const
+            {
+                return testBit(bits, src, dest);
+            }
+
+            bool isDirected(size_t src, size_t dest) const
+            {
+                return TrackDirection && testBit(directedBits, src, dest);
+            }
+
+            void mark(size_t src, size_t dest, bool isDirected)
+            {
+                bits[wordIndex(src, dest)] |= bitMask(dest);
+                if (TrackDirection)
+                {
+                    if (isDirected)
+                        directedBits[wordIndex(src, dest)] |= bitMask(dest);
+                    else
+                        directedBits[wordIndex(src, dest)] &= ~bitMask(dest);
+                }
+            }
+
+            void clear(size_t src, size_t dest)
+            {
+                bits[wordIndex(src, dest)] &= ~bitMask(dest);
+                if (TrackDirection)
+                {
+                    directedBits[wordIndex(src, dest)] &= ~bitMask(dest);
+                }
+            }
+
+            // Popcount over the packed row; cells past the vertex count are never set.
+            size_t countRow(size_t src, size_t) const
+            {
+                const uint64_t *row = bits.data() + src * wordsPerRow;
+                size_t count = 0;
+                for (size_t word = 0; word < wordsPerRow; ++word)
+                {
+                    count += popcount64(row[word]);
+                }
+                return count;
+            }
+
+            size_t countColumn(size_t dest, size_t n) const
+            {
+                size_t count = 0;
+                for (size_t src = 0; src < n; ++src)
+                {
+                    count += has(src, dest) ? 1 : 0;
+                }
+                return count;
+            }
+
+            // Bit-scan: skips 64 empty cells per word.
+            size_t nextInRow(size_t src, size_t from, size_t n) const
+            {
+                if (from >= n)
+                    return n;
+
+                const uint64_t *row = bits.data() + src * wordsPerRow;
+                size_t word = from / 64;
+                uint64_t current = row[word] & (~uint64_t(0) << (from % 64));
+                while (true)
+                {
+                    if (current)
+                    {
+                        size_t dest = word * 64 + countTrailingZeros64(current);
+                        return dest < n ? dest : n;
+                    }
+                    if (++word >= wordsPerRow || word * 64 >= n)
+                        return n;
+                    current = row[word];
+                }
+            }
+
+            size_t nextInColumn(size_t dest, size_t from, size_t n) const
+            {
+                while (from < n && !has(from, dest))
+                {
+                    ++from;
+                }
+                return from;
+            }
+
+            // Calls fn(src, dest) for every set cell.
+            template <typename Fn>
+            void forEachCell(Fn &&fn) const
+            {
+                for (size_t src = 0; src < stride; ++src)
+                {
+                    for (size_t dest = nextInRow(src, 0, stride); dest < stride; dest = nextInRow(src, dest + 1, stride))
+                    {
+                        fn(src, dest);
+                    }
+                }
+            }
+
+            // Moves row and column `from` into the empty row and column `to`, calling
+            // moveValue(src, dest, toSrc, toDest) for every set cell before its bits move.
+            template <typename Fn>
+            void relocateVertex(size_t from, size_t to, size_t n, Fn &&moveValue)
+            {
+                auto move = [&](size_t src, size_t dest, size_t toSrc, size_t toDest)
+                {
+                    moveValue(src, dest, toSrc, toDest);
+                    mark(toSrc, toDest, isDirected(src, dest));
+                    clear(src, dest);
+                };
+                for (size_t dest = nextInRow(from, 0, n); dest < n; dest = nextInRow(from, dest + 1, n))
+                {
+                    move(from, dest, to, dest == from ? to : dest);
+                }
+                // the diagonal went with the row
+                for (size_t src = nextInColumn(from, 0, n); src < n; src = nextInColumn(from, src + 1, n))
+                {
+                    move(src, from, src, to);
+                }
+            }
+
+        private:
+            std::vector<uint64_t> bits;
+            std::vector<uint64_t> directedBits;
+            size_t stride = 0;
+            size_t wordsPerRow = 0;
+
+            static uint64_t bitMask(size_t dest)
+            {
+                return uint64_t(1) << (dest % 64);
+            }
+
+            inline size_t wordIndex(size_t src, size_t dest) const
+            {
+                return src * wordsPerRow + dest / 64;
+            }
+
+            bool testBit(const std::vector<uint64_t> &words, size_t src, size_t dest) const
+            {
+                return (words[wordIndex(src, dest)] & bitMask(dest)) != 0;
+            }
+
+            std::vector<uint64_t> regrow(const std::vector<uint64_t> &words, size_t grownWords, size_t vertices) const
+            {
+                std::vector<uint64_t> grown(grownWords * vertices, 0);
+                for (size_t row = 0; row < stride; ++row)
+                {
+                    std::copy(words.begin() + row * wordsPerRow,
+                              words.begin() + (row + 1) * wordsPerRow,
+                              grown.begin() + row * grownWords);
+                }
+                return grown;
+            }
+        };
+
+        // Presence bits of a symmetric matrix, upper triangle only: cell (i, j) with i <= j is
+        // bit j * (j + 1) / 2 + i, so column j's cells are contiguous and the layout does not
+        // depend on the capacity. Every query accepts either orientation of a cell.
+        class TriangleBits
+        {
+        public:
+            size_t capacity() const
+            {
+                return stride;
+            }
+
+            size_t memoryBytes() const
+            {
+                return bits.capacity() * sizeof(uint64_t);
+            }
+
+            void reserve(size_t vertices)
+            {
+                if (vertices <= stride)
+                    return;
+                bits.resize((cellsFor(vertices) + 63) / 64, 0);
+                stride = vertices;
+            }
+
+            static size_t cellsFor(size_t vertices)
+            {
+                return vertices * (vertices + 1) / 2;
+            }
+
+            static size_t cell(size_t src, size_t dest)
+            {
+                if (src > dest)
+                    std::swap(src, dest);
+                return dest * (dest + 1) / 2 + src;
+            }
+
+            bool has(size_t src, size_t dest) const
+            {
+                return test(cell(src, dest));
+            }
+
+            bool isDirected(size_t, size_t) const
+            {
+                return false;
+            }
+
+            void mark(size_t src, size_t dest)
+            {
+                markCell(cell(src, dest));
+            }
+
+            void markCell(size_t bit)
+            {
+                bits[bit / 64] |= uint64_t(1) << (bit % 64);
+            }
+
+            void clear(size_t src, size_t dest)
+            {
+                size_t bit = cell(src, dest);
+                bits[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+            }
+
+            // Row src is the packed column (c, src) for c <= src, then one probe per later column.
+            size_t countRow(size_t src, size_t n) const
+            {
+                size_t count = 0;
+                for (size_t dest = nextInRow(src, 0, n); dest < n; dest = nextInRow(src, dest + 1, n))
+                {
+                    count++;
+                }
+                return count;
+            }
+
+            size_t countColumn(size_t dest, size_t n) const
+            {
+                return countRow(dest, n);
+            }
+
+            size_t nextInRow(size_t src, size_t from, size_t n) const
+            {
+                if (from <= src)
+                {
+                    size_t base = cellsFor(src);
+                    size_t bit = nextSetBit(base + from, base + src + 1);
+                    if (bit <= base + src)
+                        return bit - base;
+                    from = src + 1;
+                }
+                for (; from < n; ++from)
+                {
+                    if (test(cellsFor(from) + src))
+                        return from;
+                }
+                return n;
+            }
+
+            size_t nextInColumn(size_t dest, size_t from, size_t n) const
+            {
+                return nextInRow(dest, from, n);
+            }
+
+            // Calls fn(cell) for every set cell index.
+            template <typename Fn>
+            void forEachCell(Fn &&fn) const
+            {
+                size_t end = cellsFor(stride);
+                for (size_t bit = nextSetBit(0, end); bit < end; bit = nextSetBit(bit + 1, end))
+                {
+                    fn(bit);
+                }
+            }
+
+            // Row and column are the same cells here, so one row walk moves the vertex; calls
+            // moveValue(cell, toCell) for every set cell before its bit moves.
+            template <typename Fn>
+            void relocateVertex(size_t from, size_t to, size_t n, Fn &&moveValue)
+            {
+                for (size_t dest = nextInRow(from, 0, n); dest < n; dest = nextInRow(from, dest + 1, n))
+                {
+                    size_t source = cell(from, dest);
+                    size_t target = cell(to, dest == from ? to : dest);
+                    moveValue(source, target);
+                    markCell(target);
+                    bits[source / 64] &= ~(uint64_t(1) << (source % 64));
+                }
+            }
+
+        private:
+            std::vector<uint64_t> bits;
+            size_t stride = 0;
+
+            bool test(size_t bit) const
+            {
+                return (bits[bit / 64] >> (bit % 64)) & 1;
+            }
+
+            // First set bit in [from, end), end if there is none.
+            size_t nextSetBit(size_t from, size_t end) const
+            {
+                if (from >= end)
+                    return end;
+                size_t word = from / 64;
+                uint64_t current = bits[word] & (~uint64_t(0) << (from % 64));
+                while (true)
+                {
+                    if (current)
+                    {
+                        size_t bit = word * 64 + countTrailingZeros64(current);
+                        return bit < end ? bit : end;
+                    }
+                    if (++word * 64 >= end)
+                        return end;
+                    current = bits[word];
+                }
+            }
+        };
+    }
+
+    // Edge storage policies, the last template parameter of GraphMatrix and MixedGraphMatrix.
+    // InlineEdges keeps each value in a matrix-shaped array next to its cell.
+    struct InlineEdges
+    {
+    };
+    // PooledEdges keeps values in a dense pool and only a 32-bit slot id per cell; both
+    // directions of an undirected edge share one pooled value. Pays off for large edge types.
+    struct PooledEdges
+    {
+    };
+    // TriangularEdges, for undirected GraphMatrix only, keeps the upper triangle of the
+    // symmetric matrix: half the memory, and an edge is one cell however it is addressed.
+    struct TriangularEdges
+    {
+    };
+    // PagedEdges cuts the matrix into pages of 64 rows that copies of a graph share, cloning a
+    // page on its first write: copying costs one reference per page, and changing a few edges
+    // of the copy clones only their pages. Suits ConcurrentGraph, whose update() copies the graph.
+    struct PagedEdges
+    {
+    };
+
+    template <typename EdgeType, bool TrackDirection = false, typename Policy = InlineEdges>
+    class MatrixStorage;
+
+    // Square adjacency storage shared by GraphMatrix and MixedGraphMatrix, laid out as
+    // structure of arrays: presence (and, with TrackDirection, directed) bitmaps answer
+    // has/isDirected and drive every scan at one bit per cell, while edge values sit in a
+    // separate raw array whose slots are constructed only while their edge exists.
+    // TrackDirection keeps the directed flags, which only MixedGraphMatrix needs.
+    template <typename EdgeType, bool TrackDirection, typename Policy>
+    class MatrixStorage : private detail::CellBits<TrackDirection>
+    {
+        static_assert(std::is_same_v<Policy, InlineEdges>, "TriangularEdges is only available for undirected GraphMatrix");
+
+        using Bits = detail::CellBits<TrackDirection>;
+
+    public:
+        using Bits::capacity;
+        using Bits::countColumn;
+        using Bits::countRow;
+        using Bits::has;
+        using Bits::isDirected;
+        using Bits::nextInColumn;
+        using Bits::nextInRow;
+
+        MatrixStorage() = default;
+
+        // Delegates so that a throwing copy destroys the values built so far.
+        MatrixStorage(const MatrixStorage &other) : MatrixStorage()
+        {
+            reserve(other.capacity());
+            other.forEachCell([&](size_t src, size_t dest)
+                              { set(src, dest, other.value(src, dest), other.isDirected(src, dest)); });
+        }
+
+        MatrixStorage(MatrixStorage &&other) noexcept
+            : Bits(std::move(static_cast<Bits &>(other))), values(std::move(other.values)) {}
+
+        MatrixStorage &operator=(MatrixStorage other) noexcept
+        {
+            std::swap(static_cast<Bits &>(*this), static_cast<Bits &>(other));
+            std::swap(values, other.values);
+            return *this;
+        }
+
+        ~MatrixStorage()
+        {
+            destroyAll();
+        }
+
+        // Make room for at least `vertices` rows/columns, exactly. Live values move to their
+        // new slots; untouched slots of the fresh array are never written.
+        void reserve(size_t vertices)
+        {
+            size_t stride = capacity();
+            if (vertices <= stride)
+                return;
+
+            std::unique_ptr<Slot[]> grown(new Slot[vertices * vertices]);
+            this->forEachCell([&](size_t src, size_t dest)
+                              {
+                                  EdgeType &old = at(values.get(), src * stride + dest);
+                                  ::new (static_cast<void *>(&grown[src * vertices + dest])) EdgeType(std::move(old));
+                                  old.~EdgeType(); });
+            values = std::move(grown);
+            Bits::reserve(vertices);
+        }
+
+        // Geometric growth used by addVertex, amortized O(1) copies per cell.
+        void ensure(size_t vertices)
+        {
+            if (vertices <= capacity())
+                return;
+            reserve(std::max(vertices, capacity() * 2));
+        }
+
+        // Only valid where has(src, dest).
+        const EdgeType &value(size_t src, size_t dest) const
+        {
+            return at(values.get(), src * capacity() + dest);
+        }
+
+        EdgeType &value(size_t src, size_t dest)
+        {
+            return at(values.get(), src * capacity() + dest);
+        }
+
+        void set(size_t src, size_t dest, const EdgeType &value, bool isDirected = false)
+        {
+            if (has(src, dest))
+                this->value(src, dest) = value;
+            else
+                ::new (static_cast<void *>(&values[src * capacity() + dest])) EdgeType(value);
+            this->mark(src, dest, isDirected);
+        }
+
+        void reset(size_t src, size_t dest)
+        {
+            if (!has(src, dest))
+                return;
+            value(src, dest).~EdgeType();
+            this->clear(src, dest);
+        }
+
+        // Both directions of an undirected edge; here simply two copies.
+        void setPair(size_t src, size_t dest, const EdgeType &value, bool isDirected = false)
+        {
+            set(src, dest, value, isDirected);
+            if (src != dest)
+                set(dest, src, value, isDirected);
+        }
+
+        // Whether (src, dest) and (dest, src) share one stored value.
+        bool shared(size_t, size_t) const
+        {
+            return false;
+        }
+
+        // Heap bytes held: bitmaps plus the value array, sized by capacity.
+        size_t memoryBytes() const
+        {
+            return Bits::memoryBytes() + capacity() * capacity() * sizeof(Slot);
+        }
+
+        // Moves vertex `from` (row and column) into index `to`, whose row and column must be
+        // empty; used by vertex removal. O(V) cells, values are moved, not copied.
+        void relocate(size_t from, size_t to, size_t n)
+        {
+            this->relocateVertex(from, to, n, [&](size_t src, size_t dest, size_t toSrc, size_t toDest)
+                                 {
+                                     EdgeType &old = value(src, dest);
+                                     ::new (static_cast<void *>(&values[toSrc * capacity() + toDest])) EdgeType(std::move(old));
+                                     old.~EdgeType(); });
+        }
+
+    private:
+        // Uninitialized room for one value.
+        struct Slot
+        {
+            alignas(EdgeType) unsigned char bytes[sizeof(EdgeType)];
+        };
+
+        std::unique_ptr<Slot[]> values;
+
+        static EdgeType &at(Slot *slots, size_t index)
+        {
+            return *std::launder(reinterpret_cast<EdgeType *>(&slots[index]));
+        }
+
+        void destroyAll()
+        {
+            if constexpr (!std::is_trivially_destructible_v<EdgeType>)
+            {
+                this->forEachCell([&](size_t src, size_t dest)
+                                  { value(src, dest).~EdgeType(); });
+            }
+        }
+    };
+
+    // Cells hold 32-bit slot ids into a pool of values, so an empty cell costs 4 bytes whatever
+    // the edge type. Slots are reference counted: setPair stores one value for both directions,
+    // and set() on a shared slot gives the cell its own copy first. Freed slots are reused.
+    template <typename EdgeType, bool TrackDirection>
+    class MatrixStorage<EdgeType, TrackDirection, PooledEdges> : private detail::CellBits<TrackDirection>
+    {
+        using Bits = detail::CellBits<TrackDirection>;
+
+    public:
+        using Bits::capacity;
+        using Bits::countColumn;
+        using Bits::countRow;
+        using Bits::has;
+        using Bits::isDirected;
+        using Bits::nextInColumn;
+        using Bits::nextInRow;
+
+        MatrixStorage() = default;
+
+        MatrixStorage(const MatrixStorage &other)
+            : Bits(other), pool(other.pool), references(other.references), freeSlots(other.freeSlots)
+        {
+            size_t stride = capacity();
+            slots.reset(new uint32_t[stride * stride]);
+            this->forEachCell([&](size_t src, size_t dest)
+                              { slots[src * stride + dest] = other.slots[src * stride + dest]; });
+        }
+
+        MatrixStorage(MatrixStorage &&other) noexcept = default;
+
+        MatrixStorage &operator=(MatrixStorage other) noexcept
+        {
+            std::swap(static_cast<Bits &>(*this), static_cast<Bits &>(other));
+            std::swap(slots, other.slots);
+            std::swap(pool, other.pool);
+            std::swap(references, other.references);
+            std::swap(freeSlots, other.freeSlots);
+            return *this;
+        }
+
+        // Only the slot ids move; pooled values stay where they are.
+        void reserve(size_t vertices)
+        {
+            size_t stride = capacity();
+            if (vertices <= stride)
+                return;
+
+            std::unique_ptr<uint32_t[]> grown(new uint32_t[vertices * vertices]);
+            this->forEachCell([&](size_t src, size_t dest)
+                              { grown[src * vertices + dest] = slots[src * stride + dest]; });
+            slots = std::move(grown);
+            Bits::reserve(vertices);
+        }
+
+        void ensure(size_t vertices)
+        {
+            if (vertices <= capacity())
+                return;
+            reserve(std::max(vertices, capacity() * 2));
+        }
+
+        // Only valid where has(src, dest). Writing through the reference changes every cell
+        // sharing the slot, i.e. both directions of an undirected edge.
+        const EdgeType &value(size_t src, size_t dest) const
+        {
+            return *pool[slot(src, dest)];
+        }
+
+        EdgeType &value(size_t src, size_t dest)
+        {
+            return *pool[slot(src, dest)];
+        }
+
+        void set(size_t src, size_t dest, const EdgeType &value, bool isDirected = false)
+        {
+            if (has(src, dest) && references[slot(src, dest)] == 1)
+            {
+                *pool[slot(src, dest)] = value;
+            }
+            else
+            {
+                uint32_t id = acquire(value, 1);
+                reset(src, dest);
+                slot(src, dest) = id;
+            }
+            this->mark(src, dest, isDirected);
+        }
+
+        void reset(size_t src, size_t dest)
+        {
+            if (!has(src, dest))
+                return;
+            release(slot(src, dest));
+            this->clear(src, dest);
+        }
+
+        // Both directions of an undirected edge on one pooled value.
+        void setPair(size_t src, size_t dest, const EdgeType &value, bool isDirected = false)
+        {
+            if (src == dest)
+            {
+                set(src, dest, value, isDirected);
+                return;
+            }
+            if (shared(src, dest))
+            {
+                *pool[slot(src, dest)] = value;
+            }
+            else
+            {
+                uint32_t id = acquire(value, 2);
+                reset(src, dest);
+                reset(dest, src);
+                slot(src, dest) = id;
+                slot(dest, src) = id;
+            }
+            this->mark(src, dest, isDirected);
+            this->mark(dest, src, isDirected);
+        }
+
+        bool shared(size_t src, size_t dest) const
+        {
+            return src != dest && has(src, dest) && has(dest, src) && slot(src, dest) == slot(dest, src);
+        }
+
+        // Heap bytes held: bitmaps, slot ids and the value pool, sized by capacity.
+        size_t memoryBytes() const
+        {
+            return Bits::memoryBytes() + capacity() * capacity() * sizeof(uint32_t) +
+                   pool.capacity() * sizeof(std::optional<EdgeType>) +
+                   (references.capacity() + freeSlots.capacity()) * sizeof(uint32_t);
+        }
+
+        // Slot ids move with their cells, so shared pairs stay shared.
+        void relocate(size_t from, size_t to, size_t n)
+        {
+            this->relocateVertex(from, to, n, [&](size_t src, size_t dest, size_t toSrc, size_t toDest)
+                                 { slot(toSrc, toDest) = slot(src, dest); });
+        }
+
+    private:
+        std::unique_ptr<uint32_t[]> slots;
+        // pooled values, empty while their slot is free
+        std::vector<std::optional<EdgeType>> pool;
+        std::vector<uint32_t> references;
+        std::vector<uint32_t> freeSlots;
+
+        uint32_t &slot(size_t src, size_t dest)
+        {
+            return slots[src * capacity() + dest];
+        }
+
+        uint32_t slot(size_t src, size_t dest) const
+        {
+            return slots[src * capacity() + dest];
+        }
+
+        uint32_t acquire(const EdgeType &value, uint32_t count)
+        {
+            uint32_t id;
+            if (!freeSlots.empty())
+            {
+                id = freeSlots.back();
+                pool[id].emplace(value);
+                freeSlots.pop_back();
+            }
+            else
+            {
+                if (pool.size() > UINT32_MAX)
+                    throw std::length_error("Edge pool is limited to 2^32 values");
+                id = static_cast<uint32_t>(pool.size());
+                pool.emplace_back(value);
+                references.push_back(0);
+            }
+            references[id] = count;
+            return id;
+        }
+
+        void release(uint32_t id)
+        {
+            if (--references[id] == 0)
+            {
+                pool[id].reset();
+                freeSlots.push_back(id);
+            }
+        }
+    };
+
+    // Packed upper triangle for undirected graphs. (src, dest) and (dest, src) name the same
+    // cell, so set/reset write once and setPair is set. Growing never moves a cell, only
+    // reallocates the value array. Row scans bit-scan the packed part up to the diagonal and
+    // probe one bit per later column.
+    template <typename EdgeType>
+    class MatrixStorage<EdgeType, false, TriangularEdges> : private detail::TriangleBits
+    {
+        using Bits = detail::TriangleBits;
+
+    public:
+        using Bits::capacity;
+        using Bits::countColumn;
+        using Bits::countRow;
+        using Bits::has;
+        using Bits::isDirected;
+        using Bits::nextInColumn;
+        using Bits::nextInRow;
+
+        MatrixStorage() = default;
+
+        MatrixStorage(const MatrixStorage &other) : MatrixStorage()
+        {
+            reserve(other.capacity());
+            other.forEachCell([&](size_t cell)
+                              {
+                                  ::new (static_cast<void *>(&values[cell])) EdgeType(at(other.values.get(), cell));
+                                  this->markCell(cell); });
+        }
+
+        MatrixStorage(MatrixStorage &&other) noexcept
+            : Bits(std::move(static_cast<Bits &>(other))), values(std::move(other.values))
+        {
+            static_cast<Bits &>(other) = Bits();
+        }
+
+        MatrixStorage &operator=(MatrixStorage other) noexcept
+        {
+            std::swap(static_cast<Bits &>(*this), static_cast<Bits &>(other));
+            std::swap(values, other.values);
+            return *this;
+        }
+
+        ~MatrixStorage()
+        {
+            if constexpr (!std::is_trivially_destructible_v<EdgeType>)
+            {
+                this->forEachCell([&](size_t cell)
+                                  { at(values.get(), cell).~EdgeType(); });
+            }
+        }
+
+        void reserve(size_t vertices)
+        {
+            if (vertices <= capacity())
+                return;
+
+            std::unique_ptr<Slot[]> grown(new Slot[cellsFor(vertices)]);
+            this->forEachCell([&](size_t cell)
+                              {
+                                  EdgeType &old = at(values.get(), cell);
+                                  ::new (static_cast<void *>(&grown[cell])) EdgeType(std::move(old));
+                                  old.~EdgeType(); });
+            values = std::move(grown);
+            Bits::reserve(vertices);
+        }
+
+        void ensure(size_t vertices)
+        {
+            if (vertices <= capacity())
+                return;
+            reserve(std::max(vertices, capacity() * 2));
+        }
+
+        const EdgeType &value(size_t src, size_t dest) const
+        {
+            return at(values.get(), cell(src, dest));
+        }
+
+        EdgeType &value(size_t src, size_t dest)
+        {
+            return at(values.get(), cell(src, dest));
+        }
+
+        void set(size_t src, size_t dest, const EdgeType &value, bool = false)
+        {
+            if (has(src, dest))
+                this->value(src, dest) = value;
+            else
+                ::new (static_cast<void *>(&values[cell(src, dest)])) EdgeType(value);
+            this->mark(src, dest);
+        }
+
+        void reset(size_t src, size_t dest)
+        {
+            if (!has(src, dest))
+                return;
+            value(src, dest).~EdgeType();
+            this->clear(src, dest);
+        }
+
+        void setPair(size_t src, size_t dest, const EdgeType &value, bool = false)
+        {
+            set(src, dest, value);
+        }
+
+        bool shared(size_t src, size_t dest) const
+        {
+            return src != dest && has(src, dest);
+        }
+
+        // Heap bytes held: bitmap plus the value triangle, sized by capacity.
+        size_t memoryBytes() const
+        {
+            return Bits::memoryBytes() + cellsFor(capacity()) * sizeof(Slot);
+        }
+
+        void relocate(size_t from, size_t to, size_t n)
+        {
+            this->relocateVertex(from, to, n, [&](size_t source, size_t target)
+                                 {
+                                     EdgeType &old = at(values.get(), source);
+                                     ::new (static_cast<void *>(&values[target])) EdgeType(std::move(old));
+                                     old.~EdgeType(); });
+        }
+
+    private:
+        struct Slot
+        {
+            alignas(EdgeType) unsigned char bytes[sizeof(EdgeType)];
+        };
+
+        std::unique_ptr<Slot[]> values;
+
+        static EdgeType &at(Slot *slots, size_t index)
+        {
+            return *std::launder(reinterpret_cast<EdgeType *>(&slots[index]));
+        }
+    };
+
+    // Unweighted graphs need nothing beyond the bitmaps.
+    template <bool TrackDirection>
+    class MatrixStorage<UnweightedG, TrackDirection, InlineEdges> : private detail::CellBits<TrackDirection>
+    {
+        using Bits = detail::CellBits<TrackDirection>;
+
+    public:
+        using Bits::capacity;
+        using Bits::countColumn;
+        using Bits::countRow;
+        using Bits::has;
+        using Bits::isDirected;
+        using Bits::memoryBytes;
+        using Bits::nextInColumn;
+        using Bits::nextInRow;
+        using Bits::reserve;
+
+        void ensure(size_t vertices)
+        {
+            if (vertices <= capacity())
+                return;
+            reserve(std::max(vertices, capacity() * 2));
+        }
+
+        const UnweightedG &value(size_t, size_t) const
+        {
+            return unit;
+        }
+
+        UnweightedG &value(size_t, size_t)
+        {
+            return unit;
+        }
+
+        void set(size_t src, size_t dest, const UnweightedG &, bool isDirected = false)
+        {
+            this->mark(src, dest, isDirected);
+        }
+
+        void reset(size_t src, size_t dest)
+        {
+            this->clear(src, dest);
+        }
+
+        void setPair(size_t src, size_t dest, const UnweightedG &, bool isDirected = false)
+        {
+            this->mark(src, dest, isDirected);
+            this->mark(dest, src, isDirected);
+        }
+
+        bool shared(size_t, size_t) const
+        {
+            return false;
+        }
+
+        void relocate(size_t from, size_t to, size_t n)
+        {
+            this->relocateVertex(from, to, n, [](size_t, size_t, size_t, size_t) {});
+        }
+
+    private:
+        inline static UnweightedG unit{};
+    };
+
+    template <>
+    class MatrixStorage<UnweightedG, false, TriangularEdges> : private detail::TriangleBits
+    {
+        using Bits = detail::TriangleBits;
+
+    public:
+        using Bits::capacity;
+        using Bits::countColumn;
+        using Bits::countRow;
+        using Bits::has;
+        using Bits::isDirected;
+        using Bits::memoryBytes;
+        using Bits::nextInColumn;
+        using Bits::nextInRow;
+        using Bits::reserve;
+
+        void ensure(size_t vertices)
+        {
+            if (vertices <= capacity())
+                return;
+            reserve(std::max(vertices, capacity() * 2));
+        }
+
+        const UnweightedG &value(size_t, size_t) const
+        {
+            return unit;
+        }
+
+        UnweightedG &value(size_t, size_t)
+        {
+            return unit;
+        }
+
+        void set(size_t src, size_t dest, const UnweightedG &, bool = false)
+        {
+            this->mark(src, dest);
+        }
+
+        void reset(size_t src, size_t dest)
+        {
+            this->clear(src, dest);
+        }
+
+        void setPair(size_t src, size_t dest, const UnweightedG &, bool = false)
+        {
+            this->mark(src, dest);
+        }
+
+        bool shared(size_t src, size_t dest) const
+        {
+            return src != dest && has(src, dest);
+        }
+
+        void relocate(size_t from, size_t to, size_t n)
+        {
+            this->relocateVertex(from, to, n, [](size_t, size_t) {});
+        }
+
+    private:
+        inline static UnweightedG unit{};
+    };
+
+    // There is no payload to pool either.
+    template <bool TrackDirection>
+    class MatrixStorage<UnweightedG, TrackDirection, PooledEdges> : public MatrixStorage<UnweightedG, TrackDirection, InlineEdges>
+    {
+    };
+
+    // Square matrix in reference-counted pages of pageRows rows, each holding its rows' bits and
+    // values with the full capacity as row stride. Copies share every page; any write first
+    // clones its page unless this storage is the only owner, so a copy that changes k edges
+    // pays for at most 2k pages, not for the whole matrix. Reads cost one more indirection
+    // than InlineEdges.
+    template <typename EdgeType, bool TrackDirection>
+    class MatrixStorage<EdgeType, TrackDirection, PagedEdges>
+    {
+        static constexpr bool hasValues = !std::is_same_v<EdgeType, UnweightedG>;
+        static constexpr size_t pageRows = 64;
+
+        struct Slot
+        {
+            alignas(EdgeType) unsigned char bytes[sizeof(EdgeType)];
+        };
+
+        // Values are constructed only while their presence bit is set.
+        struct Page
+        {
+            // storages holding this page
+            std::atomic<size_t> owners{1};
+            size_t stride;
+            size_t wordsPerRow;
+            std::vector<uint64_t> bits;
+            std::vector<uint64_t> directedBits;
+            std::unique_ptr<Slot[]> values;
+
+            Page(size_t stride, size_t wordsPerRow)
+                : stride(stride), wordsPerRow(wordsPerRow), bits(pageRows * wordsPerRow, 0),
+                  directedBits(TrackDirection ? pageRows * wordsPerRow : 0, 0),
+                  values(hasValues ? new Slot[pageRows * stride] : nullptr) {}
+
+            // A clone; a bit is set only once its value is built, so a throwing copy is undone
+            // by the destructor.
+            Page(const Page &other) : Page(other.stride, other.wordsPerRow)
+            {
+                directedBits = other.directedBits;
+                for (size_t row = 0; row < pageRows; ++row)
+                {
+                    other.forEachInRow(row, [&](size_t dest)
+                                       {
+                                           if constexpr (hasValues)
+                                               ::new (static_cast<void *>(&values[row * stride + dest])) EdgeType(other.value(row, dest));
+                                           bits[row * wordsPerRow + dest / 64] |= uint64_t(1) << (dest % 64); });
+                }
+            }
+
+            Page &operator=(const Page &) = delete;
+
+            ~Page()
+            {
+                if constexpr (hasValues && !std::is_trivially_destructible_v<EdgeType>)
+                {
+                    for (size_t row = 0; row < pageRows; ++row)
+                    {
+                        forEachInRow(row, [&](size_t dest)
+                                     { value(row, dest).~EdgeType(); });
+                    }
+                }
+            }
+
+            EdgeType &value(size_t row, size_t dest) const
+            {
+                return *std::launder(reinterpret_cast<EdgeType *>(&values[row * stride + dest]));
+            }
+
+            template <typename Fn>
+            void forEachInRow(size_t row, Fn &&fn) const
+            {
+                for (size_t word = 0; word < wordsPerRow; ++word)
+                {
+                    for (uint64_t rest = bits[row * wordsPerRow + word]; rest; rest &= rest - 1)
+                    {
+                        fn(word * 64 + detail::countTrailingZeros64(rest));
+                    }
+                }
+            }
+        };
+
+    public:
+        MatrixStorage() = default;
+
+        // Shares every page.
+        MatrixStorage(const MatrixStorage &other)
+            : pages(other.pages), stride(other.stride), wordsPerRow(other.wordsPerRow)
+        {
+            for (Page *page : pages)
+            {
+                page->owners.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        MatrixStorage(MatrixStorage &&other) noexcept
+            : pages(std::move(other.pages)), stride(std::exchange(other.stride, 0)),
+              wordsPerRow(std::exchange(other.wordsPerRow, 0)) {}
+
+        MatrixStorage &operator=(MatrixStorage other) noexcept
+        {
+            std::swap(pages, other.pages);
+            std::swap(stride, other.stride);
+            std::swap(wordsPerRow, other.wordsPerRow);
+            return *this;
+        }
+
+        ~MatrixStorage()
+        {
+            for (Page *page : pages)
+            {
+                release(page);
+            }
+        }
+
+        size_t capacity() const
+        {
+            return stride;
+        }
+
+        // Heap bytes held, pages shared with copies included.
+        size_t memoryBytes() const
+        {
+            size_t bytes = pages.capacity() * sizeof(Page *);
+            for (const auto &entry : pages)
+            {
+                bytes += sizeof(Page) + (entry->bits.capacity() + entry->directedBits.capacity()) * sizeof(uint64_t) +
+                         (hasValues ? pageRows * stride * sizeof(Slot) : 0);
+            }
+            return bytes;
+        }
+
+        // Rebuilds every page at the new stride; values move out of pages no copy shares.
+        void reserve(size_t vertices)
+        {
+            if (vertices <= stride)
+                return;
+
+            size_t grownWords = (vertices + 63) / 64;
+            std::vector<std::unique_ptr<Page>> grown((vertices + pageRows - 1) / pageRows);
+            for (size_t index = 0; index < grown.size(); ++index)
+            {
+                grown[index].reset(new Page(vertices, grownWords));
+                if (index >= pages.size())
+                    continue;
+                Page &fresh = *grown[index];
+                const bool owned = owns(pages[index]);
+                for (size_t row = 0; row < pageRows; ++row)
+                {
+                    pages[index]->forEachInRow(row, [&](size_t dest)
+                                               {
+                                                   if constexpr (hasValues)
+                                                   {
+                                                       EdgeType &old = pages[index]->value(row, dest);
+                                                       if (owned)
+                                                           ::new (static_cast<void *>(&fresh.values[row * vertices + dest])) EdgeType(std::move(old));
+                                                       else
+                                                           ::new (static_cast<void *>(&fresh.values[row * vertices + dest])) EdgeType(old);
+                                                   }
+                                                   fresh.bits[row * grownWords + dest / 64] |= uint64_t(1) << (dest % 64); });
+                    if (TrackDirection)
+                    {
+                        std::copy_n(pages[index]->directedBits.begin() + row * wordsPerRow, wordsPerRow,
+                                    fresh.directedBits.begin() + row * grownWords);
+                    }
+                }
+            }
+            for (Page *page : pages)
+            {
+                release(page);
+            }
+            pages.assign(grown.size(), nullptr);
+            for (size_t index = 0; index < grown.size(); ++index)
+            {
+                pages[index] = grown[index].release();
+            }
+            stride = vertices;
+            wordsPerRow = grownWords;
+        }
+
+        void ensure(size_t vertices)
+        {
+            if (vertices <= capacity())
+                return;
+            reserve(std::max(vertices, capacity() * 2));
+        }
+
+        bool has(size_t src, size_t dest) const
+        {
+            return testBit(page(src).bits, src, dest);
+        }
+
+        bool isDirected(size_t src, size_t dest) const
+        {
+            return TrackDirection && testBit(page(src).directedBits, src, dest);
+        }
+
+        // Only valid where has(src, dest). The mutable overload clones a shared page first.
+        const EdgeType &value(size_t src, size_t dest) const
+        {
+            if constexpr (hasValues)
+                return page(src).value(src % pageRows, dest);
+            else
+                return unit;
+        }
+
+        EdgeType &value(size_t src, size_t dest)
+        {
+            if constexpr (hasValues)
+                return writable(src).value(src % pageRows, dest);
+            else
+                return unit;
+        }
+
+        void set(size_t src, size_t dest, const EdgeType &value, bool isDirected = false)
+        {
+            Page &target = writable(src);
+            if constexpr (hasValues)
+            {
+                if (has(src, dest))
+                    target.value(src % pageRows, dest) = value;
+                else
+                    ::new (static_cast<void *>(&target.values[(src % pageRows) * stride + dest])) EdgeType(value);
+            }
+            mark(target, src, dest, isDirected);
+        }
+
+        void reset(size_t src, size_t dest)
+        {
+            if (!has(src, dest))
+                return;
+            Page &target = writable(src);
+            if constexpr (hasValues)
+                target.value(src % pageRows, dest).~EdgeType();
+            clear(target, src, dest);
+        }
+
+        // Both directions of an undirected edge, two copies as with InlineEdges.
+        void setPair(size_t src, size_t dest, const EdgeType &value, bool isDirected = false)
+        {
+            set(src, dest, value, isDirected);
+            if (src != dest)
+                set(dest, src, value, isDirected);
+        }
+
+        bool shared(size_t, size_t) const
+        {
+            return false;
+        }
+
+        size_t countRow(size_t src, size_t) const
+        {
+            const std::vector<uint64_t> &bits = page(src).bits;
+            size_t count = 0;
+            for (size_t word = 0; word < wordsPerRow; ++word)
+            {
+                count += detail::popcount64(bits[(src % pageRows) * wordsPerRow + word]);
+            }
+            return count;
+        }
+
+        size_t countColumn(size_t dest, size_t n) const
+        {
+            size_t count = 0;
+            for (size_t src = 0; src < n; ++src)
+            {
+                count += has(src, dest) ? 1 : 0;
+            }
+            return count;
+        }
+
+        size_t nextInRow(size_t src, size_t from, size_t n) const
+        {
+            if (from >= n)
+                return n;
+
+            const uint64_t *row = page(src).bits.data() + (src % pageRows) * wordsPerRow;
+            size_t word = from / 64;
+            uint64_t current = row[word] & (~uint64_t(0) << (from % 64));
+            while (true)
+            {
+                if (current)
+                {
+                    size_t dest = word * 64 + detail::countTrailingZeros64(current);
+                    return dest < n ? dest : n;
+                }
+                if (++word >= wordsPerRow || word * 64 >= n)
+                    return n;
+                current = row[word];
+            }
+        }
+
+        size_t nextInColumn(size_t dest, size_t from, size_t n) const
+        {
+            while (from < n && !has(from, dest))
+            {
+                ++from;
+            }
+            return from;
+        }
+
+        // Moves vertex `from` (row and column) into the empty index `to`, see InlineEdges.
+        // Clones the pages of row `to`, row `from` and of every row with a cell in column `from`.
+        void relocate(size_t from, size_t to, size_t n)
+        {
+            auto move = [&](size_t src, size_t dest, size_t toSrc, size_t toDest)
+            {
+                bool directed = isDirected(src, dest);
+                Page &target = writable(toSrc);
+                if constexpr (hasValues)
+                {
+                    EdgeType &old = writable(src).value(src % pageRows, dest);
+                    ::new (static_cast<void *>(&target.values[(toSrc % pageRows) * stride + toDest])) EdgeType(std::move(old));
+                    old.~EdgeType();
+                }
+                mark(target, toSrc, toDest, directed);
+                clear(writable(src), src, dest);
+            };
+            for (size_t dest = nextInRow(from, 0, n); dest < n; dest = nextInRow(from, dest + 1, n))
+            {
+                move(from, dest, to, dest == from ? to : dest);
+            }
+            // the diagonal went with the row
+            for (size_t src = nextInColumn(from, 0, n); src < n; src = nextInColumn(from, src + 1, n))
+            {
+                move(src, from, src, to);
+            }
+        }
+
+    private:
+        std::vector<Page *> pages;
+        size_t stride = 0;
+        size_t wordsPerRow = 0;
+
+        inline static UnweightedG unit{};
+
+        // acquire pairs with release(): a former co-owner's reads of the page happen before
+        // the writes that ownership allows
+        static bool owns(const Page *page)
+        {
+            return page->owners.load(std::memory_order_acquire) == 1;
+        }
+
+        static void release(Page *page)
+        {
+            if (page->owners.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete page;
+        }
+
+        const Page &page(size_t row) const
+        {
+            return *pages[row / pageRows];
+        }
+
+        // The page of row, cloned first if a copy shares it.
+        Page &writable(size_t row)
+        {
+            Page *&owner = pages[row / pageRows];
+            if (!owns(owner))
+            {
+                Page *clone = new Page(*owner);
+                release(owner);
+                owner = clone;
+            }
+            return *owner;
+        }
+
+        bool testBit(const std::vector<uint64_t> &words, size_t src, size_t dest) const
+        {
+            return (words[(src % pageRows) * wordsPerRow + dest / 64] >> (dest % 64)) & 1;
+        }
+
+        void mark(Page &target, size_t src, size_t dest, bool isDirected)
+        {
+            size_t word = (src % pageRows) * wordsPerRow + dest / 64;
+            uint64_t mask = uint64_t(1) << (dest % 64);
+            target.bits[word] |= mask;
+            if (TrackDirection)
+            {
+                if (isDirected)
+                    target.directedBits[word] |= mask;
+                else
+                    target.directedBits[word] &= ~mask;
+            }
+        }
+
+        void clear(Page &target, size_t src, size_t dest)
+        {
+            size_t word = (src % pageRows) * wordsPerRow + dest / 64;
+            uint64_t mask = uint64_t(1) << (dest % 64);
+            target.bits[word] &= ~mask;
+            if (TrackDirection)
+                target.directedBits[word] &= ~mask;
+        }
+    };
+}
@@ -5,209 +5,796 @@
 #include <stdexcept>
 #include <optional>
 #include <map>
+#include <algorithm>
+#include "GraphCommon.h"
+#include "MatrixStorage.h"
+#include "VertexIndex.h"
+#include "GraphViews.h"
+#include "Serialization.h"
+#include "EdgeBatch.h"
+#include "Instrumentation.h"
 
 namespace Appledore
 {
-    template <typename EdgeType>
-    struct EdgeInfo
-    {
-        EdgeType value;
-        bool isDirected;
-
-        EdgeInfo() : value(), isDirected(false) {}
-        EdgeInfo(const EdgeType &value, bool isDirected = false)
-            : value(value), isDirected(isDirected) {}
-    };
-    template <typename VertexType, typename EdgeType = bool>
+    // VertexIndex selects the vertex lookup and EdgeStorage where edge values live, see GraphMatrix.
+    template <typename VertexType, typename EdgeType = bool, typename VertexIndex = DefaultVertexIndex<VertexType>,
+              typename EdgeStorage = InlineEdges>
     class MixedGraphMatrix
     {
+        using Storage = MatrixStorage<EdgeType, true, EdgeStorage>;
+
     public:
-        void addVertex(const VertexType &vertex);
+        using VertexValueType = VertexType;
+        using EdgeValueType = EdgeType;
+
+        VertexHandle addVertex(const VertexType &vertex);
+        void reserveVertices(size_t count);
+        // Removal moves the last vertex into the freed index in O(V); removeVertices compacts
+        // once for the whole batch. Handles past the new vertex count are invalidated.
+        void removeVertex(VertexHandle vertex);
+        template <typename Key = VertexType>
+        void removeVertex(const Key &vertex);
+        void removeVertices(const std::vector<VertexHandle> &vertices);
+        void removeVertices(const std::vector<VertexType> &vertices);
+        template <typename Key = VertexType>
+        std::optional<VertexHandle> findVertex(const Key &vertex) const;
+        const VertexType &getVertex(VertexHandle vertex) const;
         const std::vector<VertexType> &getVertices() const;
-        bool hasEdge(const VertexType &src, const VertexType &dest) const;
-        EdgeType getEdgeValue(const VertexType &src, const VertexType &dest) const;
+        template <typename SrcKey = VertexType, typename DestKey = VertexType>
+        bool hasEdge(const SrcKey &src, const DestKey &dest) const;
+        bool hasEdge(VertexHandle src, VertexHandle dest) const;
+        template <typename SrcKey = VertexType, typename DestKey = VertexType>
+        EdgeType getEdgeValue(const SrcKey &src, const DestKey &dest) const;
+        EdgeType getEdgeValue(VertexHandle src, VertexHandle dest) const;
         std::vector<EdgeType> getEdges() const;
+        // Lazy views over the matrix, invalidated by any change to the graph.
+        // edges() follows getEdges(): directed edges, and undirected edges once.
+        auto edges() const
+        {
+            return EdgeView<Storage, VertexType, EdgeType, detail::UndirectedOnce>(adjacencyMatrix, indexToVertex.data(), numVertices);
+        }
+        auto neighbors(VertexHandle vertex) const
+        {
+            return AdjacencyView<Storage, EdgeType, false, false>(adjacencyMatrix, checkHandle(vertex), numVertices);
+        }
+        auto outEdges(VertexHandle vertex) const
+        {
+            return AdjacencyView<Storage, EdgeType, false, true>(adjacencyMatrix, checkHandle(vertex), numVertices);
+        }
+        auto inEdges(VertexHandle vertex) const
+        {
+            return AdjacencyView<Storage, EdgeType, true, true>(adjacencyMatrix, checkHandle(vertex), numVertices);
+        }
+
+        // Degrees are maintained by every edge mutation, each query is O(1).
+        // indegree: directed edges in plus undirected edges; outdegree: directed edges out plus
+        // undirected edges; totalDegree counts every incident edge once.
+        template <typename Key = VertexType>
+        [[nodiscard]] size_t indegree(const Key &vertex) const;
+        [[nodiscard]] size_t indegree(VertexHandle vertex) const;
+        template <typename Key = VertexType>
+        [[nodiscard]] size_t outdegree(const Key &vertex) const;
+        [[nodiscard]] size_t outdegree(VertexHandle vertex) const;
+        template <typename Key = VertexType>
+        [[nodiscard]] size_t totalDegree(const Key &vertex) const;
+        [[nodiscard]] size_t totalDegree(VertexHandle vertex) const;
+        std::vector<VertexDegree> degrees() const;
+        // Heap bytes by component and matrix fill, see MemoryUsage.
+        MemoryUsage memoryUsage() const;
+        // Calls f(VertexHandle dest, const EdgeType &value) for every edge leaving vertex: its
+        // directed out-edges and its undirected edges. f may return false to stop.
+        template <typename Fn>
+        void forEachOutEdge(VertexHandle vertex, Fn &&f) const;
+        // Calls f(VertexHandle src, const EdgeType &value) for every edge entering vertex.
+        template <typename Fn>
+        void forEachInEdge(VertexHandle vertex, Fn &&f) const;
         MixedGraphMatrix() : vertexToIndex(), indexToVertex(), adjacencyMatrix() {};
         void removeEdge(const VertexType &src, const VertexType &dest);
+        void removeEdge(VertexHandle src, VertexHandle dest);
         void updateEdge(const VertexType &, const VertexType &, const EdgeType &);
+        void updateEdge(VertexHandle src, VertexHandle dest, const EdgeType &newValue);
         void addEdge(const VertexType &src, const VertexType &dest, std::optional<EdgeType> edgeValue, bool isDirected = false);
         void addEdge(const VertexType &src, const VertexType &dest, bool isDirected);
         void addEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge);
         void addEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge, bool isDirected);
-
-        const bool operator()(VertexType src, VertexType dest) const
+        void addEdge(VertexHandle src, VertexHandle dest, std::optional<EdgeType> edgeValue, bool isDirected = false);
+        void addEdge(VertexHandle src, VertexHandle dest, bool isDirected);
+        void addEdge(VertexHandle src, VertexHandle dest, const EdgeType &edge);
+        void addEdge(VertexHandle src, VertexHandle dest, const EdgeType &edge, bool isDirected);
+        // Batch mutations, see GraphMatrix::addEdges. addEdges items may carry a fourth field,
+        // isDirected (undirected otherwise); updateEdges items are (src, dest, value) and
+        // removeEdges items (src, dest). One BatchStatus per item, nothing is thrown.
+        template <typename Range>
+        std::vector<BatchStatus> addEdges(const Range &edges, const BatchOptions &options = {});
+        template <typename Range>
+        std::vector<BatchStatus> removeEdges(const Range &edges, const BatchOptions &options = {});
+        template <typename Range>
+        std::vector<BatchStatus> updateEdges(const Range &edges, const BatchOptions &options = {});
+        // Versioned binary file, see Serialization.h. load() accepts files saved by any graph
+        // class: edges of directed or undirected graphs keep that direction.
+        void save(const std::string &path) const;
+        static MixedGraphMatrix load(const std::string &path);
+
+        template <typename SrcKey = VertexType, typename DestKey = VertexType>
+        bool operator()(const SrcKey &src, const DestKey &dest) const
         {
-            if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+            size_t srcIndex = findIndex(src);
+            size_t destIndex = findIndex(dest);
+            if (srcIndex == npos || destIndex == npos)
             {
                 return false;
             }
-            size_t srcIndex = vertexToIndex.at(src);
-            size_t destIndex = vertexToIndex.at(dest);
-            size_t index = getIndex(srcIndex, destIndex);
-            return adjacencyMatrix[index].has_value();
+            return adjacencyMatrix.has(srcIndex, destIndex);
         }
 
     private:
-        std::map<VertexType, size_t> vertexToIndex;
+        static constexpr size_t npos = VertexIndex::npos;
+
+        VertexIndex vertexToIndex;
         std::vector<VertexType> indexToVertex;
-        std::vector<std::optional<EdgeInfo<EdgeType>>> adjacencyMatrix;
+        Storage adjacencyMatrix;
+        // per-vertex cell counts: directed cells in its row / column, undirected cells in its row
+        std::vector<size_t> directedOut;
+        std::vector<size_t> directedIn;
+        std::vector<size_t> undirected;
         size_t numVertices = 0;
-        inline size_t getIndex(size_t src, size_t dest) const;
+
+        // Single probe of the vertex index, npos if the vertex is not in the graph.
+        template <typename Key>
+        size_t findIndex(const Key &vertex) const
+        {
+            detail::ScopedProbe probe(InstrumentedOperation::VertexLookup);
+            return vertexToIndex.find(vertex, indexToVertex);
+        }
+
+        template <typename Key>
+        VertexHandle requireEndpoint(const Key &vertex) const
+        {
+            size_t index = findIndex(vertex);
+            if (index == npos)
+                throw std::invalid_argument("One or both vertices do not exist");
+            return VertexHandle(index);
+        }
+
+        template <typename Key>
+        VertexHandle requireVertex(const Key &vertex) const
+        {
+            size_t index = findIndex(vertex);
+            if (index == npos)
+                throw std::invalid_argument("Vertex does not exist in the graph");
+            return VertexHandle(index);
+        }
+
+        size_t checkHandle(VertexHandle vertex) const
+        {
+            if (vertex.index >= numVertices)
+                throw std::invalid_argument("Vertex handle does not belong to the graph");
+            return vertex.index;
+        }
+
+        // All matrix writes go through setCell/resetCell, which keep the degree counters exact
+        // when an edge is overwritten, changes direction or is removed twice.
+        void countCell(size_t srcIndex, size_t destIndex, bool add)
+        {
+            auto adjust = [add](size_t &counter)
+            {
+                add ? ++counter : --counter;
+            };
+            if (adjacencyMatrix.isDirected(srcIndex, destIndex))
+            {
+                adjust(directedOut[srcIndex]);
+                adjust(directedIn[destIndex]);
+            }
+            else
+            {
+                adjust(undirected[srcIndex]);
+            }
+        }
+
+        void setCell(size_t srcIndex, size_t destIndex, const EdgeType &value, bool isDirected)
+        {
+            if (adjacencyMatrix.has(srcIndex, destIndex))
+                countCell(srcIndex, destIndex, false);
+            adjacencyMatrix.set(srcIndex, destIndex, value, isDirected);
+            countCell(srcIndex, destIndex, true);
+        }
+
+        // Both directions of an undirected edge, sharing one value where the storage allows.
+        void setPair(size_t srcIndex, size_t destIndex, const EdgeType &value)
+        {
+            if (adjacencyMatrix.has(srcIndex, destIndex))
+                countCell(srcIndex, destIndex, false);
+            if (srcIndex != destIndex && adjacencyMatrix.has(destIndex, srcIndex))
+                countCell(destIndex, srcIndex, false);
+            adjacencyMatrix.setPair(srcIndex, destIndex, value, false);
+            countCell(srcIndex, destIndex, true);
+            if (srcIndex != destIndex)
+                countCell(destIndex, srcIndex, true);
+        }
+
+        void resetCell(size_t srcIndex, size_t destIndex)
+        {
+            if (adjacencyMatrix.has(srcIndex, destIndex))
+            {
+                countCell(srcIndex, destIndex, false);
+                adjacencyMatrix.reset(srcIndex, destIndex);
+            }
+        }
+
+        void removeIndices(std::vector<size_t> indices);
+        template <typename Range>
+        std::vector<BatchStatus> applyBatch(const Range &range, const BatchOptions &options, detail::BatchKind kind);
     };
 
-    template <typename VertexType, typename EdgeType>
-    void MixedGraphMatrix<VertexType, EdgeType>::addVertex(const VertexType &vertex)
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    VertexHandle MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::addVertex(const VertexType &vertex)
     {
-        if (vertexToIndex.count(vertex))
+        size_t existing = findIndex(vertex);
+        if (existing != npos)
         {
             std::cout << "Vertex already exists\n";
-            return;
+            return VertexHandle(existing);
         }
 
         size_t newIndex = numVertices;
-        vertexToIndex[vertex] = newIndex;
         indexToVertex.push_back(vertex);
+        vertexToIndex.insert(newIndex, indexToVertex);
+        directedOut.push_back(0);
+        directedIn.push_back(0);
+        undirected.push_back(0);
         numVertices++;
 
-        adjacencyMatrix.resize(numVertices * numVertices, std::nullopt);
+        adjacencyMatrix.ensure(numVertices);
+        return VertexHandle(newIndex);
     }
 
-    template <typename VertexType, typename EdgeType>
-    EdgeType MixedGraphMatrix<VertexType, EdgeType>::getEdgeValue(const VertexType &src, const VertexType &dest) const
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    // pre-size the matrix so later addVertex calls never reallocate.
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::reserveVertices(size_t count)
     {
-        if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+        adjacencyMatrix.reserve(count);
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::removeVertex(VertexHandle vertex)
+    {
+        removeIndices({checkHandle(vertex)});
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename Key>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::removeVertex(const Key &vertex)
+    {
+        removeVertex(requireVertex(vertex));
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    // duplicates are ignored, and nothing is removed if any vertex is missing.
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::removeVertices(const std::vector<VertexHandle> &vertices)
+    {
+        std::vector<size_t> indices;
+        indices.reserve(vertices.size());
+        for (VertexHandle vertex : vertices)
         {
-            throw std::invalid_argument("One or both vertices do not exist");
+            indices.push_back(checkHandle(vertex));
         }
+        removeIndices(std::move(indices));
+    }
 
-        size_t srcIndex = vertexToIndex.at(src);
-        size_t destIndex = vertexToIndex.at(dest);
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::removeVertices(const std::vector<VertexType> &vertices)
+    {
+        std::vector<size_t> indices;
+        indices.reserve(vertices.size());
+        for (const VertexType &vertex : vertices)
+        {
+            indices.push_back(requireVertex(vertex).index);
+        }
+        removeIndices(std::move(indices));
+    }
 
-        size_t index = getIndex(srcIndex, destIndex);
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    // Clears the removed rows and columns cell by cell, so neighbors' counters stay exact, then
+    // moves the highest survivors into the freed indices below the new count.
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::removeIndices(std::vector<size_t> indices)
+    {
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
 
-        if (!adjacencyMatrix[index].has_value())
+        for (size_t index : indices)
         {
-            throw std::runtime_error("Edge does not exist");
+            for (size_t destIndex = adjacencyMatrix.nextInRow(index, 0, numVertices);
+                 destIndex < numVertices;
+                 destIndex = adjacencyMatrix.nextInRow(index, destIndex + 1, numVertices))
+            {
+                resetCell(index, destIndex);
+            }
+            for (size_t srcIndex = adjacencyMatrix.nextInColumn(index, 0, numVertices);
+                 srcIndex < numVertices;
+                 srcIndex = adjacencyMatrix.nextInColumn(index, srcIndex + 1, numVertices))
+            {
+                resetCell(srcIndex, index);
+            }
+            vertexToIndex.erase(index, indexToVertex);
         }
 
-        return adjacencyMatrix[index]->value;
+        size_t remaining = numVertices - indices.size();
+        auto removed = indices.rbegin();
+        size_t last = numVertices;
+        for (size_t hole : indices)
+        {
+            if (hole >= remaining)
+                break;
+            // highest index that survives
+            while (removed != indices.rend() && *removed == last - 1)
+            {
+                ++removed;
+                --last;
+            }
+            --last;
+
+            adjacencyMatrix.relocate(last, hole, numVertices);
+            vertexToIndex.relocate(last, hole, indexToVertex);
+            indexToVertex[hole] = std::move(indexToVertex[last]);
+            directedOut[hole] = directedOut[last];
+            directedIn[hole] = directedIn[last];
+            undirected[hole] = undirected[last];
+        }
+
+        indexToVertex.erase(indexToVertex.begin() + remaining, indexToVertex.end());
+        directedOut.resize(remaining);
+        directedIn.resize(remaining);
+        undirected.resize(remaining);
+        numVertices = remaining;
     }
 
-    template <typename VertexType, typename EdgeType>
-    inline size_t MixedGraphMatrix<VertexType, EdgeType>::getIndex(size_t src, size_t dest) const
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename Key>
+    std::optional<VertexHandle> MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::findVertex(const Key &vertex) const
     {
-        return src * numVertices + dest;
+        size_t index = findIndex(vertex);
+        if (index == npos)
+            return std::nullopt;
+        return VertexHandle(index);
     }
 
-    template <typename VertexType, typename EdgeType>
-    // generic, being used by all overloads.
-    void MixedGraphMatrix<VertexType, EdgeType>::addEdge(const VertexType &src, const VertexType &dest, std::optional<EdgeType> edgeValue, bool isDirected)
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    const VertexType &MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::getVertex(VertexHandle vertex) const
     {
-        if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
-        {
-            throw std::invalid_argument("One or both vertices do not exist");
-        }
+        return indexToVertex[checkHandle(vertex)];
+    }
 
-        size_t srcIndex = vertexToIndex.at(src);
-        size_t destIndex = vertexToIndex.at(dest);
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename SrcKey, typename DestKey>
+    EdgeType MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::getEdgeValue(const SrcKey &src, const DestKey &dest) const
+    {
+        return getEdgeValue(requireEndpoint(src), requireEndpoint(dest));
+    }
 
-        size_t index = getIndex(srcIndex, destIndex);
-        adjacencyMatrix[index] = EdgeInfo<EdgeType>(edgeValue.value_or(EdgeType()), isDirected);
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    EdgeType MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::getEdgeValue(VertexHandle src, VertexHandle dest) const
+    {
+        size_t srcIndex = checkHandle(src);
+        size_t destIndex = checkHandle(dest);
 
-        if (!isDirected)
+        if (!adjacencyMatrix.has(srcIndex, destIndex))
         {
-            size_t reverseIndex = getIndex(destIndex, srcIndex);
-            adjacencyMatrix[reverseIndex] = EdgeInfo<EdgeType>(edgeValue.value_or(EdgeType()), isDirected);
+            throw std::runtime_error("Edge does not exist");
         }
+
+        return adjacencyMatrix.value(srcIndex, destIndex);
     }
-    template <typename VertexType, typename EdgeType>
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    // generic, being used by all overloads.
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::addEdge(const VertexType &src, const VertexType &dest, std::optional<EdgeType> edgeValue, bool isDirected)
+    {
+        addEdge(requireEndpoint(src), requireEndpoint(dest), std::move(edgeValue), isDirected);
+    }
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
     // case 1: non weidghted, directed/undirected egde.
-    void MixedGraphMatrix<VertexType, EdgeType>::addEdge(const VertexType &src, const VertexType &dest, bool isDirected)
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::addEdge(const VertexType &src, const VertexType &dest, bool isDirected)
     {
         addEdge(src, dest, std::nullopt, isDirected);
     }
-    template <typename VertexType, typename EdgeType>
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
     // case 2: weighted, undirected egde.
-    void MixedGraphMatrix<VertexType, EdgeType>::addEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge)
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::addEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge)
     {
         addEdge(src, dest, edge, false);
     }
-    template <typename VertexType, typename EdgeType>
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
     // case 3: weighted, undirected egde.
-    void MixedGraphMatrix<VertexType, EdgeType>::addEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge, bool isDirected)
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::addEdge(const VertexType &src, const VertexType &dest, const EdgeType &edge, bool isDirected)
     {
         addEdge(src, dest, std::optional<EdgeType>(edge), isDirected);
     }
 
-    template <typename VertexType, typename EdgeType>
-    void MixedGraphMatrix<VertexType, EdgeType>::removeEdge(const VertexType &src, const VertexType &dest)
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    // generic handle overload, being used by all overloads.
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::addEdge(VertexHandle src, VertexHandle dest, std::optional<EdgeType> edgeValue, bool isDirected)
+    {
+        detail::ScopedProbe probe(InstrumentedOperation::AddEdge);
+        size_t srcIndex = checkHandle(src);
+        size_t destIndex = checkHandle(dest);
+
+        if (isDirected)
+            setCell(srcIndex, destIndex, edgeValue.value_or(EdgeType()), true);
+        else
+            setPair(srcIndex, destIndex, edgeValue.value_or(EdgeType()));
+    }
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::addEdge(VertexHandle src, VertexHandle dest, bool isDirected)
     {
-        if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+        addEdge(src, dest, std::nullopt, isDirected);
+    }
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::addEdge(VertexHandle src, VertexHandle dest, const EdgeType &edge)
+    {
+        addEdge(src, dest, edge, false);
+    }
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::addEdge(VertexHandle src, VertexHandle dest, const EdgeType &edge, bool isDirected)
+    {
+        addEdge(src, dest, std::optional<EdgeType>(edge), isDirected);
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename Range>
+    std::vector<BatchStatus> MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::addEdges(const Range &edges, const BatchOptions &options)
+    {
+        return applyBatch(edges, options, detail::BatchKind::Add);
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename Range>
+    std::vector<BatchStatus> MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::removeEdges(const Range &edges, const BatchOptions &options)
+    {
+        return applyBatch(edges, options, detail::BatchKind::Remove);
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename Range>
+    std::vector<BatchStatus> MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::updateEdges(const Range &edges, const BatchOptions &options)
+    {
+        static_assert(std::tuple_size_v<detail::BatchItem<Range>> >= 3, "updateEdges items are (src, dest, value)");
+        return applyBatch(edges, options, detail::BatchKind::Update);
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename Range>
+    // Every cell op below repeats, for one cell, what the single-edge call does to it, and the
+    // cells of a row keep input order, so the result matches applying the items in order.
+    std::vector<BatchStatus> MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::applyBatch(const Range &range, const BatchOptions &options, detail::BatchKind kind)
+    {
+        using Item = detail::BatchItem<Range>;
+        static_assert(std::tuple_size_v<Item> >= 2, "batch items are (src, dest[, value[, isDirected]]) tuples");
+        auto directed = [](const Item &item)
         {
-            throw std::invalid_argument("One or both vertices do not exist");
+            if constexpr (std::tuple_size_v<Item> >= 4)
+                return static_cast<bool>(std::get<3>(item));
+            else
+                return false;
+        };
+
+        std::vector<std::pair<size_t, size_t>> endpoints;
+        std::vector<BatchStatus> status;
+        auto items = detail::resolveBatch(range, numVertices, options.threads, [this](const auto &key)
+                                          { return findIndex(key); },
+                                          endpoints, status);
+
+        // pooled slots and pages are shared between rows: item by item
+        if constexpr (!std::is_same_v<EdgeStorage, InlineEdges>)
+        {
+            for (size_t item = 0; item < items.size(); ++item)
+            {
+                if (status[item] != BatchStatus::Applied)
+                    continue;
+                VertexHandle src(endpoints[item].first), dest(endpoints[item].second);
+                if (kind == detail::BatchKind::Add)
+                {
+                    addEdge(src, dest, detail::batchValue<EdgeType>(*items[item]), directed(*items[item]));
+                    continue;
+                }
+                if (!adjacencyMatrix.has(src.index, dest.index))
+                    status[item] = BatchStatus::MissingEdge;
+                if (kind == detail::BatchKind::Remove)
+                    removeEdge(src, dest);
+                else if (status[item] == BatchStatus::Applied)
+                    updateEdge(src, dest, detail::batchValue<EdgeType>(*items[item]));
+            }
+            return status;
         }
 
-        size_t srcIndex = vertexToIndex[src];
-        size_t destIndex = vertexToIndex[dest];
+        std::vector<detail::CellOp> ops;
+        ops.reserve(items.size() * 2);
+        for (size_t item = 0; item < items.size(); ++item)
+        {
+            if (status[item] != BatchStatus::Applied)
+                continue;
+            auto [srcIndex, destIndex] = endpoints[item];
+            ops.push_back({srcIndex, destIndex, item, false});
+            // directed adds never touch the reverse cell
+            if (srcIndex != destIndex && !(kind == detail::BatchKind::Add && directed(*items[item])))
+                ops.push_back({destIndex, srcIndex, item, true});
+        }
 
-        size_t index = getIndex(srcIndex, destIndex);
-        adjacencyMatrix[index] = std::nullopt;
+        // directedIn is the only counter indexed by column, so workers sum it privately
+        size_t workers = detail::parallelWorkers(ops.size(), options.threads);
+        std::vector<std::vector<size_t>> inChanges(workers > 1 ? workers : 0, std::vector<size_t>(workers > 1 ? numVertices : 0, 0));
+        auto count = [&](size_t row, size_t column, unsigned worker, size_t change)
+        {
+            if (adjacencyMatrix.isDirected(row, column))
+            {
+                directedOut[row] += change;
+                (workers > 1 ? inChanges[worker][column] : directedIn[column]) += change;
+            }
+            else
+            {
+                undirected[row] += change;
+            }
+        };
+
+        detail::applyByRow(ops, numVertices, options.threads, [&](const detail::CellOp &op, unsigned worker)
+                           {
+                               const Item &item = *items[op.item];
+                               bool present = adjacencyMatrix.has(op.row, op.column);
+                               if (!op.mirror && !present && kind != detail::BatchKind::Add)
+                                   status[op.item] = BatchStatus::MissingEdge;
+
+                               if (kind == detail::BatchKind::Add)
+                               {
+                                   if (present)
+                                       count(op.row, op.column, worker, static_cast<size_t>(-1));
+                                   adjacencyMatrix.set(op.row, op.column, detail::batchValue<EdgeType>(item), directed(item));
+                                   count(op.row, op.column, worker, 1);
+                               }
+                               else if (kind == detail::BatchKind::Remove)
+                               {
+                                   // the reverse cell goes too when it is undirected
+                                   if (present && (!op.mirror || !adjacencyMatrix.isDirected(op.row, op.column)))
+                                   {
+                                       count(op.row, op.column, worker, static_cast<size_t>(-1));
+                                       adjacencyMatrix.reset(op.row, op.column);
+                                   }
+                               }
+                               else if (present && (!op.mirror || (adjacencyMatrix.has(op.column, op.row) &&
+                                                                   !adjacencyMatrix.isDirected(op.column, op.row))))
+                               {
+                                   // an update writes no bits, so reading the other row is safe
+                                   adjacencyMatrix.value(op.row, op.column) = detail::batchValue<EdgeType>(item);
+                               } });
+
+        for (const auto &changes : inChanges)
+        {
+            for (size_t vertex = 0; vertex < numVertices; ++vertex)
+            {
+                directedIn[vertex] += changes[vertex];
+            }
+        }
+        return status;
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::removeEdge(const VertexType &src, const VertexType &dest)
+    {
+        removeEdge(requireEndpoint(src), requireEndpoint(dest));
+    }
 
-        if (!adjacencyMatrix[getIndex(destIndex, srcIndex)].value_or(EdgeInfo<EdgeType>()).isDirected)
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::removeEdge(VertexHandle src, VertexHandle dest)
+    {
+        size_t srcIndex = checkHandle(src);
+        size_t destIndex = checkHandle(dest);
+
+        resetCell(srcIndex, destIndex);
+
+        if (adjacencyMatrix.has(destIndex, srcIndex) && !adjacencyMatrix.isDirected(destIndex, srcIndex))
         {
-            adjacencyMatrix[getIndex(destIndex, srcIndex)] = std::nullopt;
+            resetCell(destIndex, srcIndex);
         }
     }
 
-    template <typename VertexType, typename EdgeType>
-    bool MixedGraphMatrix<VertexType, EdgeType>::hasEdge(const VertexType &src, const VertexType &dest) const
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename SrcKey, typename DestKey>
+    bool MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::hasEdge(const SrcKey &src, const DestKey &dest) const
+    {
+        return hasEdge(requireEndpoint(src), requireEndpoint(dest));
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    bool MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::hasEdge(VertexHandle src, VertexHandle dest) const
     {
-        if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+        return adjacencyMatrix.has(checkHandle(src), checkHandle(dest));
+    }
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::updateEdge(const VertexType &src, const VertexType &dest, const EdgeType &newValue)
+    {
+        updateEdge(requireEndpoint(src), requireEndpoint(dest), newValue);
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::updateEdge(VertexHandle src, VertexHandle dest, const EdgeType &newValue)
+    {
+        size_t srcIndex = checkHandle(src);
+        size_t destIndex = checkHandle(dest);
+
+        if (!adjacencyMatrix.has(srcIndex, destIndex))
         {
-            throw std::invalid_argument("One or both vertices do not exist");
+            throw std::runtime_error("Edge does not exist");
+        }
+
+        adjacencyMatrix.value(srcIndex, destIndex) = newValue;
+
+        // If the edge is undirected, update the reverse edge too, unless both share one value
+        if (!adjacencyMatrix.isDirected(srcIndex, destIndex) && adjacencyMatrix.has(destIndex, srcIndex) &&
+            !adjacencyMatrix.shared(srcIndex, destIndex))
+        {
+            adjacencyMatrix.value(destIndex, srcIndex) = newValue;
         }
+    }
 
-        size_t srcIndex = vertexToIndex.at(src);
-        size_t destIndex = vertexToIndex.at(dest);
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename Key>
+    size_t MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::indegree(const Key &vertex) const
+    {
+        return indegree(requireVertex(vertex));
+    }
 
-        return adjacencyMatrix[getIndex(srcIndex, destIndex)].has_value();
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    size_t MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::indegree(VertexHandle vertex) const
+    {
+        size_t vertexIndex = checkHandle(vertex);
+        return directedIn[vertexIndex] + undirected[vertexIndex];
     }
-    template <typename VertexType, typename EdgeType>
-    void MixedGraphMatrix<VertexType, EdgeType>::updateEdge(const VertexType &src, const VertexType &dest, const EdgeType &newValue)
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename Key>
+    size_t MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::outdegree(const Key &vertex) const
     {
-        if (!vertexToIndex.count(src) || !vertexToIndex.count(dest))
+        return outdegree(requireVertex(vertex));
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    size_t MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::outdegree(VertexHandle vertex) const
+    {
+        size_t vertexIndex = checkHandle(vertex);
+        return directedOut[vertexIndex] + undirected[vertexIndex];
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename Key>
+    size_t MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::totalDegree(const Key &vertex) const
+    {
+        return totalDegree(requireVertex(vertex));
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    size_t MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::totalDegree(VertexHandle vertex) const
+    {
+        size_t vertexIndex = checkHandle(vertex);
+        return directedIn[vertexIndex] + directedOut[vertexIndex] + undirected[vertexIndex];
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    std::vector<VertexDegree> MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::degrees() const
+    {
+        std::vector<VertexDegree> result(numVertices);
+        for (size_t vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
         {
-            throw std::invalid_argument("One or both vertices do not exist");
+            VertexHandle vertex(vertexIndex);
+            result[vertexIndex] = {indegree(vertex), outdegree(vertex), totalDegree(vertex)};
         }
+        return result;
+    }
 
-        size_t srcIndex = vertexToIndex.at(src);
-        size_t destIndex = vertexToIndex.at(dest);
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    MemoryUsage MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::memoryUsage() const
+    {
+        MemoryUsage usage;
+        usage.matrixBytes = adjacencyMatrix.memoryBytes();
+        usage.indexBytes = vertexToIndex.memoryBytes();
+        usage.vertexBytes = indexToVertex.capacity() * sizeof(VertexType);
+        usage.degreeBytes = (directedOut.capacity() + directedIn.capacity() + undirected.capacity()) * sizeof(size_t);
+        usage.vertexCount = numVertices;
+        usage.vertexCapacity = adjacencyMatrix.capacity();
+        for (size_t vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+        {
+            usage.storedCells += directedOut[vertexIndex] + undirected[vertexIndex];
+        }
+        return usage;
+    }
 
-        size_t index = getIndex(srcIndex, destIndex);
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename Fn>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::forEachOutEdge(VertexHandle vertex, Fn &&f) const
+    {
+        size_t vertexIndex = checkHandle(vertex);
+        for (size_t destIndex = adjacencyMatrix.nextInRow(vertexIndex, 0, numVertices);
+             destIndex < numVertices;
+             destIndex = adjacencyMatrix.nextInRow(vertexIndex, destIndex + 1, numVertices))
+        {
+            if (!detail::keepVisiting(f, VertexHandle(destIndex), adjacencyMatrix.value(vertexIndex, destIndex)))
+                return;
+        }
+    }
 
-        if (!adjacencyMatrix[index].has_value())
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    template <typename Fn>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::forEachInEdge(VertexHandle vertex, Fn &&f) const
+    {
+        size_t vertexIndex = checkHandle(vertex);
+        for (size_t srcIndex = adjacencyMatrix.nextInColumn(vertexIndex, 0, numVertices);
+             srcIndex < numVertices;
+             srcIndex = adjacencyMatrix.nextInColumn(vertexIndex, srcIndex + 1, numVertices))
         {
-            throw std::runtime_error("Edge does not exist");
+            if (!detail::keepVisiting(f, VertexHandle(srcIndex), adjacencyMatrix.value(srcIndex, vertexIndex)))
+                return;
         }
+    }
 
-        adjacencyMatrix[index]->value = newValue;
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    void MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::save(const std::string &path) const
+    {
+        detail::writeGraphFile<VertexType, EdgeType>(path, detail::GraphFileKind::MixedMatrix, false, true, indexToVertex,
+                                                     [this](size_t srcIndex, auto &&emit)
+                                                     {
+                                                         for (size_t destIndex = adjacencyMatrix.nextInRow(srcIndex, 0, numVertices);
+                                                              destIndex < numVertices;
+                                                              destIndex = adjacencyMatrix.nextInRow(srcIndex, destIndex + 1, numVertices))
+                                                         {
+                                                             emit(destIndex, adjacencyMatrix.value(srcIndex, destIndex),
+                                                                  adjacencyMatrix.isDirected(srcIndex, destIndex));
+                                                         }
+                                                     });
+    }
+
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage> MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::load(const std::string &path)
+    {
+        detail::GraphFile<VertexType, EdgeType> file(path);
 
-        // If the edge is undirected, update the reverse edge too
-        if (!adjacencyMatrix[index]->isDirected)
+        MixedGraphMatrix graph;
+        graph.reserveVertices(file.vertexCount());
+        for (const VertexType &vertex : file.readVertices())
         {
-            size_t reverseIndex = getIndex(destIndex, srcIndex);
-            adjacencyMatrix[reverseIndex]->value = newValue;
+            graph.addVertex(vertex);
         }
+        if (graph.numVertices != file.vertexCount())
+            throw std::runtime_error("Graph file has duplicate vertices");
+
+        const uint64_t *offsets = file.offsets();
+        const uint64_t *targets = file.targets();
+        for (size_t srcIndex = 0; srcIndex < graph.numVertices; ++srcIndex)
+        {
+            for (size_t entry = offsets[srcIndex]; entry < offsets[srcIndex + 1]; ++entry)
+            {
+                size_t destIndex = graph.checkHandle(VertexHandle(static_cast<size_t>(targets[entry])));
+                if (file.isDirected(entry) || srcIndex == destIndex)
+                {
+                    graph.setCell(srcIndex, destIndex, file.value(entry), file.isDirected(entry));
+                    continue;
+                }
+                // an undirected cell is half of a pair unless its reverse was redirected
+                size_t reverse = file.find(destIndex, srcIndex);
+                bool paired = reverse != file.npos && !file.isDirected(reverse);
+                if (!paired)
+                    graph.setCell(srcIndex, destIndex, file.value(entry), false);
+                else if (srcIndex < destIndex)
+                    graph.setPair(srcIndex, destIndex, file.value(entry));
+            }
+        }
+        return graph;
     }
 
-    template <typename VertexType, typename EdgeType>
-    const std::vector<VertexType> &MixedGraphMatrix<VertexType, EdgeType>::getVertices() const
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    const std::vector<VertexType> &MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::getVertices() const
     {
         return indexToVertex;
     }
 
-    template <typename VertexType, typename EdgeType>
-    std::vector<EdgeType> MixedGraphMatrix<VertexType, EdgeType>::getEdges() const
+    template <typename VertexType, typename EdgeType, typename VertexIndex, typename EdgeStorage>
+    std::vector<EdgeType> MixedGraphMatrix<VertexType, EdgeType, VertexIndex, EdgeStorage>::getEdges() const
     {
         std::vector<EdgeType> edges;
 
@@ -215,17 +802,15 @@ namespace Appledore
         {
             for (size_t dest = 0; dest < numVertices; ++dest)
             {
-                size_t index = src * numVertices + dest; 
-
-                if (adjacencyMatrix[index].has_value())
+                if (adjacencyMatrix.has(src, dest))
                 {
-                    if (adjacencyMatrix[index]->isDirected)
+                    if (adjacencyMatrix.isDirected(src, dest))
                     {
-                        edges.push_back(adjacencyMatrix[index]->value);
+                        edges.push_back(adjacencyMatrix.value(src, dest));
                     }
                     else if (src <= dest)
                     {
-                        edges.push_back(adjacencyMatrix[index]->value);
+                        edges.push_back(adjacencyMatrix.value(src, dest));
                     }
                 }
             }
@@ -233,4 +818,4 @@ namespace Appledore
         return edges;
     }
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
+
+namespace Appledore
+{
+    namespace detail
+    {
+        // Thread count to use for a request: 0 means one per hardware thread.
+        inline unsigned resolveThreads(unsigned requested)
+        {
+            if (requested != 0)
+                return requested;
+            unsigned hardware = std::thread::hardware_concurrency();
+            return hardware == 0 ? 1 : hardware;
+        }
+
+        // Runs fn(worker) on `workers` threads, the calling thread being worker 0.
+        // The first exception thrown by fn is rethrown after all workers join.
+        template <typename Fn>
+        void parallelRun(size_t workers, Fn &&fn)
+        {
+            if (workers <= 1)
+            {
+                fn(0u);
+                return;
+            }
+
+            std::exception_ptr failure;
+            std::mutex failureMutex;
+            auto work = [&](unsigned worker)
+            {
+                try
+                {
+                    fn(worker);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(failureMutex);
+                    if (!failure)
+                        failure = std::current_exception();
+                }
+            };
+
+            std::vector<std::thread> pool;
+            pool.reserve(workers - 1);
+            for (unsigned worker = 1; worker < workers; ++worker)
+            {
+                pool.emplace_back(work, worker);
+            }
+            work(0);
+            for (auto &thread : pool)
+            {
+                thread.join();
+            }
+
+            if (failure)
+                std::rethrow_exception(failure);
+        }
+
+        // Calls fn(item, worker) for every item in [0, count) on up to `threads` workers.
+        // Items are handed out one at a time so uneven work balances itself; worker is in
+        // [0, workers) and lets callers keep per-worker scratch buffers.
+        template <typename Fn>
+        void parallelFor(size_t count, unsigned threads, Fn &&fn)
+        {
+            size_t workers = std::min<size_t>(resolveThreads(threads), count);
+            if (workers <= 1)
+            {
+                for (size_t item = 0; item < count; ++item)
+                {
+                    fn(item, 0u);
+                }
+                return;
+            }
+
+            std::atomic<size_t> nextItem{0};
+            parallelRun(workers, [&](unsigned worker)
+                        {
+                            try
+                            {
+                                for (size_t item = nextItem++; item < count; item = nextItem++)
+                                {
+                                    fn(item, worker);
+                                }
+                            }
+                            catch (...)
+                            {
+                                // let the other workers drain quickly
+                                nextItem = count;
+                                throw;
+                            } });
+        }
+
+        // Reusable rendezvous for a fixed number of threads (std::barrier is C++20).
+        // Workers must not throw between waits or the others block forever.
+        class Barrier
+        {
+        public:
+            explicit Barrier(size_t count) : count(count) {}
+
+            void arriveAndWait()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                size_t arrivedGeneration = generation;
+                if (++waiting == count)
+                {
+                    waiting = 0;
+                    generation++;
+                    released.notify_all();
+                    return;
+                }
+                released.wait(lock, [&]
+                              { return generation != arrivedGeneration; });
+            }
+
+        private:
+            std::mutex mutex;
+            std::condition_variable released;
+            size_t count;
+            size_t waiting = 0;
+            size_t generation = 0;
+        };
+
+        // Number of workers parallelFor will use, for sizing per-worker buffers.
+        inline size_t parallelWorkers(size_t count, unsigned threads)
+        {
+            return std::max<size_t>(1, std::min<size_t>(resolveThreads(threads), count));
+        }
+    }
+}
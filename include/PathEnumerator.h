@@ -0,0 +1,193 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <limits>
+#include <type_traits>
+#include "GraphCommon.h"
+#include "Parallel.h"
+#include "Instrumentation.h"
+
+namespace Appledore
+{
+    // Limits for forEachPath / findAllPaths.
+    struct PathOptions
+    {
+        // Longest path to report, in edges.
+        size_t maxDepth = std::numeric_limits<size_t>::max();
+        // Stop after this many paths.
+        size_t maxPaths = std::numeric_limits<size_t>::max();
+        // Split the first-level branches over this many threads, 0 = one per hardware thread.
+        unsigned threads = 1;
+    };
+
+    namespace detail
+    {
+        inline constexpr size_t noNeighbor = static_cast<size_t>(-1);
+
+        // Simple-path enumeration shared by the graph classes.
+        // advance(vertex, cursor) returns the next neighbor index of vertex and moves cursor
+        // (which starts at 0) past it, or noNeighbor once the row is exhausted.
+        // The visitor sees the one shared path buffer; it may return bool, false stops the walk.
+        // With several threads, visitor calls are serialized but arrive in no fixed order.
+        template <typename Advance, typename Visitor>
+        class PathEnumerator
+        {
+        public:
+            PathEnumerator(size_t vertexCount, size_t dest, const PathOptions &options,
+                           const Advance &advance, Visitor &visitor)
+                : vertexCount(vertexCount), dest(dest), options(options), advance(advance), visitor(visitor) {}
+
+            size_t run(size_t src)
+            {
+                if (options.maxPaths == 0)
+                    return 0;
+
+                Walker walker(*this);
+                walker.path.push_back(VertexHandle(src));
+                if (src == dest)
+                {
+                    walker.emit();
+                    return found;
+                }
+
+                if (options.threads == 1)
+                {
+                    walker.walk(src);
+                    return found;
+                }
+
+                // first-level branches are the unit of parallel work
+                std::vector<size_t> branches;
+                if (options.maxDepth > 0)
+                {
+                    size_t cursor = 0;
+                    for (size_t next = advance(src, cursor); next != noNeighbor; next = advance(src, cursor))
+                    {
+                        if (next != src)
+                            branches.push_back(next);
+                    }
+                }
+
+                countOperation(InstrumentedOperation::PathExpansion, branches.size());
+                serialize = true;
+                std::vector<Walker> walkers(parallelWorkers(branches.size(), options.threads), Walker(*this));
+                parallelFor(branches.size(), options.threads, [&](size_t item, unsigned worker)
+                            {
+                                Walker &local = walkers[worker];
+                                local.path.assign(1, VertexHandle(src));
+                                local.path.push_back(VertexHandle(branches[item]));
+                                if (branches[item] == dest)
+                                    local.emit();
+                                else
+                                    local.walk(src, branches[item]); });
+                return found;
+            }
+
+        private:
+            struct Walker
+            {
+                PathEnumerator *owner;
+                std::vector<VertexHandle> path;
+                std::vector<size_t> cursors;
+                std::vector<bool> onPath;
+
+                explicit Walker(PathEnumerator &owner) : owner(&owner), onPath(owner.vertexCount, false)
+                {
+                    path.reserve(std::min(owner.vertexCount, owner.options.maxDepth) + 1);
+                    cursors.reserve(path.capacity());
+                }
+
+                void emit()
+                {
+                    owner->emit(path);
+                }
+
+                // Extend path (whose vertices are src and, optionally, one first hop) by backtracking.
+                void walk(size_t src, size_t first = noNeighbor)
+                {
+                    size_t base = path.size() - 1;
+                    onPath[src] = true;
+                    if (first != noNeighbor)
+                        onPath[first] = true;
+
+                    cursors.assign(1, 0);
+                    // tallied locally, so a disabled probe leaves nothing behind
+                    size_t expansions = 0;
+                    while (path.size() > base && !owner->stopped.load(std::memory_order_relaxed))
+                    {
+                        size_t current = path.back().index;
+                        size_t next = path.size() - 1 < owner->options.maxDepth
+                                          ? owner->advance(current, cursors.back())
+                                          : noNeighbor;
+                        if (next == noNeighbor)
+                        {
+                            onPath[current] = false;
+                            path.pop_back();
+                            cursors.pop_back();
+                            continue;
+                        }
+                        if (onPath[next])
+                            continue;
+
+                        path.push_back(VertexHandle(next));
+                        ++expansions;
+                        if (next == owner->dest)
+                        {
+                            emit();
+                            path.pop_back();
+                            continue;
+                        }
+                        onPath[next] = true;
+                        cursors.push_back(0);
+                    }
+
+                    countOperation(InstrumentedOperation::PathExpansion, expansions);
+
+                    // an early stop leaves the prefix marked
+                    for (const VertexHandle &vertex : path)
+                    {
+                        onPath[vertex.index] = false;
+                    }
+                }
+            };
+
+            size_t vertexCount;
+            size_t dest;
+            const PathOptions &options;
+            const Advance &advance;
+            Visitor &visitor;
+            std::atomic<bool> stopped{false};
+            size_t found = 0;
+            bool serialize = false;
+            std::mutex visitorMutex;
+
+            void emit(const std::vector<VertexHandle> &path)
+            {
+                std::unique_lock<std::mutex> lock(visitorMutex, std::defer_lock);
+                if (serialize)
+                    lock.lock();
+                if (stopped.load(std::memory_order_relaxed))
+                    return;
+
+                bool keepGoing = true;
+                if constexpr (std::is_same_v<std::invoke_result_t<Visitor &, const std::vector<VertexHandle> &>, void>)
+                    visitor(path);
+                else
+                    keepGoing = static_cast<bool>(visitor(path));
+
+                if (++found >= options.maxPaths || !keepGoing)
+                    stopped.store(true, std::memory_order_relaxed);
+            }
+        };
+
+        template <typename Advance, typename Visitor>
+        size_t enumeratePaths(size_t vertexCount, size_t src, size_t dest, const PathOptions &options,
+                              const Advance &advance, Visitor &visitor)
+        {
+            ScopedProbe probe(InstrumentedOperation::FindAllPaths);
+            return PathEnumerator<Advance, Visitor>(vertexCount, dest, options, advance, visitor).run(src);
+        }
+    }
+}
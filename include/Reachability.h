@@ -0,0 +1,223 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include "GraphCommon.h"
+#include "Parallel.h"
+
+namespace Appledore
+{
+    enum class ReachabilityMethod
+    {
+        // TransitiveClosure while it fits in maxClosureBytes, TwoHopLabels otherwise.
+        Auto,
+        // Packed n x n bit matrix: O(1) queries, n^2 / 8 bytes, O(n^3 / 64) to build.
+        TransitiveClosure,
+        // Pruned 2-hop labels: near-linear memory on sparse graphs, queries merge two short lists.
+        TwoHopLabels
+    };
+
+    struct ReachabilityOptions
+    {
+        ReachabilityMethod method = ReachabilityMethod::Auto;
+        // Memory budget Auto grants the closure matrix.
+        size_t maxClosureBytes = size_t(64) << 20;
+        // Threads for the closure rows, 0 = one per hardware thread; labels build serially.
+        unsigned threads = 1;
+    };
+
+    // Answers "can src reach dest" for a snapshot of a graph; rebuild it after the graph changes.
+    // Every vertex reaches itself. Graph needs getVertices(), forEachOutEdge and forEachInEdge.
+    class ReachabilityIndex
+    {
+    public:
+        template <typename Graph>
+        explicit ReachabilityIndex(const Graph &graph, const ReachabilityOptions &options = {})
+            : vertexCount(graph.getVertices().size()), wordsPerRow((vertexCount + 63) / 64)
+        {
+            kind = options.method;
+            if (kind == ReachabilityMethod::Auto)
+            {
+                kind = closureBytes() <= options.maxClosureBytes ? ReachabilityMethod::TransitiveClosure
+                                                                 : ReachabilityMethod::TwoHopLabels;
+            }
+
+            if (kind == ReachabilityMethod::TransitiveClosure)
+                buildClosure(graph, options.threads);
+            else
+                buildLabels(graph);
+        }
+
+        bool reachable(VertexHandle src, VertexHandle dest) const
+        {
+            if (src.index >= vertexCount || dest.index >= vertexCount)
+                throw std::invalid_argument("Vertex handle does not belong to the graph");
+
+            if (kind == ReachabilityMethod::TransitiveClosure)
+                return (closure[src.index * wordsPerRow + dest.index / 64] >> (dest.index % 64)) & 1;
+            return intersects(outLabels[src.index], inLabels[dest.index]);
+        }
+
+        ReachabilityMethod method() const
+        {
+            return kind;
+        }
+
+        // Bytes held by the index.
+        size_t memoryUsage() const
+        {
+            size_t bytes = closure.capacity() * sizeof(uint64_t);
+            for (const auto &label : outLabels)
+            {
+                bytes += label.capacity() * sizeof(uint32_t);
+            }
+            for (const auto &label : inLabels)
+            {
+                bytes += label.capacity() * sizeof(uint32_t);
+            }
+            return bytes;
+        }
+
+    private:
+        size_t vertexCount;
+        size_t wordsPerRow;
+        ReachabilityMethod kind;
+        std::vector<uint64_t> closure;
+        // outLabels[v]: ranks of hubs v reaches, inLabels[v]: ranks of hubs reaching v, both sorted.
+        std::vector<std::vector<uint32_t>> outLabels;
+        std::vector<std::vector<uint32_t>> inLabels;
+
+        size_t closureBytes() const
+        {
+            return vertexCount * wordsPerRow * sizeof(uint64_t);
+        }
+
+        static bool intersects(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+        {
+            size_t i = 0, j = 0;
+            while (i < a.size() && j < b.size())
+            {
+                if (a[i] == b[j])
+                    return true;
+                if (a[i] < b[j])
+                    ++i;
+                else
+                    ++j;
+            }
+            return false;
+        }
+
+        // Warshall over packed rows: for each k, every row that reaches k ORs in row k.
+        // Row k does not change during step k, so rows split across workers with one barrier per k.
+        template <typename Graph>
+        void buildClosure(const Graph &graph, unsigned threads)
+        {
+            closure.assign(vertexCount * wordsPerRow, 0);
+            for (size_t src = 0; src < vertexCount; ++src)
+            {
+                uint64_t *row = closure.data() + src * wordsPerRow;
+                row[src / 64] |= uint64_t(1) << (src % 64);
+                graph.forEachOutEdge(VertexHandle(src), [&](VertexHandle dest, const auto &)
+                                     { row[dest.index / 64] |= uint64_t(1) << (dest.index % 64); });
+            }
+
+            size_t workers = detail::parallelWorkers(vertexCount, threads);
+            detail::Barrier barrier(workers);
+            detail::parallelRun(workers, [&](unsigned worker)
+                                {
+                                    size_t first = vertexCount * worker / workers;
+                                    size_t last = vertexCount * (worker + 1) / workers;
+                                    for (size_t k = 0; k < vertexCount; ++k)
+                                    {
+                                        const uint64_t *pivot = closure.data() + k * wordsPerRow;
+                                        const uint64_t mask = uint64_t(1) << (k % 64);
+                                        for (size_t i = first; i < last; ++i)
+                                        {
+                                            uint64_t *row = closure.data() + i * wordsPerRow;
+                                            if (i == k || !(row[k / 64] & mask))
+                                                continue;
+                                            for (size_t word = 0; word < wordsPerRow; ++word)
+                                            {
+                                                row[word] |= pivot[word];
+                                            }
+                                        }
+                                        if (workers > 1)
+                                            barrier.arriveAndWait();
+                                    } });
+        }
+
+        // Pruned landmark labeling: hubs in decreasing degree order run a forward and a backward
+        // BFS, skipping every vertex whose pair is already answered by earlier labels.
+        template <typename Graph>
+        void buildLabels(const Graph &graph)
+        {
+            outLabels.assign(vertexCount, {});
+            inLabels.assign(vertexCount, {});
+
+            std::vector<size_t> degree(vertexCount, 0);
+            for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+            {
+                graph.forEachOutEdge(VertexHandle(vertex), [&](VertexHandle dest, const auto &)
+                                     {
+                                         degree[vertex]++;
+                                         degree[dest.index]++; });
+            }
+            std::vector<size_t> order(vertexCount);
+            for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+            {
+                order[vertex] = vertex;
+            }
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                             { return degree[a] > degree[b]; });
+
+            std::vector<size_t> queue;
+            queue.reserve(vertexCount);
+            // stamped with the rank of the hub whose search saw the vertex, so nothing is cleared
+            std::vector<uint32_t> seenForward(vertexCount, UINT32_MAX);
+            std::vector<uint32_t> seenBackward(vertexCount, UINT32_MAX);
+
+            for (uint32_t rank = 0; rank < vertexCount; ++rank)
+            {
+                size_t hub = order[rank];
+
+                // forward: hub reaches u, record the hub in u's in-label
+                queue.assign(1, hub);
+                seenForward[hub] = rank;
+                for (size_t head = 0; head < queue.size(); ++head)
+                {
+                    size_t vertex = queue[head];
+                    if (intersects(outLabels[hub], inLabels[vertex]))
+                        continue;
+                    inLabels[vertex].push_back(rank);
+                    graph.forEachOutEdge(VertexHandle(vertex), [&](VertexHandle dest, const auto &)
+                                         {
+                                             if (seenForward[dest.index] != rank)
+                                             {
+                                                 seenForward[dest.index] = rank;
+                                                 queue.push_back(dest.index);
+                                             } });
+                }
+
+                // backward: u reaches hub, record the hub in u's out-label
+                queue.assign(1, hub);
+                seenBackward[hub] = rank;
+                for (size_t head = 0; head < queue.size(); ++head)
+                {
+                    size_t vertex = queue[head];
+                    if (intersects(outLabels[vertex], inLabels[hub]))
+                        continue;
+                    outLabels[vertex].push_back(rank);
+                    graph.forEachInEdge(VertexHandle(vertex), [&](VertexHandle src, const auto &)
+                                        {
+                                            if (seenBackward[src.index] != rank)
+                                            {
+                                                seenBackward[src.index] = rank;
+                                                queue.push_back(src.index);
+                                            } });
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,645 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define APPLEDORE_HAS_MMAP 1
+#endif
+#include "GraphCommon.h"
+#include "VertexIndex.h"
+
+namespace Appledore
+{
+    class BinaryWriter;
+    class BinaryReader;
+
+    // How a vertex or edge type is written to graph files. Trivially copyable types and
+    // std::string work out of the box, anything else needs a specialization such as
+    //
+    //   template <>
+    //   struct Appledore::Serializer<FlightRoute>
+    //   {
+    //       static void write(BinaryWriter &out, const FlightRoute &route)
+    //       {
+    //           out.write(route.distance);
+    //           out.write(route.airline);
+    //       }
+    //       static FlightRoute read(BinaryReader &in)
+    //       {
+    //           int distance = in.read<int>();
+    //           return FlightRoute(distance, in.read<std::string>());
+    //       }
+    //   };
+    template <typename T, typename = void>
+    struct Serializer;
+
+    // Sequential writer over a binary file.
+    class BinaryWriter
+    {
+    public:
+        explicit BinaryWriter(const std::string &path)
+            : out(path, std::ios::binary | std::ios::trunc)
+        {
+            if (!out)
+                throw std::runtime_error("Cannot open " + path + " for writing");
+        }
+
+        void bytes(const void *data, size_t size)
+        {
+            out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+            written += size;
+        }
+
+        template <typename T>
+        void write(const T &value)
+        {
+            Serializer<T>::write(*this, value);
+        }
+
+        // Zero bytes up to the next multiple of alignment.
+        void pad(size_t alignment)
+        {
+            static const char zeros[64] = {};
+            while (written % alignment != 0)
+            {
+                bytes(zeros, std::min<size_t>(alignment - written % alignment, sizeof(zeros)));
+            }
+        }
+
+        size_t position() const
+        {
+            return written;
+        }
+
+        // Overwrite bytes already written, the stream position is kept.
+        void patch(size_t at, const void *data, size_t size)
+        {
+            std::streampos end = out.tellp();
+            out.seekp(static_cast<std::streamoff>(at));
+            out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+            out.seekp(end);
+        }
+
+        void finish()
+        {
+            out.flush();
+            if (!out)
+                throw std::runtime_error("Writing the graph file failed");
+        }
+
+    private:
+        std::ofstream out;
+        size_t written = 0;
+    };
+
+    // Bounds-checked reader over a byte range, usually part of a MappedFile.
+    class BinaryReader
+    {
+    public:
+        BinaryReader(const char *begin, const char *end) : cursor(begin), end(end) {}
+
+        const char *take(size_t size)
+        {
+            if (static_cast<size_t>(end - cursor) < size)
+                throw std::runtime_error("Graph file is truncated");
+            const char *start = cursor;
+            cursor += size;
+            return start;
+        }
+
+        void bytes(void *data, size_t size)
+        {
+            std::memcpy(data, take(size), size);
+        }
+
+        template <typename T>
+        T read()
+        {
+            return Serializer<T>::read(*this);
+        }
+
+    private:
+        const char *cursor;
+        const char *end;
+    };
+
+    template <typename T>
+    struct Serializer<T, std::enable_if_t<std::is_trivially_copyable_v<T>>>
+    {
+        static void write(BinaryWriter &out, const T &value)
+        {
+            out.bytes(&value, sizeof(T));
+        }
+
+        static T read(BinaryReader &in)
+        {
+            T value;
+            in.bytes(&value, sizeof(T));
+            return value;
+        }
+    };
+
+    template <>
+    struct Serializer<std::string>
+    {
+        static void write(BinaryWriter &out, const std::string &value)
+        {
+            out.write(static_cast<uint64_t>(value.size()));
+            out.bytes(value.data(), value.size());
+        }
+
+        static std::string read(BinaryReader &in)
+        {
+            size_t size = static_cast<size_t>(in.read<uint64_t>());
+            const char *data = in.take(size);
+            return std::string(data, size);
+        }
+    };
+
+    // Read-only view of a whole file: mmap on POSIX systems, so pages are loaded on first
+    // touch and shared with the page cache; elsewhere the file is read into memory.
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::string &path)
+        {
+#if defined(APPLEDORE_HAS_MMAP)
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Cannot open " + path);
+            struct stat info;
+            if (::fstat(fd, &info) != 0)
+            {
+                ::close(fd);
+                throw std::runtime_error("Cannot stat " + path);
+            }
+            length = static_cast<size_t>(info.st_size);
+            if (length > 0)
+            {
+                void *mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapped == MAP_FAILED)
+                {
+                    ::close(fd);
+                    throw std::runtime_error("Cannot map " + path);
+                }
+                bytes = static_cast<const char *>(mapped);
+            }
+            ::close(fd);
+#else
+            std::ifstream in(path, std::ios::binary);
+            if (!in)
+                throw std::runtime_error("Cannot open " + path);
+            buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            bytes = buffer.data();
+            length = buffer.size();
+#endif
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        MappedFile(MappedFile &&other) noexcept
+            : bytes(std::exchange(other.bytes, nullptr)), length(std::exchange(other.length, 0))
+#if !defined(APPLEDORE_HAS_MMAP)
+              ,
+              buffer(std::move(other.buffer))
+#endif
+        {
+        }
+
+        MappedFile &operator=(MappedFile &&other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                bytes = std::exchange(other.bytes, nullptr);
+                length = std::exchange(other.length, 0);
+#if !defined(APPLEDORE_HAS_MMAP)
+                buffer = std::move(other.buffer);
+#endif
+            }
+            return *this;
+        }
+
+        ~MappedFile()
+        {
+            release();
+        }
+
+        const char *data() const
+        {
+            return bytes;
+        }
+
+        size_t size() const
+        {
+            return length;
+        }
+
+    private:
+        const char *bytes = nullptr;
+        size_t length = 0;
+#if !defined(APPLEDORE_HAS_MMAP)
+        std::vector<char> buffer;
+#endif
+
+        void release()
+        {
+#if defined(APPLEDORE_HAS_MMAP)
+            if (bytes)
+                ::munmap(const_cast<char *>(bytes), length);
+#endif
+            bytes = nullptr;
+            length = 0;
+        }
+    };
+
+    namespace detail
+    {
+        // Graph file layout, version 1, native byte order:
+        //   header, then 64-byte aligned sections
+        //   offsets     uint64[vertexCount + 1]   CSR row starts
+        //   targets     uint64[entryCount]        destination index of every entry, rows sorted
+        //   directions  uint8[entryCount]         per-entry directed flag, mixed graphs only
+        //   values      EdgeType[entryCount] raw when trivially copyable, else Serializer output
+        //   vertices    Serializer output, in index order
+        // Undirected edges are stored once per direction, as the matrix classes hold them.
+        enum class GraphFileKind : uint32_t
+        {
+            Matrix = 1,
+            MixedMatrix = 2,
+            CSR = 3,
+            List = 4,
+            MixedList = 5
+        };
+
+        inline constexpr char graphFileMagic[8] = {'A', 'P', 'L', 'D', 'G', 'R', 'P', 'H'};
+        inline constexpr uint32_t graphFileVersion = 1;
+        inline constexpr uint32_t graphFileByteOrder = 0x01020304;
+        inline constexpr size_t graphFileAlignment = 64;
+
+        // GraphFileHeader::flags
+        inline constexpr uint32_t directedFile = 1;
+        inline constexpr uint32_t mixedFile = 2;
+        inline constexpr uint32_t rawValues = 4;
+
+        struct GraphFileHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t byteOrder;
+            uint32_t kind;
+            uint32_t flags;
+            uint64_t edgeSize;
+            uint64_t vertexCount;
+            uint64_t entryCount;
+            uint64_t offsetsAt;
+            uint64_t targetsAt;
+            uint64_t directionsAt;
+            uint64_t valuesAt;
+            uint64_t valuesBytes;
+            uint64_t verticesAt;
+            uint64_t verticesBytes;
+        };
+
+        // Writes a graph given its vertices and rows(src, emit), where rows calls
+        // emit(dest, const EdgeType &value, bool isDirected) for every entry of row src.
+        template <typename VertexType, typename EdgeType, typename Rows>
+        void writeGraphFile(const std::string &path, GraphFileKind kind, bool directed, bool mixed,
+                            const std::vector<VertexType> &vertices, Rows &&rows)
+        {
+            struct Entry
+            {
+                size_t dest;
+                const EdgeType *value;
+                bool isDirected;
+            };
+
+            const size_t vertexCount = vertices.size();
+            std::vector<uint64_t> offsets(vertexCount + 1, 0);
+            std::vector<uint64_t> targets;
+            std::vector<uint8_t> directions;
+            std::vector<const EdgeType *> values;
+            std::vector<Entry> row;
+            for (size_t src = 0; src < vertexCount; ++src)
+            {
+                row.clear();
+                rows(src, [&](size_t dest, const EdgeType &value, bool isDirected)
+                     { row.push_back({dest, &value, isDirected}); });
+                auto byDest = [](const Entry &a, const Entry &b)
+                {
+                    return a.dest < b.dest;
+                };
+                if (!std::is_sorted(row.begin(), row.end(), byDest))
+                    std::sort(row.begin(), row.end(), byDest);
+                for (const Entry &entry : row)
+                {
+                    targets.push_back(entry.dest);
+                    values.push_back(entry.value);
+                    if (mixed)
+                        directions.push_back(entry.isDirected ? 1 : 0);
+                }
+                offsets[src + 1] = targets.size();
+            }
+
+            constexpr bool raw = std::is_trivially_copyable_v<EdgeType>;
+            GraphFileHeader header{};
+            std::memcpy(header.magic, graphFileMagic, sizeof(header.magic));
+            header.version = graphFileVersion;
+            header.byteOrder = graphFileByteOrder;
+            header.kind = static_cast<uint32_t>(kind);
+            header.flags = (directed ? directedFile : 0) | (mixed ? mixedFile : 0) | (raw ? rawValues : 0);
+            header.edgeSize = raw ? sizeof(EdgeType) : 0;
+            header.vertexCount = vertexCount;
+            header.entryCount = targets.size();
+
+            BinaryWriter out(path);
+            out.bytes(&header, sizeof(header));
+
+            out.pad(graphFileAlignment);
+            header.offsetsAt = out.position();
+            out.bytes(offsets.data(), offsets.size() * sizeof(uint64_t));
+
+            out.pad(graphFileAlignment);
+            header.targetsAt = out.position();
+            out.bytes(targets.data(), targets.size() * sizeof(uint64_t));
+
+            if (mixed)
+            {
+                out.pad(graphFileAlignment);
+                header.directionsAt = out.position();
+                out.bytes(directions.data(), directions.size());
+            }
+
+            out.pad(graphFileAlignment);
+            header.valuesAt = out.position();
+            for (const EdgeType *value : values)
+            {
+                if constexpr (raw)
+                    out.bytes(value, sizeof(EdgeType));
+                else
+                    out.write(*value);
+            }
+            header.valuesBytes = out.position() - header.valuesAt;
+
+            out.pad(graphFileAlignment);
+            header.verticesAt = out.position();
+            for (const VertexType &vertex : vertices)
+            {
+                out.write(vertex);
+            }
+            header.verticesBytes = out.position() - header.verticesAt;
+
+            out.patch(0, &header, sizeof(header));
+            out.finish();
+        }
+
+        // A mapped graph file with its header checked. Raw adjacency arrays are used in place;
+        // serialized edge values are decoded once on open. File contents are trusted beyond
+        // the header and section bounds.
+        template <typename VertexType, typename EdgeType>
+        class GraphFile
+        {
+        public:
+            static constexpr size_t npos = static_cast<size_t>(-1);
+
+            explicit GraphFile(const std::string &path) : file(path)
+            {
+                if (file.size() < sizeof(GraphFileHeader))
+                    throw std::runtime_error("Graph file is truncated");
+                std::memcpy(&header, file.data(), sizeof(header));
+
+                if (std::memcmp(header.magic, graphFileMagic, sizeof(header.magic)) != 0)
+                    throw std::runtime_error("Not an Appledore graph file");
+                if (header.version != graphFileVersion)
+                    throw std::runtime_error("Unsupported graph file version " + std::to_string(header.version));
+                if (header.byteOrder != graphFileByteOrder)
+                    throw std::runtime_error("Graph file was written with a different byte order");
+
+                constexpr bool raw = std::is_trivially_copyable_v<EdgeType>;
+                if (raw != ((header.flags & rawValues) != 0) || (raw && header.edgeSize != sizeof(EdgeType)))
+                    throw std::runtime_error("Graph file edge type does not match EdgeType");
+
+                section(header.offsetsAt, (header.vertexCount + 1) * sizeof(uint64_t));
+                section(header.targetsAt, header.entryCount * sizeof(uint64_t));
+                if (mixed())
+                    section(header.directionsAt, header.entryCount);
+                section(header.valuesAt, header.valuesBytes);
+                section(header.verticesAt, header.verticesBytes);
+                if (raw && header.valuesBytes != header.entryCount * sizeof(EdgeType))
+                    throw std::runtime_error("Graph file edge section has the wrong size");
+                if (offsets()[0] != 0 || offsets()[header.vertexCount] != header.entryCount)
+                    throw std::runtime_error("Graph file offsets are inconsistent");
+
+                if constexpr (!raw)
+                {
+                    BinaryReader in(file.data() + header.valuesAt, file.data() + header.valuesAt + header.valuesBytes);
+                    decoded.reserve(header.entryCount);
+                    for (uint64_t entry = 0; entry < header.entryCount; ++entry)
+                    {
+                        decoded.push_back(in.read<EdgeType>());
+                    }
+                }
+            }
+
+            bool directed() const
+            {
+                return (header.flags & directedFile) != 0;
+            }
+
+            bool mixed() const
+            {
+                return (header.flags & mixedFile) != 0;
+            }
+
+            size_t vertexCount() const
+            {
+                return static_cast<size_t>(header.vertexCount);
+            }
+
+            size_t entryCount() const
+            {
+                return static_cast<size_t>(header.entryCount);
+            }
+
+            std::vector<VertexType> readVertices() const
+            {
+                BinaryReader in(file.data() + header.verticesAt, file.data() + header.verticesAt + header.verticesBytes);
+                std::vector<VertexType> vertices;
+                vertices.reserve(vertexCount());
+                for (size_t vertex = 0; vertex < vertexCount(); ++vertex)
+                {
+                    vertices.push_back(in.read<VertexType>());
+                    // every load path reads vertices here, so new vertices cannot reuse a loaded id
+                    if constexpr (std::is_base_of_v<GraphVertex, VertexType>)
+                        GraphVertex::reserveId(vertices.back().id);
+                }
+                return vertices;
+            }
+
+            const uint64_t *offsets() const
+            {
+                return reinterpret_cast<const uint64_t *>(file.data() + header.offsetsAt);
+            }
+
+            const uint64_t *targets() const
+            {
+                return reinterpret_cast<const uint64_t *>(file.data() + header.targetsAt);
+            }
+
+            const EdgeType &value(size_t entry) const
+            {
+                if constexpr (std::is_trivially_copyable_v<EdgeType>)
+                    return reinterpret_cast<const EdgeType *>(file.data() + header.valuesAt)[entry];
+                else
+                    return decoded[entry];
+            }
+
+            bool isDirected(size_t entry) const
+            {
+                if (mixed())
+                    return file.data()[header.directionsAt + entry] != 0;
+                return directed();
+            }
+
+            // Entry of (src, dest) by binary search in the sorted row, npos if absent.
+            size_t find(size_t src, size_t dest) const
+            {
+                const uint64_t *rowBegin = targets() + offsets()[src];
+                const uint64_t *rowEnd = targets() + offsets()[src + 1];
+                const uint64_t *it = std::lower_bound(rowBegin, rowEnd, static_cast<uint64_t>(dest));
+                if (it == rowEnd || *it != dest)
+                    return npos;
+                return static_cast<size_t>(it - targets());
+            }
+
+            // Files from directed/undirected graphs load into classes of the same direction only.
+            void requireDirection(bool isDirected) const
+            {
+                if (mixed() || directed() != isDirected)
+                    throw std::runtime_error("Graph file direction does not match the graph type");
+            }
+
+        private:
+            MappedFile file;
+            GraphFileHeader header;
+            std::vector<EdgeType> decoded;
+
+            void section(uint64_t at, uint64_t bytes) const
+            {
+                if (at % graphFileAlignment != 0 || at > file.size() || bytes > file.size() - at)
+                    throw std::runtime_error("Graph file is truncated");
+            }
+        };
+    }
+
+    // Read-only graph used straight from a file written by save(): the adjacency arrays stay in
+    // the mapping and are never copied, only vertex keys are decoded into a lookup index.
+    // Provides getVertices() and forEachOutEdge, so Dijkstra and all-pairs run on it directly.
+    template <typename VertexType, typename EdgeType, typename VertexIndex = DefaultVertexIndex<VertexType>>
+    class MappedGraph
+    {
+        static_assert(std::is_trivially_copyable_v<EdgeType>, "MappedGraph needs a trivially copyable EdgeType");
+
+    public:
+        using VertexValueType = VertexType;
+        using EdgeValueType = EdgeType;
+
+        explicit MappedGraph(const std::string &path) : file(path), vertices(file.readVertices())
+        {
+            for (size_t index = 0; index < vertices.size(); ++index)
+            {
+                vertexToIndex.insert(index, vertices);
+            }
+        }
+
+        const std::vector<VertexType> &getVertices() const
+        {
+            return vertices;
+        }
+
+        template <typename Key = VertexType>
+        std::optional<VertexHandle> findVertex(const Key &vertex) const
+        {
+            size_t index = vertexToIndex.find(vertex, vertices);
+            if (index == VertexIndex::npos)
+                return std::nullopt;
+            return VertexHandle(index);
+        }
+
+        // Number of stored entries, undirected edges count once per direction.
+        size_t edgeCount() const
+        {
+            return file.entryCount();
+        }
+
+        size_t outdegree(VertexHandle vertex) const
+        {
+            size_t vertexIndex = checkHandle(vertex);
+            return static_cast<size_t>(file.offsets()[vertexIndex + 1] - file.offsets()[vertexIndex]);
+        }
+
+        bool hasEdge(VertexHandle src, VertexHandle dest) const
+        {
+            return file.find(checkHandle(src), checkHandle(dest)) != npos;
+        }
+
+        const EdgeType &getEdge(VertexHandle src, VertexHandle dest) const
+        {
+            size_t entry = file.find(checkHandle(src), checkHandle(dest));
+            if (entry == npos)
+                throw std::runtime_error("No Edge exists between the given vertices.");
+            return file.value(entry);
+        }
+
+        // Whether an entry is directed; for files of directed or undirected graphs every
+        // entry has the graph's direction.
+        bool isDirected(VertexHandle src, VertexHandle dest) const
+        {
+            size_t entry = file.find(checkHandle(src), checkHandle(dest));
+            if (entry == npos)
+                throw std::runtime_error("No Edge exists between the given vertices.");
+            return file.isDirected(entry);
+        }
+
+        // Calls f(VertexHandle dest, const EdgeType &value) for every entry of the row, in
+        // destination order. f may return false to stop.
+        template <typename Fn>
+        void forEachOutEdge(VertexHandle vertex, Fn &&f) const
+        {
+            size_t vertexIndex = checkHandle(vertex);
+            const uint64_t *targets = file.targets();
+            for (size_t entry = file.offsets()[vertexIndex]; entry < file.offsets()[vertexIndex + 1]; ++entry)
+            {
+                if (!detail::keepVisiting(f, VertexHandle(static_cast<size_t>(targets[entry])), file.value(entry)))
+                    return;
+            }
+        }
+
+    private:
+        static constexpr size_t npos = detail::GraphFile<VertexType, EdgeType>::npos;
+
+        detail::GraphFile<VertexType, EdgeType> file;
+        std::vector<VertexType> vertices;
+        VertexIndex vertexToIndex;
+
+        size_t checkHandle(VertexHandle vertex) const
+        {
+            if (vertex.index >= vertices.size())
+                throw std::invalid_argument("Vertex handle does not belong to the graph");
+            return vertex.index;
+        }
+    };
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+#include <type_traits>
+#include "GraphCommon.h"
+#include "MatrixStorage.h"
+#include "Parallel.h"
+
+namespace Appledore
+{
+    enum class TriangleKernel
+    {
+        // Bitset when the oriented graph is dense enough, sorted intersection otherwise.
+        Auto,
+        // Merge of two sorted oriented neighbor lists, O(E) memory.
+        SortedIntersection,
+        // AND of two packed oriented rows plus popcount, n^2 / 8 bytes.
+        Bitset
+    };
+
+    struct TriangleOptions
+    {
+        TriangleKernel kernel = TriangleKernel::Auto;
+        // Threads over vertices, 0 = one per hardware thread.
+        unsigned threads = 1;
+    };
+
+    // Triangle counts and clustering coefficients, per-vertex entries indexed by VertexHandle::index.
+    struct TriangleCounts
+    {
+        size_t triangles = 0;
+        std::vector<size_t> perVertex;
+        // Local clustering coefficient: triangles / (degree choose 2), 0 below degree 2.
+        std::vector<double> clustering;
+        double averageClustering = 0.0;
+        // Global clustering (transitivity): 3 * triangles / connected triples.
+        double transitivity = 0.0;
+    };
+
+    // Counts triangles of an undirected graph (GraphMatrix, GraphCSR, GraphList). Self loops are ignored.
+    // Edges are oriented from lower to higher (degree, index) so every triangle is found exactly
+    // once, at its lowest vertex, and no oriented list is longer than sqrt(2E).
+    template <typename Graph>
+    TriangleCounts countTriangles(const Graph &graph, const TriangleOptions &options = {})
+    {
+        static_assert(std::is_same_v<typename Graph::DirectionTag, UndirectedG>,
+                      "triangle counting needs an undirected graph");
+
+        const size_t vertexCount = graph.getVertices().size();
+        constexpr size_t chunk = 64;
+
+        std::vector<size_t> degree(vertexCount, 0);
+        for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            graph.forEachOutEdge(VertexHandle(vertex), [&](VertexHandle dest, const auto &)
+                                 {
+                                     if (dest.index != vertex)
+                                         degree[vertex]++; });
+        }
+
+        auto before = [&](size_t a, size_t b)
+        {
+            return degree[a] < degree[b] || (degree[a] == degree[b] && a < b);
+        };
+
+        // oriented adjacency in CSR form, rows sorted by index
+        std::vector<size_t> offsets(vertexCount + 1, 0);
+        for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            graph.forEachOutEdge(VertexHandle(vertex), [&](VertexHandle dest, const auto &)
+                                 {
+                                     if (dest.index != vertex && before(vertex, dest.index))
+                                         offsets[vertex + 1]++; });
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        std::vector<size_t> oriented(offsets[vertexCount]);
+        {
+            std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+            {
+                graph.forEachOutEdge(VertexHandle(vertex), [&](VertexHandle dest, const auto &)
+                                     {
+                                         if (dest.index != vertex && before(vertex, dest.index))
+                                             oriented[fill[vertex]++] = dest.index; });
+                std::sort(oriented.begin() + offsets[vertex], oriented.begin() + offsets[vertex + 1]);
+            }
+        }
+
+        TriangleKernel kernel = options.kernel;
+        if (kernel == TriangleKernel::Auto)
+        {
+            // packed rows pay off once an average row fills more than one word in 64
+            kernel = oriented.size() * 64 > vertexCount * vertexCount ? TriangleKernel::Bitset
+                                                                      : TriangleKernel::SortedIntersection;
+        }
+
+        size_t wordsPerRow = (vertexCount + 63) / 64;
+        std::vector<uint64_t> rows;
+        if (kernel == TriangleKernel::Bitset)
+        {
+            rows.assign(vertexCount * wordsPerRow, 0);
+            for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+            {
+                for (size_t pos = offsets[vertex]; pos < offsets[vertex + 1]; ++pos)
+                {
+                    rows[vertex * wordsPerRow + oriented[pos] / 64] |= uint64_t(1) << (oriented[pos] % 64);
+                }
+            }
+        }
+
+        std::vector<std::atomic<size_t>> perVertex(vertexCount);
+        for (auto &count : perVertex)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+        std::vector<size_t> workerTotals(detail::parallelWorkers((vertexCount + chunk - 1) / chunk, options.threads), 0);
+
+        auto found = [&](size_t u, size_t v, size_t w, unsigned worker)
+        {
+            workerTotals[worker]++;
+            perVertex[u].fetch_add(1, std::memory_order_relaxed);
+            perVertex[v].fetch_add(1, std::memory_order_relaxed);
+            perVertex[w].fetch_add(1, std::memory_order_relaxed);
+        };
+
+        detail::parallelFor((vertexCount + chunk - 1) / chunk, options.threads, [&](size_t item, unsigned worker)
+                            {
+                                size_t end = std::min(vertexCount, (item + 1) * chunk);
+                                for (size_t u = item * chunk; u < end; ++u)
+                                {
+                                    for (size_t pos = offsets[u]; pos < offsets[u + 1]; ++pos)
+                                    {
+                                        size_t v = oriented[pos];
+                                        if (kernel == TriangleKernel::Bitset)
+                                        {
+                                            const uint64_t *rowU = rows.data() + u * wordsPerRow;
+                                            const uint64_t *rowV = rows.data() + v * wordsPerRow;
+                                            for (size_t word = 0; word < wordsPerRow; ++word)
+                                            {
+                                                uint64_t common = rowU[word] & rowV[word];
+                                                while (common)
+                                                {
+                                                    found(u, v, word * 64 + detail::countTrailingZeros64(common), worker);
+                                                    common &= common - 1;
+                                                }
+                                            }
+                                        }
+                                        else
+                                        {
+                                            size_t a = offsets[u], aEnd = offsets[u + 1];
+                                            size_t b = offsets[v], bEnd = offsets[v + 1];
+                                            while (a < aEnd && b < bEnd)
+                                            {
+                                                if (oriented[a] < oriented[b])
+                                                    ++a;
+                                                else if (oriented[b] < oriented[a])
+                                                    ++b;
+                                                else
+                                                {
+                                                    found(u, v, oriented[a], worker);
+                                                    ++a;
+                                                    ++b;
+                                                }
+                                            }
+                                        }
+                                    }
+                                } });
+
+        TriangleCounts result;
+        result.triangles = std::accumulate(workerTotals.begin(), workerTotals.end(), size_t(0));
+        result.perVertex.resize(vertexCount);
+        result.clustering.assign(vertexCount, 0.0);
+
+        double triples = 0.0;
+        double clusteringSum = 0.0;
+        for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            result.perVertex[vertex] = perVertex[vertex].load(std::memory_order_relaxed);
+            double pairs = degree[vertex] * (degree[vertex] - 1.0) / 2.0;
+            if (degree[vertex] >= 2)
+                result.clustering[vertex] = result.perVertex[vertex] / pairs;
+            triples += degree[vertex] >= 2 ? pairs : 0.0;
+            clusteringSum += result.clustering[vertex];
+        }
+        if (vertexCount > 0)
+            result.averageClustering = clusteringSum / vertexCount;
+        if (triples > 0)
+            result.transitivity = 3.0 * result.triangles / triples;
+        return result;
+    }
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <string_view>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
+#include "GraphCommon.h"
+
+namespace Appledore
+{
+    namespace detail
+    {
+        template <typename Key>
+        inline constexpr bool isStringLike = std::is_convertible_v<const Key &, std::string_view>;
+
+        // Keys looked up without building a VertexType first: the vertex type itself, or any
+        // string-like key when the vertices are strings (std::string_view, const char*, literals).
+        template <typename VertexType, typename Key>
+        inline constexpr bool isTransparentKey =
+            std::is_same_v<std::decay_t<Key>, VertexType> ||
+            (isStringLike<VertexType> && isStringLike<Key>);
+    }
+
+    // Hasher used by HashedVertexIndex, string-like keys all hash through std::string_view
+    // so a std::string vertex and a const char* key land in the same slot.
+    struct VertexHash
+    {
+        using is_transparent = void;
+
+        template <typename Key>
+        size_t operator()(const Key &key) const
+        {
+            if constexpr (detail::isStringLike<Key>)
+                return std::hash<std::string_view>{}(std::string_view(key));
+            else
+                return std::hash<Key>{}(key);
+        }
+    };
+
+    // Default vertex -> index lookup, an ordered map (VertexType needs operator<).
+    template <typename VertexType>
+    class OrderedVertexIndex
+    {
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        // Index of key, npos if absent.
+        template <typename Key>
+        size_t find(const Key &key, const std::vector<VertexType> &) const
+        {
+            if constexpr (detail::isTransparentKey<VertexType, Key>)
+            {
+                auto it = map.find(key);
+                return it == map.end() ? npos : it->second;
+            }
+            else
+            {
+                auto it = map.find(VertexType(key));
+                return it == map.end() ? npos : it->second;
+            }
+        }
+
+        // Register vertices[index] under its own value.
+        void insert(size_t index, const std::vector<VertexType> &vertices)
+        {
+            map.emplace(vertices[index], index);
+        }
+
+        // Forget vertices[index]; the vector still holds it.
+        void erase(size_t index, const std::vector<VertexType> &vertices)
+        {
+            map.erase(vertices[index]);
+        }
+
+        // vertices[from] is about to move to index `to`.
+        void relocate(size_t from, size_t to, const std::vector<VertexType> &vertices)
+        {
+            map.find(vertices[from])->second = to;
+        }
+
+        size_t size() const
+        {
+            return map.size();
+        }
+
+        // Estimated heap bytes: one tree node (colour and three links plus the entry) per
+        // vertex; heap memory owned by the keys themselves is not counted.
+        size_t memoryBytes() const
+        {
+            return map.size() * (sizeof(typename decltype(map)::value_type) + 4 * sizeof(void *));
+        }
+
+    private:
+        std::map<VertexType, size_t, std::less<>> map;
+    };
+
+    // Open-addressing (linear probing) vertex -> index lookup.
+    // Slots only hold the cached hash and the vertex index, keys are compared against the
+    // graph's own vertex vector, so a lookup is one probe sequence and no key copies are kept.
+    template <typename VertexType, typename Hash = VertexHash, typename KeyEqual = std::equal_to<>>
+    class HashedVertexIndex
+    {
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        template <typename Key>
+        size_t find(const Key &key, const std::vector<VertexType> &vertices) const
+        {
+            if constexpr (detail::isTransparentKey<VertexType, Key>)
+            {
+                return findSlot(key, hasher(key), vertices);
+            }
+            else
+            {
+                VertexType vertex(key);
+                return findSlot(vertex, hasher(vertex), vertices);
+            }
+        }
+
+        void insert(size_t index, const std::vector<VertexType> &vertices)
+        {
+            if ((count + 1) * 2 > slots.size())
+            {
+                rehash(slots.empty() ? 16 : slots.size() * 2);
+            }
+            place(hasher(vertices[index]), index);
+            count++;
+        }
+
+        // Backward-shift deletion: later slots of the probe run move up into the hole, so
+        // lookups never need tombstones.
+        void erase(size_t index, const std::vector<VertexType> &vertices)
+        {
+            size_t mask = slots.size() - 1;
+            size_t hole = slotOf(index, vertices);
+            for (size_t pos = (hole + 1) & mask; slots[pos].index != npos; pos = (pos + 1) & mask)
+            {
+                // a slot may fill the hole only if its home is not inside (hole, pos]
+                if (((pos - home(slots[pos].hash)) & mask) >= ((pos - hole) & mask))
+                {
+                    slots[hole] = slots[pos];
+                    hole = pos;
+                }
+            }
+            slots[hole].index = npos;
+            count--;
+        }
+
+        void relocate(size_t from, size_t to, const std::vector<VertexType> &vertices)
+        {
+            slots[slotOf(from, vertices)].index = to;
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        size_t memoryBytes() const
+        {
+            return slots.capacity() * sizeof(Slot);
+        }
+
+    private:
+        struct Slot
+        {
+            size_t hash;
+            size_t index = npos;
+        };
+
+        std::vector<Slot> slots;
+        size_t count = 0;
+        Hash hasher;
+        KeyEqual equal;
+
+        // Fibonacci mixing so that identity hashes (integers) still spread over the table.
+        size_t home(size_t hash) const
+        {
+            return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> 32) & (slots.size() - 1);
+        }
+
+        template <typename Key>
+        size_t findSlot(const Key &key, size_t hash, const std::vector<VertexType> &vertices) const
+        {
+            if (slots.empty())
+                return npos;
+
+            size_t mask = slots.size() - 1;
+            for (size_t pos = home(hash);; pos = (pos + 1) & mask)
+            {
+                const Slot &slot = slots[pos];
+                if (slot.index == npos)
+                    return npos;
+                if (slot.hash == hash && equal(vertices[slot.index], key))
+                    return slot.index;
+            }
+        }
+
+        // Slot holding vertices[index], which must be in the table.
+        size_t slotOf(size_t index, const std::vector<VertexType> &vertices) const
+        {
+            size_t mask = slots.size() - 1;
+            size_t pos = home(hasher(vertices[index]));
+            while (slots[pos].index != index)
+            {
+                pos = (pos + 1) & mask;
+            }
+            return pos;
+        }
+
+        void place(size_t hash, size_t index)
+        {
+            size_t mask = slots.size() - 1;
+            size_t pos = home(hash);
+            while (slots[pos].index != npos)
+            {
+                pos = (pos + 1) & mask;
+            }
+            slots[pos] = {hash, index};
+        }
+
+        void rehash(size_t newSize)
+        {
+            std::vector<Slot> old(newSize);
+            old.swap(slots);
+            for (const Slot &slot : old)
+            {
+                if (slot.index != npos)
+                    place(slot.hash, slot.index);
+            }
+        }
+    };
+
+    // Direct id -> index table for vertex types derived from GraphVertex, the default for them:
+    // a lookup is one array load. The table is as long as the highest id inserted, and ids are
+    // drawn process-wide, so it suits graphs holding most of the vertices a program creates.
+    // Keys must be GraphVertex objects; a copy of a vertex finds the original.
+    template <typename VertexType>
+    class IdVertexIndex
+    {
+        static_assert(std::is_base_of_v<GraphVertex, VertexType>, "IdVertexIndex needs a GraphVertex-derived vertex type");
+
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        template <typename Key>
+        size_t find(const Key &key, const std::vector<VertexType> &) const
+        {
+            static_assert(std::is_base_of_v<GraphVertex, Key>, "GraphVertex-derived vertices are looked up by vertex");
+            size_t id = static_cast<const GraphVertex &>(key).id;
+            return id < slots.size() ? slots[id] : npos;
+        }
+
+        void insert(size_t index, const std::vector<VertexType> &vertices)
+        {
+            size_t id = vertices[index].id;
+            if (id >= slots.size())
+                slots.resize(std::max(id + 1, slots.size() * 2), npos);
+            slots[id] = index;
+            count++;
+        }
+
+        void erase(size_t index, const std::vector<VertexType> &vertices)
+        {
+            slots[vertices[index].id] = npos;
+            count--;
+        }
+
+        void relocate(size_t from, size_t to, const std::vector<VertexType> &vertices)
+        {
+            slots[vertices[from].id] = to;
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        size_t memoryBytes() const
+        {
+            return slots.capacity() * sizeof(size_t);
+        }
+
+    private:
+        std::vector<size_t> slots;
+        size_t count = 0;
+    };
+
+    // Vertex index a graph uses when none is given: ids for GraphVertex types, std::map otherwise.
+    template <typename VertexType>
+    using DefaultVertexIndex = std::conditional_t<std::is_base_of_v<GraphVertex, VertexType>,
+                                                  IdVertexIndex<VertexType>, OrderedVertexIndex<VertexType>>;
+}
@@ -0,0 +1,172 @@
+// Tiled Floyd-Warshall, on several threads and with tiles smaller than the graph, must match a
+// plain Floyd-Warshall; bool edges count 1 each, and integer weights whose paths could reach
+// infinity() are rejected rather than reported unreachable.
+#include <limits>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+#include "TestCheck.h"
+#include "../include/GraphMatrix.h"
+#include "../include/MixedGraph.h"
+#include "../include/AllPairs.h"
+
+using namespace Appledore;
+
+constexpr long long unreachable = std::numeric_limits<long long>::max();
+
+template <typename Graph>
+std::vector<long long> floydWarshall(const Graph &graph)
+{
+    size_t n = graph.getVertices().size();
+    std::vector<long long> distance(n * n, unreachable);
+    for (size_t src = 0; src < n; ++src)
+    {
+        distance[src * n + src] = 0;
+        graph.forEachOutEdge(VertexHandle(src), [&](VertexHandle dest, const auto &edge)
+                             {
+                                 long long length = static_cast<long long>(EdgeValue()(edge));
+                                 distance[src * n + dest.index] = std::min(distance[src * n + dest.index], length); });
+    }
+    for (size_t k = 0; k < n; ++k)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                if (distance[i * n + k] != unreachable && distance[k * n + j] != unreachable)
+                    distance[i * n + j] = std::min(distance[i * n + j], distance[i * n + k] + distance[k * n + j]);
+            }
+        }
+    }
+    return distance;
+}
+
+template <typename Graph>
+void checkAgainstFloydWarshall(const Graph &graph, const AllPairsOptions &options)
+{
+    size_t n = graph.getVertices().size();
+    std::vector<long long> expected = floydWarshall(graph);
+    auto result = allPairsShortestPaths(graph, EdgeValue(), options);
+    CHECK(result.vertexCount == n);
+    for (size_t src = 0; src < n; ++src)
+    {
+        for (size_t dest = 0; dest < n; ++dest)
+        {
+            long long want = expected[src * n + dest];
+            CHECK(result.reachable(VertexHandle(src), VertexHandle(dest)) == (want != unreachable));
+            if (want == unreachable)
+                continue;
+            CHECK(static_cast<long long>(result.at(VertexHandle(src), VertexHandle(dest))) == want);
+            if (!options.nextHop)
+                continue;
+            // the recorded route has the reported length
+            std::vector<VertexHandle> route = result.path(VertexHandle(src), VertexHandle(dest));
+            CHECK(route.front().index == src && route.back().index == dest);
+            long long length = 0;
+            for (size_t step = 1; step < route.size(); ++step)
+            {
+                CHECK(graph.hasEdge(route[step - 1], route[step]));
+                graph.forEachOutEdge(route[step - 1], [&](VertexHandle dest, const auto &edge)
+                                     {
+                                         if (dest == route[step])
+                                             length += static_cast<long long>(EdgeValue()(edge)); });
+            }
+            CHECK(length == want);
+        }
+    }
+}
+
+void checkRandomGraphs()
+{
+    std::mt19937 rng(11);
+    for (int round = 0; round < 12; ++round)
+    {
+        // sizes off a tile multiple, so the padding is exercised
+        int vertexCount = 1 + static_cast<int>(rng() % 70);
+        GraphMatrix<int, int, DirectedG> graph;
+        for (int vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            graph.addVertex(vertex);
+        }
+        std::uniform_int_distribution<int> vertex(0, vertexCount - 1);
+        std::uniform_int_distribution<int> weight(0, 1000);
+        for (int edge = 0; edge < vertexCount * 3; ++edge)
+        {
+            graph.addEdge(vertex(rng), vertex(rng), weight(rng));
+        }
+        for (size_t blockSize : {size_t(1), size_t(8), size_t(64)})
+        {
+            checkAgainstFloydWarshall(graph, {blockSize, 4, false});
+            checkAgainstFloydWarshall(graph, {blockSize, 4, true});
+        }
+    }
+}
+
+// MixedGraphMatrix<int> has bool edges, which count 1 each.
+void checkBoolEdges()
+{
+    MixedGraphMatrix<int> graph;
+    for (int vertex = 0; vertex < 6; ++vertex)
+    {
+        graph.addVertex(vertex);
+    }
+    graph.addEdge(0, 1, true, true);
+    graph.addEdge(1, 2, true, true);
+    graph.addEdge(2, 3, true, true);
+    graph.addEdge(0, 3, true, true);
+    graph.addEdge(3, 4, true, false);
+
+    auto result = allPairsShortestPaths(graph, EdgeValue(), {4, 2, true});
+    CHECK(result.at(VertexHandle(0), VertexHandle(3)) == 1);
+    CHECK(result.at(VertexHandle(0), VertexHandle(4)) == 2);
+    CHECK(result.at(VertexHandle(4), VertexHandle(3)) == 1);
+    CHECK(!result.reachable(VertexHandle(3), VertexHandle(0)));
+    CHECK(!result.reachable(VertexHandle(0), VertexHandle(5)));
+    checkAgainstFloydWarshall(graph, {4, 2, true});
+}
+
+void checkRejectsHugeWeights()
+{
+    auto rejects = [](const GraphMatrix<int, int, DirectedG> &graph)
+    {
+        try
+        {
+            allPairsShortestPaths(graph);
+        }
+        catch (const std::invalid_argument &)
+        {
+            return true;
+        }
+        return false;
+    };
+
+    GraphMatrix<int, int, DirectedG> graph;
+    for (int vertex = 0; vertex < 3; ++vertex)
+    {
+        graph.addVertex(vertex);
+    }
+    // one edge past infinity()
+    graph.addEdge(0, 1, std::numeric_limits<int>::max() - 5);
+    CHECK(rejects(graph));
+
+    // each edge is fine, their path is not
+    const int third = DistanceMatrix<int>::infinity() / 2 + 1;
+    graph.updateEdge(0, 1, third);
+    graph.addEdge(1, 2, third);
+    CHECK(rejects(graph));
+
+    graph.updateEdge(1, 2, 7);
+    CHECK(!rejects(graph));
+    CHECK(allPairsShortestPaths(graph).at(VertexHandle(0), VertexHandle(2)) == third + 7);
+}
+
+int main()
+{
+    checkRandomGraphs();
+    checkBoolEdges();
+    checkRejectsHugeWeights();
+
+    std::puts("allPairs: ok");
+    return 0;
+}
@@ -0,0 +1,199 @@
+// bfs() in every direction mode and with several threads, checked against a plain queue-based
+// search on random sparse and dense graphs: levels must match exactly, and every parent must be
+// an in-neighbour one level up.
+#include <deque>
+#include <limits>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <type_traits>
+#include "TestCheck.h"
+#include "../include/BFS.h"
+#include "../include/GraphMatrix.h"
+#include "../include/MixedGraph.h"
+
+using namespace Appledore;
+
+// More than two of bfs()'s 256-vertex chunks, so bottom-up levels are split between workers.
+constexpr size_t vertexCount = 700;
+constexpr size_t unreached = BFSResult::unreached;
+
+// Mixed graphs have no DirectionTag.
+template <typename Graph, typename = void>
+constexpr bool isMixed = true;
+template <typename Graph>
+constexpr bool isMixed<Graph, std::void_t<typename Graph::DirectionTag>> = false;
+
+template <typename Graph>
+constexpr bool isUndirected()
+{
+    if constexpr (isMixed<Graph>)
+        return false;
+    else
+        return std::is_same_v<typename Graph::DirectionTag, UndirectedG>;
+}
+
+// The graph together with a plain adjacency matrix of its cells.
+template <typename Graph>
+struct RandomGraph
+{
+    Graph graph;
+    std::vector<std::vector<char>> edge;
+};
+
+template <typename Graph>
+RandomGraph<Graph> makeGraph(std::mt19937 &rng, size_t averageDegree)
+{
+    RandomGraph<Graph> random;
+    random.edge.assign(vertexCount, std::vector<char>(vertexCount, 0));
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        random.graph.addVertex(static_cast<int>(vertex));
+    }
+    for (size_t edges = 0; edges < vertexCount * averageDegree; ++edges)
+    {
+        int src = static_cast<int>(rng() % vertexCount);
+        int dest = static_cast<int>(rng() % vertexCount);
+        bool directed = !isUndirected<Graph>();
+        if constexpr (isMixed<Graph>)
+        {
+            directed = rng() % 2 == 0;
+            random.graph.addEdge(src, dest, 1, directed);
+        }
+        else
+        {
+            random.graph.addEdge(src, dest, 1);
+        }
+        random.edge[src][dest] = 1;
+        if (!directed)
+            random.edge[dest][src] = 1;
+    }
+    // a mixed edge added over the reverse of an undirected one turns that cell directed, so
+    // read the final cells back instead of replaying the additions
+    if constexpr (isMixed<Graph>)
+    {
+        for (size_t src = 0; src < vertexCount; ++src)
+        {
+            for (size_t dest = 0; dest < vertexCount; ++dest)
+            {
+                random.edge[src][dest] = random.graph.hasEdge(VertexHandle(src), VertexHandle(dest));
+            }
+        }
+    }
+    return random;
+}
+
+std::vector<size_t> bruteForceLevels(const std::vector<std::vector<char>> &edge, size_t source)
+{
+    std::vector<size_t> level(vertexCount, unreached);
+    std::deque<size_t> queue{source};
+    level[source] = 0;
+    while (!queue.empty())
+    {
+        size_t vertex = queue.front();
+        queue.pop_front();
+        for (size_t dest = 0; dest < vertexCount; ++dest)
+        {
+            if (edge[vertex][dest] && level[dest] == unreached)
+            {
+                level[dest] = level[vertex] + 1;
+                queue.push_back(dest);
+            }
+        }
+    }
+    return level;
+}
+
+void checkResult(const BFSResult &result, const std::vector<std::vector<char>> &edge, std::vector<size_t> expected,
+                 size_t source, size_t maxDepth)
+{
+    size_t deepest = 0;
+    for (size_t &level : expected)
+    {
+        if (level != unreached && level > maxDepth)
+            level = unreached;
+        if (level != unreached)
+            deepest = std::max(deepest, level);
+    }
+    CHECK(result.level == expected);
+    CHECK(result.maxDepth == deepest);
+    CHECK(result.parent.size() == vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        VertexHandle parent = result.parent[vertex];
+        CHECK(result.reached(VertexHandle(vertex)) == (expected[vertex] != unreached));
+        if (vertex == source || expected[vertex] == unreached)
+        {
+            CHECK(parent == VertexHandle());
+            continue;
+        }
+        CHECK(parent.index < vertexCount);
+        CHECK(edge[parent.index][vertex]);
+        CHECK(expected[parent.index] + 1 == expected[vertex]);
+    }
+}
+
+template <typename Graph>
+void checkGraph(unsigned seed)
+{
+    std::mt19937 rng(seed);
+    // sparse graphs stay top-down with long paths and unreached vertices, dense ones make
+    // Auto switch to bottom-up after a level or two
+    for (size_t averageDegree : {size_t(1), size_t(3), size_t(24)})
+    {
+        RandomGraph<Graph> random = makeGraph<Graph>(rng, averageDegree);
+        for (int round = 0; round < 3; ++round)
+        {
+            size_t source = rng() % vertexCount;
+            std::vector<size_t> expected = bruteForceLevels(random.edge, source);
+            for (BFSDirection direction : {BFSDirection::TopDown, BFSDirection::BottomUp, BFSDirection::Auto})
+            {
+                for (unsigned threads : {1u, 4u})
+                {
+                    for (size_t maxDepth : {std::numeric_limits<size_t>::max(), size_t(2)})
+                    {
+                        BFSOptions options;
+                        options.direction = direction;
+                        options.threads = threads;
+                        options.maxDepth = maxDepth;
+                        BFSResult result = bfs(random.graph, VertexHandle(source), options);
+                        checkResult(result, random.edge, expected, source, maxDepth);
+                    }
+                }
+            }
+
+            // switch thresholds that flip direction on nearly every level
+            BFSOptions eager;
+            eager.threads = 4;
+            eager.alpha = 1000.0;
+            eager.beta = 1.0;
+            checkResult(bfs(random.graph, VertexHandle(source), eager), random.edge, expected, source,
+                        std::numeric_limits<size_t>::max());
+        }
+    }
+}
+
+int main()
+{
+    for (unsigned seed = 1; seed <= 2; ++seed)
+    {
+        checkGraph<GraphMatrix<int, int, DirectedG>>(seed);
+        checkGraph<GraphMatrix<int, int, UndirectedG>>(seed);
+        checkGraph<GraphMatrix<int, int, DirectedG, HashedVertexIndex<int>, PagedEdges>>(seed);
+        checkGraph<MixedGraphMatrix<int, int>>(seed);
+    }
+
+    bool threw = false;
+    try
+    {
+        bfs(GraphMatrix<int, int, DirectedG>(), VertexHandle(0));
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+
+    std::puts("bfs: ok");
+    return 0;
+}
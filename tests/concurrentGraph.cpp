@@ -0,0 +1,160 @@
+// ConcurrentGraph: readers hold and release snapshots while a writer publishes updates; every
+// snapshot must stay a consistent, immutable version, and replaced versions must be freed once
+// no snapshot can reach them. With PagedEdges, versions share the pages an update left alone.
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+#include "TestCheck.h"
+#include "../include/GraphMatrix.h"
+#include "../include/ConcurrentGraph.h"
+
+using namespace Appledore;
+
+constexpr int updates = 300;
+constexpr int readers = 4;
+
+// Version n has vertices 0 .. n and a chain of edges i -> i + 1 weighted i.
+template <typename Graph>
+void checkVersion(const Graph &graph, uint64_t number)
+{
+    CHECK(graph.getVertices().size() == number + 1);
+    for (int vertex = 0; vertex < static_cast<int>(number); ++vertex)
+    {
+        CHECK(graph.getEdge(vertex, vertex + 1) == vertex);
+    }
+}
+
+template <typename Graph>
+void checkSnapshots()
+{
+    Graph initial;
+    initial.addVertex(0);
+    // fewer slots than the snapshots readers may hold at once, so they also wait for free slots
+    ConcurrentGraph<Graph> shared(initial, readers + 2);
+
+    // a snapshot held across every update keeps version 0 alive
+    auto pinned = shared.snapshot();
+    CHECK(pinned.versionNumber() == 0);
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int reader = 0; reader < readers; ++reader)
+    {
+        threads.emplace_back([&]
+                             {
+                                 uint64_t last = 0;
+                                 while (!done.load())
+                                 {
+                                     auto snapshot = shared.snapshot();
+                                     CHECK(snapshot.versionNumber() >= last);
+                                     last = snapshot.versionNumber();
+                                     checkVersion(*snapshot, last);
+                                     // hold one snapshot while taking another
+                                     auto again = shared.snapshot();
+                                     CHECK(again.versionNumber() >= last);
+                                 } });
+    }
+
+    for (int update = 1; update <= updates; ++update)
+    {
+        uint64_t number = shared.update([&](Graph &graph)
+                                        {
+                                            graph.addVertex(update);
+                                            graph.addEdge(update - 1, update, update - 1); });
+        CHECK(number == static_cast<uint64_t>(update));
+    }
+    done.store(true);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    // the pinned snapshot still sees version 0, so its version cannot have been freed
+    checkVersion(*pinned, 0);
+    CHECK(shared.reclaim() > 0);
+    pinned = shared.snapshot();
+    CHECK(pinned.versionNumber() == updates);
+    {
+        auto released = std::move(pinned);
+    }
+    CHECK(shared.reclaim() == 0);
+
+    // a throwing batch publishes nothing
+    bool threw = false;
+    try
+    {
+        shared.update([](Graph &graph)
+                      {
+                          graph.addVertex(-1);
+                          throw std::runtime_error("batch failed"); });
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(shared.versionNumber() == updates);
+    {
+        auto snapshot = shared.snapshot();
+        CHECK(!snapshot->findVertex(-1).has_value());
+        checkVersion(*snapshot, updates);
+    }
+    CHECK(shared.reclaim() == 0);
+}
+
+// An update shares every page it does not write with the previous version, and writing a
+// shared page leaves the previous version untouched.
+void checkPageSharing()
+{
+    using Graph = GraphMatrix<int, int, DirectedG, OrderedVertexIndex<int>, PagedEdges>;
+    constexpr int vertexCount = 200;
+    Graph initial;
+    for (int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        initial.addVertex(vertex);
+    }
+    for (int vertex = 0; vertex + 1 < vertexCount; ++vertex)
+    {
+        initial.addEdge(vertex, vertex + 1, vertex);
+    }
+    ConcurrentGraph<Graph> shared(initial, 4);
+
+    auto before = shared.snapshot();
+    shared.update([](Graph &graph)
+                  {
+                      graph.updateEdge(5, 6, -5);
+                      graph.removeEdge(7, 8);
+                      graph.addEdge(10, 150, 1); });
+    auto after = shared.snapshot();
+
+    // rows 0 .. 63 were written, so their page was cloned; rows 64 and up were not
+    CHECK(&before->getEdge(1, 2) != &after->getEdge(1, 2));
+    CHECK(&before->getEdge(100, 101) == &after->getEdge(100, 101));
+    CHECK(&before->getEdge(198, 199) == &after->getEdge(198, 199));
+
+    CHECK(before->getEdge(5, 6) == 5 && after->getEdge(5, 6) == -5);
+    CHECK(before->hasEdge(7, 8) && !after->hasEdge(7, 8));
+    CHECK(!before->hasEdge(10, 150) && after->hasEdge(10, 150));
+    CHECK(before->outdegree(7) == 1 && after->outdegree(7) == 0);
+    CHECK(after->getEdge(1, 2) == 1 && after->getEdge(100, 101) == 100);
+
+    // removing a vertex moves the last one into its rows and column, again copy on write
+    shared.update([](Graph &graph)
+                  { graph.removeVertex(0); });
+    auto removed = shared.snapshot();
+    CHECK(!removed->findVertex(0).has_value());
+    CHECK(removed->getEdge(198, 199) == 198);
+    CHECK(after->findVertex(0).has_value() && after->getEdge(0, 1) == 0);
+}
+
+int main()
+{
+    checkSnapshots<GraphMatrix<int, int, DirectedG>>();
+    checkSnapshots<GraphMatrix<int, int, DirectedG, OrderedVertexIndex<int>, PagedEdges>>();
+    checkPageSharing();
+
+    std::puts("concurrentGraph: ok");
+    return 0;
+}
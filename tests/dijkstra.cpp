@@ -0,0 +1,135 @@
+// Dijkstra on bool-valued mixed graphs counts edges rather than flags, integer path lengths
+// saturate instead of overflowing, and both queues agree with Bellman-Ford on random graphs.
+#include <limits>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include "TestCheck.h"
+#include "../include/GraphMatrix.h"
+#include "../include/MixedGraph.h"
+#include "../include/Dijkstra.h"
+
+using namespace Appledore;
+
+// MixedGraphMatrix<int> has bool edges: every edge must weigh 1, and unreached must stay
+// distinct from a distance of 1.
+void checkBoolEdges()
+{
+    MixedGraphMatrix<int> graph;
+    for (int vertex = 0; vertex < 5; ++vertex)
+    {
+        graph.addVertex(vertex);
+    }
+    graph.addEdge(0, 1, true, true);
+    graph.addEdge(1, 2, true, true);
+    graph.addEdge(2, 3, true, true);
+    graph.addEdge(0, 3, true, true);
+
+    for (PriorityQueue queue : {PriorityQueue::DaryHeap, PriorityQueue::RadixHeap})
+    {
+        auto paths = dijkstra(graph, VertexHandle(0), EdgeValue(), {queue});
+        CHECK(paths.distance[1] == 1);
+        CHECK(paths.distance[2] == 2);
+        CHECK(paths.reached(VertexHandle(3)));
+        CHECK(paths.distance[3] == 1);
+        CHECK((paths.pathTo(VertexHandle(3)) == std::vector<VertexHandle>{VertexHandle(0), VertexHandle(3)}));
+        CHECK(!paths.reached(VertexHandle(4)));
+        CHECK(paths.pathTo(VertexHandle(4)).empty());
+    }
+}
+
+void checkSaturation()
+{
+    GraphMatrix<int, int, DirectedG> graph;
+    for (int vertex = 0; vertex < 4; ++vertex)
+    {
+        graph.addVertex(vertex);
+    }
+    const int big = std::numeric_limits<int>::max() - 5;
+    graph.addEdge(0, 1, big);
+    graph.addEdge(1, 2, 100);
+    graph.addEdge(1, 3, 4);
+
+    for (PriorityQueue queue : {PriorityQueue::DaryHeap, PriorityQueue::RadixHeap})
+    {
+        auto paths = dijkstra(graph, VertexHandle(0), EdgeValue(), {queue});
+        CHECK(paths.distance[1] == big);
+        CHECK(!paths.reached(VertexHandle(2)));
+        CHECK(paths.distance[2] == ShortestPaths<int>::infinity());
+        CHECK(paths.distance[3] == big + 4);
+    }
+}
+
+// Bellman-Ford over the edge list, with saturation at max().
+std::vector<long long> bellmanFord(const GraphMatrix<int, int, DirectedG> &graph, size_t source)
+{
+    const long long unreached = std::numeric_limits<long long>::max();
+    size_t vertexCount = graph.getVertices().size();
+    std::vector<long long> distance(vertexCount, unreached);
+    distance[source] = 0;
+    for (size_t round = 1; round < vertexCount; ++round)
+    {
+        for (size_t src = 0; src < vertexCount; ++src)
+        {
+            if (distance[src] == unreached)
+                continue;
+            graph.forEachOutEdge(VertexHandle(src), [&](VertexHandle dest, int weight)
+                                 { distance[dest.index] = std::min(distance[dest.index], distance[src] + weight); });
+        }
+    }
+    return distance;
+}
+
+void checkRandomGraphs()
+{
+    std::mt19937 rng(7);
+    for (int round = 0; round < 20; ++round)
+    {
+        const int vertexCount = 40;
+        GraphMatrix<int, int, DirectedG> graph;
+        for (int vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            graph.addVertex(vertex);
+        }
+        std::uniform_int_distribution<int> vertex(0, vertexCount - 1);
+        std::uniform_int_distribution<int> weight(0, 50);
+        for (int edge = 0; edge < 120; ++edge)
+        {
+            graph.addEdge(vertex(rng), vertex(rng), weight(rng));
+        }
+
+        size_t source = static_cast<size_t>(vertex(rng));
+        std::vector<long long> expected = bellmanFord(graph, source);
+        for (PriorityQueue queue : {PriorityQueue::DaryHeap, PriorityQueue::RadixHeap})
+        {
+            auto paths = dijkstra(graph, VertexHandle(source), EdgeValue(), {queue});
+            for (size_t dest = 0; dest < static_cast<size_t>(vertexCount); ++dest)
+            {
+                bool reached = expected[dest] != std::numeric_limits<long long>::max();
+                CHECK(paths.reached(VertexHandle(dest)) == reached);
+                if (!reached)
+                    continue;
+                CHECK(paths.distance[dest] == expected[dest]);
+                // the recorded path has the reported length
+                std::vector<VertexHandle> path = paths.pathTo(VertexHandle(dest));
+                CHECK(path.front().index == source && path.back().index == dest);
+                long long length = 0;
+                for (size_t step = 1; step < path.size(); ++step)
+                {
+                    length += graph.getEdge(path[step - 1], path[step]);
+                }
+                CHECK(length == expected[dest]);
+            }
+        }
+    }
+}
+
+int main()
+{
+    checkBoolEdges();
+    checkSaturation();
+    checkRandomGraphs();
+
+    std::puts("dijkstra: ok");
+    return 0;
+}
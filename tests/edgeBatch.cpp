@@ -0,0 +1,228 @@
+// addEdges/removeEdges/updateEdges must leave the graph, and report statuses, exactly as the
+// same items applied one by one through the single-edge API. Inline storages take the
+// parallel row-partitioned path, pooled and triangular ones the serial fallback.
+#include <tuple>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <type_traits>
+#include "TestCheck.h"
+#include "../include/GraphMatrix.h"
+#include "../include/MixedGraph.h"
+
+using namespace Appledore;
+
+constexpr int vertexCount = 60;
+// keys vertexCount .. vertexCount + 2 are never added
+constexpr int missingKeys = 3;
+constexpr unsigned threads = 8;
+
+// Mixed graphs have no DirectionTag.
+template <typename Graph, typename = void>
+constexpr bool isMixed = true;
+template <typename Graph>
+constexpr bool isMixed<Graph, std::void_t<typename Graph::DirectionTag>> = false;
+
+template <typename Graph>
+Graph makeGraph()
+{
+    Graph graph;
+    for (int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        graph.addVertex(vertex);
+    }
+    return graph;
+}
+
+template <typename Graph>
+int edgeValue(const Graph &graph, size_t src, size_t dest)
+{
+    if constexpr (isMixed<Graph>)
+        return graph.getEdgeValue(VertexHandle(src), VertexHandle(dest));
+    else
+        return graph.getEdge(VertexHandle(src), VertexHandle(dest));
+}
+
+template <typename Graph>
+void checkSame(const Graph &batched, const Graph &serial)
+{
+    for (size_t src = 0; src < vertexCount; ++src)
+    {
+        for (size_t dest = 0; dest < vertexCount; ++dest)
+        {
+            bool present = serial.hasEdge(VertexHandle(src), VertexHandle(dest));
+            CHECK(batched.hasEdge(VertexHandle(src), VertexHandle(dest)) == present);
+            if (present)
+                CHECK(edgeValue(batched, src, dest) == edgeValue(serial, src, dest));
+        }
+    }
+    std::vector<VertexDegree> expected = serial.degrees();
+    std::vector<VertexDegree> actual = batched.degrees();
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        CHECK(actual[vertex].indegree == expected[vertex].indegree);
+        CHECK(actual[vertex].outdegree == expected[vertex].outdegree);
+        CHECK(actual[vertex].totalDegree == expected[vertex].totalDegree);
+    }
+}
+
+template <typename Graph>
+BatchStatus serialRemove(Graph &graph, int src, int dest)
+{
+    if (src >= vertexCount || dest >= vertexCount)
+        return BatchStatus::MissingVertex;
+    if (!graph.hasEdge(src, dest))
+        return BatchStatus::MissingEdge;
+    graph.removeEdge(src, dest);
+    return BatchStatus::Applied;
+}
+
+template <typename Graph>
+BatchStatus serialUpdate(Graph &graph, int src, int dest, int value)
+{
+    if (src >= vertexCount || dest >= vertexCount)
+        return BatchStatus::MissingVertex;
+    if (!graph.hasEdge(src, dest))
+        return BatchStatus::MissingEdge;
+    graph.updateEdge(src, dest, value);
+    return BatchStatus::Applied;
+}
+
+// Random batches of adds, updates and removes over a small vertex set, so cells repeat within
+// a batch, with a few missing endpoints; batches span several resolution chunks.
+template <typename Graph>
+void compareRandomBatches(unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> key(0, vertexCount + missingKeys - 1);
+    std::uniform_int_distribution<int> value(1, 1000);
+    std::uniform_int_distribution<size_t> size(1, 6000);
+
+    Graph batched = makeGraph<Graph>();
+    Graph serial = makeGraph<Graph>();
+    for (int round = 0; round < 12; ++round)
+    {
+        size_t count = size(rng);
+        std::vector<BatchStatus> expected;
+        std::vector<BatchStatus> actual;
+        switch (round % 3)
+        {
+        case 0:
+        {
+            if constexpr (isMixed<Graph>)
+            {
+                std::vector<std::tuple<int, int, int, bool>> items;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    items.emplace_back(key(rng), key(rng), value(rng), rng() % 2 == 0);
+                }
+                actual = batched.addEdges(items, {threads});
+                for (const auto &[src, dest, edge, directed] : items)
+                {
+                    bool missing = src >= vertexCount || dest >= vertexCount;
+                    if (!missing)
+                        serial.addEdge(src, dest, edge, directed);
+                    expected.push_back(missing ? BatchStatus::MissingVertex : BatchStatus::Applied);
+                }
+            }
+            else
+            {
+                std::vector<std::tuple<int, int, int>> items;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    items.emplace_back(key(rng), key(rng), value(rng));
+                }
+                actual = batched.addEdges(items, {threads});
+                for (const auto &[src, dest, edge] : items)
+                {
+                    bool missing = src >= vertexCount || dest >= vertexCount;
+                    if (!missing)
+                        serial.addEdge(src, dest, edge);
+                    expected.push_back(missing ? BatchStatus::MissingVertex : BatchStatus::Applied);
+                }
+            }
+            break;
+        }
+        case 1:
+        {
+            std::vector<std::tuple<int, int, int>> items;
+            for (size_t i = 0; i < count; ++i)
+            {
+                items.emplace_back(key(rng), key(rng), value(rng));
+            }
+            actual = batched.updateEdges(items, {threads});
+            for (const auto &[src, dest, edge] : items)
+            {
+                expected.push_back(serialUpdate(serial, src, dest, edge));
+            }
+            break;
+        }
+        default:
+        {
+            std::vector<std::pair<int, int>> items;
+            for (size_t i = 0; i < count / 2; ++i)
+            {
+                items.emplace_back(key(rng), key(rng));
+            }
+            actual = batched.removeEdges(items, {threads});
+            for (const auto &[src, dest] : items)
+            {
+                expected.push_back(serialRemove(serial, src, dest));
+            }
+            break;
+        }
+        }
+        CHECK(actual == expected);
+        checkSame(batched, serial);
+    }
+}
+
+// Statuses for a hand-written batch: handles past the end and unknown keys are MissingVertex,
+// and removes and updates see the edges earlier items of the same batch added or removed.
+template <typename Graph>
+void checkStatuses()
+{
+    Graph graph = makeGraph<Graph>();
+
+    std::vector<std::tuple<VertexHandle, VertexHandle, int>> byHandle{
+        {VertexHandle(0), VertexHandle(1), 5}, {VertexHandle(0), VertexHandle(vertexCount), 5}};
+    CHECK((graph.addEdges(byHandle, {threads}) == std::vector<BatchStatus>{BatchStatus::Applied, BatchStatus::MissingVertex}));
+
+    std::vector<std::pair<int, int>> removals{{0, 1}, {0, 1}, {2, 3}, {vertexCount, 0}};
+    CHECK((graph.removeEdges(removals, {threads}) ==
+           std::vector<BatchStatus>{BatchStatus::Applied, BatchStatus::MissingEdge, BatchStatus::MissingEdge, BatchStatus::MissingVertex}));
+    CHECK(!graph.hasEdge(0, 1));
+
+    std::vector<std::tuple<int, int, int>> updates{{4, 5, 1}, {0, vertexCount + 1, 1}};
+    CHECK((graph.updateEdges(updates, {threads}) == std::vector<BatchStatus>{BatchStatus::MissingEdge, BatchStatus::MissingVertex}));
+
+    std::vector<std::tuple<int, int, int>> additions{{4, 5, 1}};
+    graph.addEdges(additions, {threads});
+    CHECK((graph.updateEdges(std::vector<std::tuple<int, int, int>>{{4, 5, 9}}, {threads}) == std::vector<BatchStatus>{BatchStatus::Applied}));
+    CHECK(edgeValue(graph, 4, 5) == 9);
+}
+
+template <typename Graph>
+void checkGraph()
+{
+    checkStatuses<Graph>();
+    for (unsigned seed = 1; seed <= 4; ++seed)
+    {
+        compareRandomBatches<Graph>(seed);
+    }
+}
+
+int main()
+{
+    checkGraph<GraphMatrix<int, int, DirectedG>>();
+    checkGraph<GraphMatrix<int, int, UndirectedG>>();
+    checkGraph<GraphMatrix<int, int, DirectedG, HashedVertexIndex<int>>>();
+    checkGraph<GraphMatrix<int, int, DirectedG, OrderedVertexIndex<int>, PooledEdges>>();
+    checkGraph<GraphMatrix<int, int, UndirectedG, OrderedVertexIndex<int>, PooledEdges>>();
+    checkGraph<GraphMatrix<int, int, UndirectedG, OrderedVertexIndex<int>, TriangularEdges>>();
+    checkGraph<MixedGraphMatrix<int, int>>();
+    checkGraph<MixedGraphMatrix<int, int, OrderedVertexIndex<int>, PooledEdges>>();
+
+    std::puts("edgeBatch: ok");
+    return 0;
+}
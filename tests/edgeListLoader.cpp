@@ -0,0 +1,281 @@
+// loadEdgeList() against a plain line-by-line reading of the same file: CRLF and LF lines, a
+// header, comments, blank lines and padded fields, cut into chunks as small as one byte and
+// parsed by several threads. Vertices must come out in key order and repeated edges keep the
+// weight of their last line.
+#include <map>
+#include <random>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include <type_traits>
+#include <unistd.h>
+#include "TestCheck.h"
+#include "../include/EdgeListLoader.h"
+#include "../include/GraphMatrix.h"
+#include "../include/MixedGraph.h"
+#include "../include/GraphCSR.h"
+
+using namespace Appledore;
+
+std::string tempPath(const std::string &name)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    return (directory / ("appledore-edgelist-" + std::to_string(::getpid()) + "-" + name + ".csv")).string();
+}
+
+void writeText(const std::string &path, const std::string &text)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+// What the file holds: every (src, dest) with the weight of its last line, and the key set.
+template <typename Vertex>
+struct EdgeList
+{
+    std::string text;
+    std::map<std::pair<Vertex, Vertex>, int> edges;
+    // every edge line in file order
+    std::vector<std::tuple<Vertex, Vertex, int>> lines;
+    std::vector<Vertex> vertices;
+};
+
+std::string vertexName(unsigned number, std::true_type)
+{
+    return std::to_string(number * 37);
+}
+
+// Names of different lengths, some long enough to leave the small-string buffer.
+std::string vertexName(unsigned number, std::false_type)
+{
+    return "city-" + std::string(number % 23, 'x') + std::to_string(number);
+}
+
+template <typename Vertex>
+EdgeList<Vertex> makeEdgeList(std::mt19937 &rng, size_t lineCount, bool header, bool weighted, char delimiter)
+{
+    EdgeList<Vertex> list;
+    std::map<Vertex, bool> keys;
+    auto lineEnd = [&]
+    {
+        return rng() % 3 ? "\r\n" : "\n";
+    };
+    // spaces and tabs around fields, but no tabs when they are the delimiter
+    auto pad = [&]
+    {
+        return std::string(rng() % 3, rng() % 2 || delimiter == '\t' ? ' ' : '\t');
+    };
+    if (header)
+        list.text += std::string("source") + delimiter + "target" + (weighted ? std::string(1, delimiter) + "weight" : "") + lineEnd();
+
+    for (size_t line = 0; line < lineCount; ++line)
+    {
+        if (rng() % 20 == 0)
+            list.text += rng() % 2 ? std::string("# a comment, 1, 2") + lineEnd() : pad() + lineEnd();
+
+        std::string src = vertexName(rng() % 60, std::is_arithmetic<Vertex>());
+        std::string dest = vertexName(rng() % 60, std::is_arithmetic<Vertex>());
+        int weight = static_cast<int>(rng() % 1000) - 500;
+        list.text += pad() + src + pad() + delimiter + pad() + dest + pad();
+        if (weighted)
+            list.text += delimiter + pad() + std::to_string(weight) + pad();
+        // the last line may end without a line break
+        if (line + 1 < lineCount || rng() % 2)
+            list.text += lineEnd();
+
+        Vertex srcKey, destKey;
+        if constexpr (std::is_arithmetic_v<Vertex>)
+        {
+            srcKey = static_cast<Vertex>(std::stoi(src));
+            destKey = static_cast<Vertex>(std::stoi(dest));
+        }
+        else
+        {
+            srcKey = src;
+            destKey = dest;
+        }
+        keys[srcKey] = keys[destKey] = true;
+        list.edges[{srcKey, destKey}] = weighted ? weight : 0;
+        list.lines.emplace_back(srcKey, destKey, weighted ? weight : 0);
+    }
+    for (const auto &key : keys)
+    {
+        list.vertices.push_back(key.first);
+    }
+    return list;
+}
+
+template <typename Graph>
+size_t storedEdges(const Graph &graph)
+{
+    size_t count = 0;
+    for (size_t vertex = 0; vertex < graph.getVertices().size(); ++vertex)
+    {
+        graph.forEachOutEdge(VertexHandle(vertex), [&](VertexHandle, const auto &)
+                             { count++; });
+    }
+    return count;
+}
+
+// Every chunk size from one byte up, with one and four threads.
+template <typename Graph, typename Check>
+void loadEveryWay(const std::string &path, EdgeListOptions options, size_t lines, size_t vertices, Check &&check)
+{
+    for (size_t chunkBytes : {size_t(1), size_t(7), size_t(64), size_t(4) << 20})
+    {
+        for (unsigned threads : {1u, 4u})
+        {
+            options.chunkBytes = chunkBytes;
+            options.threads = threads;
+            EdgeListStats stats;
+            Graph graph = loadEdgeList<Graph>(path, options, &stats);
+            CHECK(stats.edges == lines);
+            CHECK(stats.vertices == vertices);
+            CHECK(stats.bytes == std::filesystem::file_size(path));
+            CHECK(chunkBytes > stats.bytes || stats.chunks > 1);
+            check(graph);
+        }
+    }
+}
+
+void checkStringKeys(unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::string path = tempPath("strings");
+    for (bool header : {false, true})
+    {
+        auto list = makeEdgeList<std::string>(rng, 400, header, true, ',');
+        writeText(path, list.text);
+        EdgeListOptions options;
+        options.header = header;
+        loadEveryWay<GraphMatrix<std::string, double, DirectedG>>(
+            path, options, list.lines.size(), list.vertices.size(), [&](const auto &graph)
+            {
+                CHECK(graph.getVertices() == list.vertices);
+                CHECK(storedEdges(graph) == list.edges.size());
+                for (const auto &[ends, weight] : list.edges)
+                {
+                    CHECK(graph.getEdge(ends.first, ends.second) == weight);
+                } });
+    }
+    std::remove(path.c_str());
+}
+
+void checkNumberKeys(unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::string path = tempPath("numbers");
+    auto list = makeEdgeList<int>(rng, 500, true, true, '\t');
+    writeText(path, list.text);
+    EdgeListOptions options;
+    options.header = true;
+    options.delimiter = '\t';
+    loadEveryWay<GraphCSR<int, int, DirectedG>>(
+        path, options, list.lines.size(), list.vertices.size(), [&](const auto &graph)
+        {
+            CHECK(graph.getVertices() == list.vertices);
+            CHECK(graph.edgeCount() == list.edges.size());
+            for (const auto &[ends, weight] : list.edges)
+            {
+                CHECK(graph.getEdge(ends.first, ends.second) == weight);
+            } });
+
+    // a mixed graph takes every line as an undirected edge, so a pair keeps the weight of
+    // whichever of its two directions came last
+    auto undirected = makeEdgeList<int>(rng, 300, false, true, ',');
+    std::map<std::pair<int, int>, int> pairs;
+    for (const auto &[src, dest, weight] : undirected.lines)
+    {
+        pairs[std::minmax(src, dest)] = weight;
+    }
+    writeText(path, undirected.text);
+    loadEveryWay<MixedGraphMatrix<int, int>>(
+        path, EdgeListOptions{}, undirected.lines.size(), undirected.vertices.size(), [&](const auto &graph)
+        {
+            CHECK(graph.getVertices() == undirected.vertices);
+            size_t loops = static_cast<size_t>(std::count_if(pairs.begin(), pairs.end(), [](const auto &entry)
+                                                             { return entry.first.first == entry.first.second; }));
+            CHECK(storedEdges(graph) == 2 * pairs.size() - loops);
+            for (const auto &[ends, weight] : pairs)
+            {
+                CHECK(graph.getEdgeValue(ends.first, ends.second) == weight);
+                CHECK(graph.getEdgeValue(ends.second, ends.first) == weight);
+            } });
+
+    // no weight column
+    auto unweighted = makeEdgeList<int>(rng, 300, true, false, ',');
+    writeText(path, unweighted.text);
+    EdgeListOptions unweightedOptions;
+    unweightedOptions.header = true;
+    loadEveryWay<GraphMatrix<int, UnweightedG, DirectedG>>(
+        path, unweightedOptions, unweighted.lines.size(), unweighted.vertices.size(), [&](const auto &graph)
+        {
+            CHECK(graph.getVertices() == unweighted.vertices);
+            CHECK(storedEdges(graph) == unweighted.edges.size());
+            for (const auto &entry : unweighted.edges)
+            {
+                CHECK(graph.hasEdge(entry.first.first, entry.first.second));
+            } });
+    std::remove(path.c_str());
+}
+
+template <typename Fn>
+bool throwsRuntimeError(Fn &&fn)
+{
+    try
+    {
+        fn();
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+void checkEdgeCases()
+{
+    std::string path = tempPath("edge-cases");
+    using Graph = GraphMatrix<int, int, DirectedG>;
+    EdgeListOptions options;
+    options.header = true;
+    options.threads = 4;
+    options.chunkBytes = 1;
+
+    // only a header, with and without a line break
+    for (const char *text : {"src,dest,weight\r\n", "src,dest,weight", ""})
+    {
+        writeText(path, text);
+        Graph graph = loadEdgeList<Graph>(path, options);
+        CHECK(graph.getVertices().empty());
+    }
+
+    // with header off, the column names are a malformed vertex
+    writeText(path, "src,dest,weight\r\n1,2,3\r\n");
+    CHECK(throwsRuntimeError([&] { loadEdgeList<Graph>(path, EdgeListOptions{}); }));
+    writeText(path, "1,2,3\r\n4,5\r\n");
+    CHECK(throwsRuntimeError([&] { loadEdgeList<Graph>(path, EdgeListOptions{}); }));
+    writeText(path, "1,2,3\r\n4,5,x\r\n");
+    CHECK(throwsRuntimeError([&] { loadEdgeList<Graph>(path, EdgeListOptions{}); }));
+    CHECK(throwsRuntimeError([&] { loadEdgeList<Graph>(tempPath("missing"), options); }));
+    std::remove(path.c_str());
+}
+
+int main()
+{
+    for (unsigned seed = 1; seed <= 2; ++seed)
+    {
+        checkStringKeys(seed);
+        checkNumberKeys(seed);
+    }
+    checkEdgeCases();
+
+    std::puts("edgeListLoader: ok");
+    return 0;
+}
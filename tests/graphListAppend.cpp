@@ -0,0 +1,126 @@
+// appendEdge must leave a GraphList or MixedGraphList exactly as addEdge does for edges that
+// are not there yet, mirroring undirected edges, and reject unknown vertices.
+#include <cstdio>
+#include <stdexcept>
+#include "TestCheck.h"
+#include "../include/GraphList.h"
+
+using namespace Appledore;
+
+constexpr int vertexCount = 40;
+
+template <typename Graph>
+Graph makeGraph()
+{
+    Graph graph;
+    for (int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        graph.addVertex(vertex);
+    }
+    return graph;
+}
+
+template <typename Graph>
+void checkSame(const Graph &appended, const Graph &added)
+{
+    for (int src = 0; src < vertexCount; ++src)
+    {
+        for (int dest = 0; dest < vertexCount; ++dest)
+        {
+            CHECK(appended.hasEdge(src, dest) == added.hasEdge(src, dest));
+        }
+    }
+}
+
+template <typename Graph>
+void checkRejectsMissing(Graph &graph)
+{
+    bool threw = false;
+    try
+    {
+        graph.appendEdge(0, vertexCount, 1);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// Every pair src < dest with (src * 7 + dest) % 5 == 0, plus self loops on multiples of 9.
+bool picked(int src, int dest)
+{
+    return src == dest ? src % 9 == 0 : src < dest && (src * 7 + dest) % 5 == 0;
+}
+
+template <typename Direction>
+void checkGraphList()
+{
+    using Graph = GraphList<int, int, Direction>;
+    Graph appended = makeGraph<Graph>();
+    Graph added = makeGraph<Graph>();
+    for (int src = 0; src < vertexCount; ++src)
+    {
+        for (int dest = 0; dest < vertexCount; ++dest)
+        {
+            if (picked(src, dest))
+            {
+                appended.appendEdge(src, dest, src + dest);
+                added.addEdge(src, dest, src + dest);
+            }
+        }
+    }
+    checkSame(appended, added);
+    CHECK(appended.getAllEdges() == added.getAllEdges());
+    for (int src = 0; src < vertexCount; ++src)
+    {
+        CHECK(appended.indegree(src) == added.indegree(src));
+        CHECK(appended.outdegree(src) == added.outdegree(src));
+        for (int dest = 0; dest < vertexCount; ++dest)
+        {
+            if (added.hasEdge(src, dest))
+                CHECK(appended.getEdge(src, dest) == added.getEdge(src, dest));
+        }
+    }
+    checkRejectsMissing(appended);
+}
+
+void checkMixedGraphList()
+{
+    using Graph = MixedGraphList<int, int>;
+    Graph appended = makeGraph<Graph>();
+    Graph added = makeGraph<Graph>();
+    for (int src = 0; src < vertexCount; ++src)
+    {
+        for (int dest = 0; dest < vertexCount; ++dest)
+        {
+            if (picked(src, dest))
+            {
+                bool directed = (src + dest) % 2 == 0;
+                appended.appendEdge(src, dest, src + dest, directed);
+                added.addEdge(src, dest, src + dest, directed);
+            }
+        }
+    }
+    checkSame(appended, added);
+    CHECK(appended.getEdges() == added.getEdges());
+    for (int src = 0; src < vertexCount; ++src)
+    {
+        for (int dest = 0; dest < vertexCount; ++dest)
+        {
+            if (added.hasEdge(src, dest))
+                CHECK(appended.getEdgeValue(src, dest) == added.getEdgeValue(src, dest));
+        }
+    }
+    checkRejectsMissing(appended);
+}
+
+int main()
+{
+    checkGraphList<DirectedG>();
+    checkGraphList<UndirectedG>();
+    checkMixedGraphList();
+
+    std::puts("graphListAppend: ok");
+    return 0;
+}
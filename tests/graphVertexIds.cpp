@@ -0,0 +1,96 @@
+// A graph saved in one process and loaded in another must not hand out the loaded vertices'
+// ids to vertices created afterwards.
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <filesystem>
+#include "TestCheck.h"
+#include "../include/GraphMatrix.h"
+#include "../include/MixedGraph.h"
+#include "../include/GraphList.h"
+#include "../include/GraphCSR.h"
+#include "../include/Serialization.h"
+
+using namespace Appledore;
+
+struct Station : GraphVertex
+{
+    int platforms = 0;
+};
+
+// Saves two vertices whose ids follow 50 throwaway ones, then restarts the id sequence as a
+// fresh process would and returns their ids.
+template <typename Graph, typename AddEdge>
+std::vector<size_t> saveAfterThrowaways(const std::string &path, AddEdge &&addEdge)
+{
+    GraphVertex::nextId.store(1);
+    for (int i = 0; i < 50; ++i)
+    {
+        Station throwaway;
+        (void)throwaway;
+    }
+    Station first, second;
+    Graph graph;
+    graph.addVertex(first);
+    graph.addVertex(second);
+    addEdge(graph, first, second);
+    graph.save(path);
+    GraphVertex::nextId.store(1);
+    return {first.id, second.id};
+}
+
+template <typename Graph, typename AddEdge>
+void checkReload(const std::string &path, AddEdge &&addEdge)
+{
+    std::vector<size_t> saved = saveAfterThrowaways<Graph>(path, addEdge);
+    CHECK(saved[0] == 51 && saved[1] == 52);
+
+    Graph graph = Graph::load(path);
+    CHECK(GraphVertex::nextId.load() > saved[1]);
+    for (int i = 0; i < 60; ++i)
+    {
+        graph.addVertex(Station());
+    }
+    CHECK(graph.getVertices().size() == 62);
+}
+
+int main()
+{
+    std::string path = (std::filesystem::temp_directory_path() / "appledoreGraphVertexIds.bin").string();
+
+    checkReload<GraphMatrix<Station, int, DirectedG>>(path, [](auto &graph, const Station &src, const Station &dest)
+                                                      { graph.addEdge(src, dest, 7); });
+    checkReload<MixedGraphMatrix<Station, int>>(path, [](auto &graph, const Station &src, const Station &dest)
+                                                { graph.addEdge(src, dest, 7, true); });
+    checkReload<GraphList<Station, int, UndirectedG>>(path, [](auto &graph, const Station &src, const Station &dest)
+                                                      { graph.addEdge(src, dest, 7); });
+    checkReload<MixedGraphList<Station, int>>(path, [](auto &graph, const Station &src, const Station &dest)
+                                              { graph.addEdge(src, dest, 7, true); });
+
+    // GraphCSR is built once, MappedGraph only reads: check the id sequence directly
+    {
+        std::vector<size_t> saved = saveAfterThrowaways<GraphCSR<Station, int, DirectedG>>(path, [](auto &graph, const Station &src, const Station &dest)
+                                                                                            {
+                                                                                                graph.addEdge(src, dest, 7);
+                                                                                                graph.finalize(); });
+        GraphCSR<Station, int, DirectedG> loaded = GraphCSR<Station, int, DirectedG>::load(path);
+        CHECK(loaded.getVertices().size() == 2);
+        CHECK(Station().id > saved[1]);
+    }
+    {
+        std::vector<size_t> saved = saveAfterThrowaways<GraphMatrix<Station, int, DirectedG>>(path, [](auto &graph, const Station &src, const Station &dest)
+                                                                                              { graph.addEdge(src, dest, 7); });
+        MappedGraph<Station, int> mapped(path);
+        CHECK(Station().id > saved[1]);
+        CHECK(mapped.findVertex(mapped.getVertices()[1]).has_value());
+    }
+
+    // reserveId never moves the sequence backwards
+    size_t next = GraphVertex::nextId.load();
+    GraphVertex::reserveId(1);
+    CHECK(GraphVertex::nextId.load() == next);
+
+    std::filesystem::remove(path);
+    std::puts("graphVertexIds: ok");
+    return 0;
+}
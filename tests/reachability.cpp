@@ -0,0 +1,149 @@
+// ReachabilityIndex with the transitive closure (one and several threads) and with 2-hop
+// labels, checked pair by pair against a search from every vertex on random graphs.
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+#include <type_traits>
+#include "TestCheck.h"
+#include "../include/Reachability.h"
+#include "../include/GraphMatrix.h"
+#include "../include/MixedGraph.h"
+
+using namespace Appledore;
+
+// Not a multiple of 64, so the last closure word of each row is partly used.
+constexpr size_t vertexCount = 300;
+
+// Mixed graphs have no DirectionTag.
+template <typename Graph, typename = void>
+constexpr bool isMixed = true;
+template <typename Graph>
+constexpr bool isMixed<Graph, std::void_t<typename Graph::DirectionTag>> = false;
+
+// Random edges, mostly from lower to higher keys so that long one-way chains form, plus a few
+// back edges that close cycles.
+template <typename Graph>
+Graph makeGraph(std::mt19937 &rng, size_t edgeCount, unsigned backEdgePercent)
+{
+    Graph graph;
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        graph.addVertex(static_cast<int>(vertex));
+    }
+    for (size_t edge = 0; edge < edgeCount; ++edge)
+    {
+        int src = static_cast<int>(rng() % vertexCount);
+        int dest = static_cast<int>(rng() % vertexCount);
+        if ((src > dest) != (rng() % 100 < backEdgePercent))
+            std::swap(src, dest);
+        if constexpr (isMixed<Graph>)
+            graph.addEdge(src, dest, 1, rng() % 4 != 0);
+        else
+            graph.addEdge(src, dest, 1);
+    }
+    return graph;
+}
+
+// reaches[src][dest], from a depth-first search out of every vertex over hasEdge.
+template <typename Graph>
+std::vector<std::vector<char>> bruteForceReachability(const Graph &graph)
+{
+    std::vector<std::vector<char>> reaches(vertexCount, std::vector<char>(vertexCount, 0));
+    for (size_t src = 0; src < vertexCount; ++src)
+    {
+        std::vector<size_t> stack{src};
+        reaches[src][src] = 1;
+        while (!stack.empty())
+        {
+            size_t vertex = stack.back();
+            stack.pop_back();
+            for (size_t dest = 0; dest < vertexCount; ++dest)
+            {
+                if (!reaches[src][dest] && graph.hasEdge(VertexHandle(vertex), VertexHandle(dest)))
+                {
+                    reaches[src][dest] = 1;
+                    stack.push_back(dest);
+                }
+            }
+        }
+    }
+    return reaches;
+}
+
+void checkIndex(const ReachabilityIndex &index, const std::vector<std::vector<char>> &reaches)
+{
+    for (size_t src = 0; src < vertexCount; ++src)
+    {
+        for (size_t dest = 0; dest < vertexCount; ++dest)
+        {
+            CHECK(index.reachable(VertexHandle(src), VertexHandle(dest)) == static_cast<bool>(reaches[src][dest]));
+        }
+    }
+}
+
+template <typename Graph>
+void checkGraph(unsigned seed)
+{
+    std::mt19937 rng(seed);
+    for (size_t edgeCount : {size_t(150), size_t(400), size_t(1500)})
+    {
+        for (unsigned backEdgePercent : {0u, 2u, 20u})
+        {
+            Graph graph = makeGraph<Graph>(rng, edgeCount, backEdgePercent);
+            std::vector<std::vector<char>> reaches = bruteForceReachability(graph);
+
+            for (unsigned threads : {1u, 4u})
+            {
+                ReachabilityOptions options;
+                options.method = ReachabilityMethod::TransitiveClosure;
+                options.threads = threads;
+                ReachabilityIndex closure(graph, options);
+                CHECK(closure.method() == ReachabilityMethod::TransitiveClosure);
+                checkIndex(closure, reaches);
+            }
+
+            ReachabilityOptions labelOptions;
+            labelOptions.method = ReachabilityMethod::TwoHopLabels;
+            ReachabilityIndex labels(graph, labelOptions);
+            CHECK(labels.method() == ReachabilityMethod::TwoHopLabels);
+            checkIndex(labels, reaches);
+
+            // Auto falls back to labels once the closure would not fit the budget
+            ReachabilityOptions tight;
+            tight.maxClosureBytes = vertexCount * vertexCount / 8 - 1;
+            tight.threads = 4;
+            CHECK(ReachabilityIndex(graph, tight).method() == ReachabilityMethod::TwoHopLabels);
+            CHECK(ReachabilityIndex(graph).method() == ReachabilityMethod::TransitiveClosure);
+        }
+    }
+}
+
+int main()
+{
+    for (unsigned seed = 1; seed <= 2; ++seed)
+    {
+        checkGraph<GraphMatrix<int, int, DirectedG>>(seed);
+        checkGraph<GraphMatrix<int, int, UndirectedG>>(seed);
+        checkGraph<GraphMatrix<int, int, DirectedG, HashedVertexIndex<int>, PagedEdges>>(seed);
+        checkGraph<MixedGraphMatrix<int, int>>(seed);
+    }
+
+    GraphMatrix<int, int, DirectedG> single;
+    single.addVertex(7);
+    ReachabilityIndex index(single);
+    CHECK(index.reachable(VertexHandle(0), VertexHandle(0)));
+    bool threw = false;
+    try
+    {
+        index.reachable(VertexHandle(0), VertexHandle(1));
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+
+    std::puts("reachability: ok");
+    return 0;
+}
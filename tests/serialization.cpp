@@ -0,0 +1,365 @@
+// save() and load() round trips for every graph class, read back through load() and through
+// MappedGraph, and the errors a truncated, foreign or mismatched file must raise.
+#include <string>
+#include <tuple>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include <unistd.h>
+#include "TestCheck.h"
+#include "../include/GraphMatrix.h"
+#include "../include/MixedGraph.h"
+#include "../include/GraphCSR.h"
+#include "../include/GraphList.h"
+#include "../include/Serialization.h"
+
+using namespace Appledore;
+
+std::string tempPath(const std::string &name)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    return (directory / ("appledore-serialization-" + std::to_string(::getpid()) + "-" + name + ".graph")).string();
+}
+
+std::string readBytes(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void writeBytes(const std::string &path, const std::string &bytes)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// Saving what was loaded must give back the very same file: same vertex order, rows, values
+// and direction flags.
+template <typename Graph>
+void checkResave(const Graph &loaded, const std::string &path)
+{
+    std::string again = path + ".again";
+    loaded.save(again);
+    CHECK(readBytes(again) == readBytes(path));
+    std::remove(again.c_str());
+}
+
+// Every stored entry as (src, dest, value), read through forEachOutEdge.
+template <typename Graph>
+auto entriesOf(const Graph &graph)
+{
+    using Vertex = typename Graph::VertexValueType;
+    using Edge = typename Graph::EdgeValueType;
+    std::vector<std::tuple<Vertex, Vertex, Edge>> entries;
+    const std::vector<Vertex> &vertices = graph.getVertices();
+    for (size_t src = 0; src < vertices.size(); ++src)
+    {
+        graph.forEachOutEdge(VertexHandle(src), [&](VertexHandle dest, const Edge &value)
+                             { entries.emplace_back(vertices[src], vertices[dest.index], value); });
+    }
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+// Every entry of a file as (src, dest, value, directed), read through MappedGraph.
+template <typename Vertex, typename Edge>
+std::vector<std::tuple<Vertex, Vertex, Edge, bool>> mappedEntries(const std::string &path)
+{
+    MappedGraph<Vertex, Edge> mapped(path);
+    std::vector<std::tuple<Vertex, Vertex, Edge, bool>> entries;
+    const std::vector<Vertex> &vertices = mapped.getVertices();
+    for (size_t src = 0; src < vertices.size(); ++src)
+    {
+        mapped.forEachOutEdge(VertexHandle(src), [&](VertexHandle dest, const Edge &value)
+                              { entries.emplace_back(vertices[src], vertices[dest.index], value,
+                                                     mapped.isDirected(VertexHandle(src), dest)); });
+    }
+    CHECK(entries.size() == mapped.edgeCount());
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+template <typename Fn>
+void expectRuntimeError(Fn &&fn, const char *message)
+{
+    try
+    {
+        fn();
+    }
+    catch (const std::runtime_error &error)
+    {
+        CHECK(std::strstr(error.what(), message) != nullptr);
+        return;
+    }
+    CHECK(!"expected std::runtime_error");
+}
+
+// Long enough to live on the heap, so a value decoded into the wrong place shows under ASan.
+std::string city(const char *name)
+{
+    return std::string(name) + " international airport and railway station";
+}
+
+void checkDirectedMatrix()
+{
+    std::string path = tempPath("directed");
+    GraphMatrix<std::string, int, DirectedG> graph;
+    std::vector<std::string> cities = {city("Oslo"), city("Lima"), city("Kyiv"), city("Baku"), city("Rome")};
+    for (const std::string &name : cities)
+    {
+        graph.addVertex(name);
+    }
+    graph.addEdge(cities[0], cities[1], 7);
+    graph.addEdge(cities[1], cities[0], -3);
+    graph.addEdge(cities[1], cities[2], 11);
+    graph.addEdge(cities[2], cities[2], 0);
+    graph.addEdge(cities[4], cities[0], 42);
+    graph.save(path);
+
+    auto loaded = GraphMatrix<std::string, int, DirectedG>::load(path);
+    CHECK(loaded.getVertices() == graph.getVertices());
+    CHECK(entriesOf(loaded) == entriesOf(graph));
+    checkResave(loaded, path);
+
+    MappedGraph<std::string, int> mapped(path);
+    CHECK(mapped.getVertices() == graph.getVertices());
+    CHECK(mapped.edgeCount() == 5);
+    CHECK(!mapped.findVertex(city("Nuuk")));
+    for (const std::string &src : cities)
+    {
+        VertexHandle srcHandle = *mapped.findVertex(src);
+        CHECK(graph.getVertex(srcHandle) == src);
+        CHECK(mapped.outdegree(srcHandle) == graph.outdegree(src));
+        for (const std::string &dest : cities)
+        {
+            VertexHandle destHandle = *mapped.findVertex(dest);
+            CHECK(mapped.hasEdge(srcHandle, destHandle) == graph.hasEdge(src, dest));
+            if (graph.hasEdge(src, dest))
+            {
+                CHECK(mapped.getEdge(srcHandle, destHandle) == graph.getEdge(src, dest));
+                CHECK(mapped.isDirected(srcHandle, destHandle));
+            }
+        }
+    }
+    std::remove(path.c_str());
+}
+
+// Undirected edges come back as one shared value per pair, so an update shows from both ends.
+void checkPooledPairs()
+{
+    std::string path = tempPath("pooled");
+    using Graph = GraphMatrix<int, std::string, UndirectedG, HashedVertexIndex<int>, PooledEdges>;
+    Graph graph;
+    for (int vertex : {64, 128, 192, 256, 320})
+    {
+        graph.addVertex(vertex);
+    }
+    graph.addEdge(64, 128, city("first"));
+    graph.addEdge(192, 128, city("second"));
+    graph.addEdge(256, 256, city("loop"));
+    graph.addEdge(320, 64, city("last"));
+    graph.save(path);
+
+    Graph loaded = Graph::load(path);
+    CHECK(loaded.getVertices() == graph.getVertices());
+    CHECK(entriesOf(loaded) == entriesOf(graph));
+    checkResave(loaded, path);
+    for (auto [src, dest] : {std::pair(64, 128), std::pair(128, 192), std::pair(256, 256), std::pair(64, 320)})
+    {
+        CHECK(&loaded.getEdge(src, dest) == &loaded.getEdge(dest, src));
+    }
+    loaded.updateEdge(128, 64, city("updated"));
+    CHECK(loaded.getEdge(64, 128) == city("updated"));
+    std::remove(path.c_str());
+}
+
+// The triangle keeps one cell per pair; the file still lists both directions, and loads into
+// either storage.
+void checkTriangular()
+{
+    std::string path = tempPath("triangular");
+    using Graph = GraphMatrix<int, double, UndirectedG, OrderedVertexIndex<int>, TriangularEdges>;
+    Graph graph;
+    for (int vertex = 0; vertex < 70; ++vertex)
+    {
+        graph.addVertex(vertex);
+    }
+    for (int vertex = 0; vertex < 70; ++vertex)
+    {
+        graph.addEdge(vertex, (vertex * 7 + 3) % 70, vertex + 0.5);
+    }
+    graph.save(path);
+
+    Graph loaded = Graph::load(path);
+    CHECK(entriesOf(loaded) == entriesOf(graph));
+    checkResave(loaded, path);
+
+    auto inlined = GraphMatrix<int, double, UndirectedG>::load(path);
+    CHECK(entriesOf(inlined) == entriesOf(graph));
+
+    auto entries = mappedEntries<int, double>(path);
+    CHECK(entries.size() == entriesOf(graph).size());
+    for (const auto &entry : entries)
+    {
+        CHECK(!std::get<3>(entry));
+        CHECK(graph.getEdge(std::get<0>(entry), std::get<1>(entry)) == std::get<2>(entry));
+    }
+    std::remove(path.c_str());
+}
+
+// A directed edge, an undirected pair, undirected and directed self loops, and a pair whose two
+// cells disagree: the undirected edge b-a was later overwritten by a directed a->b.
+template <typename EdgeStorage>
+void checkMixedMatrix()
+{
+    std::string path = tempPath("mixed");
+    using Graph = MixedGraphMatrix<std::string, int, DefaultVertexIndex<std::string>, EdgeStorage>;
+    std::string a = city("Accra"), b = city("Bern"), c = city("Cairo"), d = city("Dili");
+    Graph graph;
+    for (const std::string &vertex : {a, b, c, d})
+    {
+        graph.addVertex(vertex);
+    }
+    graph.addEdge(b, a, 1, false);
+    graph.addEdge(a, b, 2, true);
+    graph.addEdge(b, c, 3, false);
+    graph.addEdge(c, d, 4, true);
+    graph.addEdge(d, d, 5, false);
+    graph.addEdge(a, a, 6, true);
+    graph.save(path);
+
+    std::vector<std::tuple<std::string, std::string, int, bool>> expected = {
+        {a, a, 6, true}, {a, b, 2, true}, {b, a, 1, false}, {b, c, 3, false},
+        {c, b, 3, false}, {c, d, 4, true}, {d, d, 5, false}};
+    std::sort(expected.begin(), expected.end());
+    CHECK((mappedEntries<std::string, int>(path) == expected));
+
+    Graph loaded = Graph::load(path);
+    CHECK(loaded.getVertices() == graph.getVertices());
+    checkResave(loaded, path);
+    CHECK(loaded.getEdgeValue(b, a) == 1 && loaded.getEdgeValue(a, b) == 2);
+    // b-a came back undirected but without a partner, so removing it leaves a->b alone
+    loaded.removeEdge(b, a);
+    CHECK(!loaded.hasEdge(b, a) && loaded.hasEdge(a, b));
+    loaded.removeEdge(c, b);
+    CHECK(!loaded.hasEdge(b, c));
+
+    // the list keeps the same flags
+    std::string listPath = tempPath("mixed-list");
+    auto list = MixedGraphList<std::string, int>::load(path);
+    list.save(listPath);
+    CHECK((mappedEntries<std::string, int>(listPath) == expected));
+    checkResave(MixedGraphList<std::string, int>::load(listPath), listPath);
+    std::remove(listPath.c_str());
+    std::remove(path.c_str());
+}
+
+void checkCompressedAndLists()
+{
+    std::string csrPath = tempPath("csr");
+    GraphCSR<int, int, DirectedG> csr;
+    csr.addVertex(5, 3, 9, 1);
+    csr.addEdge(5, 3, 10);
+    csr.addEdge(5, 1, 20);
+    csr.addEdge(9, 5, 30);
+    csr.addEdge(1, 1, 40);
+    csr.finalize();
+    csr.save(csrPath);
+
+    auto loadedCsr = GraphCSR<int, int, DirectedG>::load(csrPath);
+    CHECK(loadedCsr.isFinalized());
+    CHECK(loadedCsr.getVertices() == csr.getVertices());
+    CHECK(entriesOf(loadedCsr) == entriesOf(csr));
+    checkResave(loadedCsr, csrPath);
+    // a directed file loads into any directed class, and keeps its direction in a mixed one
+    CHECK(entriesOf(GraphMatrix<int, int, DirectedG>::load(csrPath)) == entriesOf(csr));
+    CHECK(entriesOf(GraphList<int, int, DirectedG>::load(csrPath)) == entriesOf(csr));
+    auto mixed = MixedGraphMatrix<int, int>::load(csrPath);
+    CHECK(mixed.hasEdge(5, 3) && !mixed.hasEdge(3, 5));
+
+    std::string listPath = tempPath("list");
+    GraphList<std::string, int, UndirectedG> list;
+    std::string x = city("Xi'an"), y = city("Yerevan"), z = city("Zagreb");
+    list.addVertex(x);
+    list.addVertex(y);
+    list.addVertex(z);
+    list.addEdge(x, y, 8);
+    list.addEdge(z, x, 9);
+    list.addEdge(z, z, 10);
+    list.save(listPath);
+
+    auto loadedList = GraphList<std::string, int, UndirectedG>::load(listPath);
+    CHECK(loadedList.getVertices() == list.getVertices());
+    CHECK(entriesOf(loadedList) == entriesOf(list));
+    checkResave(loadedList, listPath);
+    auto mixedList = MixedGraphList<std::string, int>::load(listPath);
+    CHECK(mixedList.getEdgeValue(y, x) == 8 && mixedList.getEdgeValue(x, z) == 9);
+    for (const auto &entry : mappedEntries<std::string, int>(listPath))
+    {
+        CHECK(!std::get<3>(entry));
+    }
+    std::remove(listPath.c_str());
+    std::remove(csrPath.c_str());
+}
+
+void checkRejectedFiles()
+{
+    std::string path = tempPath("source");
+    GraphMatrix<int, int, DirectedG> graph;
+    graph.addVertex(1, 2, 3);
+    graph.addEdge(1, 2, 4);
+    graph.addEdge(3, 1, 5);
+    graph.save(path);
+    std::string bytes = readBytes(path);
+    using Loaded = GraphMatrix<int, int, DirectedG>;
+
+    std::string broken = tempPath("broken");
+    for (size_t length : {size_t(0), size_t(12), sizeof(detail::GraphFileHeader), bytes.size() - 1})
+    {
+        writeBytes(broken, bytes.substr(0, length));
+        expectRuntimeError([&] { Loaded::load(broken); }, "truncated");
+        expectRuntimeError([&] { MappedGraph<int, int> mapped(broken); }, "truncated");
+    }
+
+    std::string wrongVersion = bytes;
+    uint32_t version = 2;
+    std::memcpy(&wrongVersion[offsetof(detail::GraphFileHeader, version)], &version, sizeof(version));
+    writeBytes(broken, wrongVersion);
+    expectRuntimeError([&] { Loaded::load(broken); }, "Unsupported graph file version 2");
+    expectRuntimeError([&] { MixedGraphList<int, int>::load(broken); }, "Unsupported graph file version 2");
+
+    std::string wrongMagic = bytes;
+    wrongMagic[0] = 'X';
+    writeBytes(broken, wrongMagic);
+    expectRuntimeError([&] { Loaded::load(broken); }, "Not an Appledore graph file");
+
+    expectRuntimeError([&] { GraphMatrix<int, int, UndirectedG>::load(path); }, "direction does not match");
+    expectRuntimeError([&] { GraphCSR<int, int, UndirectedG>::load(path); }, "direction does not match");
+    expectRuntimeError([&] { GraphMatrix<int, double, DirectedG>::load(path); }, "edge type does not match");
+    expectRuntimeError([&] { Loaded::load(tempPath("missing")); }, "");
+
+    std::remove(broken.c_str());
+    std::remove(path.c_str());
+}
+
+int main()
+{
+    checkDirectedMatrix();
+    checkPooledPairs();
+    checkTriangular();
+    checkMixedMatrix<InlineEdges>();
+    checkMixedMatrix<PooledEdges>();
+    checkMixedMatrix<PagedEdges>();
+    checkCompressedAndLists();
+    checkRejectedFiles();
+
+    std::puts("serialization: ok");
+    return 0;
+}
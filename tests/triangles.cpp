@@ -0,0 +1,170 @@
+// countTriangles() with both kernels and several threads on GraphMatrix, GraphCSR and GraphList,
+// checked against a scan of every vertex triple on random graphs of growing density.
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <utility>
+#include "TestCheck.h"
+#include "../include/Triangles.h"
+#include "../include/GraphMatrix.h"
+#include "../include/GraphCSR.h"
+#include "../include/GraphList.h"
+
+using namespace Appledore;
+
+// Several of countTriangles()' 64-vertex chunks, and bitset rows that end mid-word.
+constexpr size_t vertexCount = 150;
+
+struct Expected
+{
+    size_t triangles = 0;
+    std::vector<size_t> perVertex;
+    std::vector<double> clustering;
+    double averageClustering = 0.0;
+    double transitivity = 0.0;
+};
+
+// Triangles over every triple a < b < c, with self loops left out of degrees.
+Expected bruteForce(const std::vector<std::vector<char>> &edge)
+{
+    Expected expected;
+    expected.perVertex.assign(vertexCount, 0);
+    expected.clustering.assign(vertexCount, 0.0);
+    for (size_t a = 0; a < vertexCount; ++a)
+    {
+        for (size_t b = a + 1; b < vertexCount; ++b)
+        {
+            if (!edge[a][b])
+                continue;
+            for (size_t c = b + 1; c < vertexCount; ++c)
+            {
+                if (edge[a][c] && edge[b][c])
+                {
+                    expected.triangles++;
+                    expected.perVertex[a]++;
+                    expected.perVertex[b]++;
+                    expected.perVertex[c]++;
+                }
+            }
+        }
+    }
+
+    double triples = 0.0;
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        size_t degree = 0;
+        for (size_t other = 0; other < vertexCount; ++other)
+        {
+            degree += other != vertex && edge[vertex][other];
+        }
+        double pairs = degree * (degree - 1.0) / 2.0;
+        if (degree >= 2)
+        {
+            expected.clustering[vertex] = expected.perVertex[vertex] / pairs;
+            triples += pairs;
+        }
+        expected.averageClustering += expected.clustering[vertex] / vertexCount;
+    }
+    if (triples > 0)
+        expected.transitivity = 3.0 * expected.triangles / triples;
+    return expected;
+}
+
+bool near(double a, double b)
+{
+    return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b));
+}
+
+template <typename Graph>
+void checkCounts(const Graph &graph, const Expected &expected)
+{
+    for (TriangleKernel kernel : {TriangleKernel::SortedIntersection, TriangleKernel::Bitset, TriangleKernel::Auto})
+    {
+        for (unsigned threads : {1u, 4u})
+        {
+            TriangleOptions options;
+            options.kernel = kernel;
+            options.threads = threads;
+            TriangleCounts counts = countTriangles(graph, options);
+            CHECK(counts.triangles == expected.triangles);
+            CHECK(counts.perVertex == expected.perVertex);
+            CHECK(counts.clustering.size() == vertexCount);
+            for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+            {
+                CHECK(near(counts.clustering[vertex], expected.clustering[vertex]));
+            }
+            CHECK(near(counts.averageClustering, expected.averageClustering));
+            CHECK(near(counts.transitivity, expected.transitivity));
+        }
+    }
+}
+
+void checkRandomGraphs(unsigned seed)
+{
+    std::mt19937 rng(seed);
+    // from a handful of triangles up to a graph dense enough for Auto to pick the bitset
+    for (unsigned percent : {2u, 10u, 40u, 90u})
+    {
+        std::vector<std::vector<char>> edge(vertexCount, std::vector<char>(vertexCount, 0));
+        std::vector<std::pair<int, int>> pairs;
+        for (size_t a = 0; a < vertexCount; ++a)
+        {
+            for (size_t b = a; b < vertexCount; ++b)
+            {
+                // self loops are rarer, they only have to be ignored
+                if (rng() % 100 < (a == b ? 10 : percent))
+                {
+                    edge[a][b] = edge[b][a] = 1;
+                    pairs.emplace_back(static_cast<int>(a), static_cast<int>(b));
+                }
+            }
+        }
+        std::shuffle(pairs.begin(), pairs.end(), rng);
+
+        GraphMatrix<int, int, UndirectedG> matrix;
+        GraphMatrix<int, int, UndirectedG, OrderedVertexIndex<int>, TriangularEdges> triangular;
+        GraphCSR<int, int, UndirectedG> csr;
+        GraphList<int, int, UndirectedG> list;
+        for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            matrix.addVertex(static_cast<int>(vertex));
+            triangular.addVertex(static_cast<int>(vertex));
+            csr.addVertex(static_cast<int>(vertex));
+            list.addVertex(static_cast<int>(vertex));
+        }
+        for (auto [a, b] : pairs)
+        {
+            // add half of them the other way round
+            if (rng() % 2)
+                std::swap(a, b);
+            matrix.addEdge(a, b, 1);
+            triangular.addEdge(a, b, 1);
+            csr.addEdge(a, b, 1);
+            list.addEdge(a, b, 1);
+        }
+        csr.finalize();
+
+        Expected expected = bruteForce(edge);
+        checkCounts(matrix, expected);
+        checkCounts(triangular, expected);
+        checkCounts(csr, expected);
+        checkCounts(list, expected);
+    }
+}
+
+int main()
+{
+    for (unsigned seed = 1; seed <= 3; ++seed)
+    {
+        checkRandomGraphs(seed);
+    }
+
+    GraphMatrix<int, int, UndirectedG> empty;
+    TriangleCounts counts = countTriangles(empty, TriangleOptions{TriangleKernel::Bitset, 4});
+    CHECK(counts.triangles == 0 && counts.perVertex.empty() && counts.transitivity == 0.0);
+
+    std::puts("triangles: ok");
+    return 0;
+}
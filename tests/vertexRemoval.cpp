@@ -0,0 +1,321 @@
+// Random vertex and edge additions and removals, checked against a map-based model: cells,
+// values and degrees must match after removeVertex/removeVertices compact the matrix by moving
+// the last vertices into the freed indices, on every storage and on both vertex indexes.
+#include <map>
+#include <set>
+#include <string>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <utility>
+#include <type_traits>
+#include "TestCheck.h"
+#include "../include/GraphMatrix.h"
+#include "../include/MixedGraph.h"
+
+using namespace Appledore;
+
+// Enough keys to cross 64-vertex bitmap words and PagedEdges pages.
+constexpr int keyCount = 160;
+constexpr int operations = 2000;
+
+// Mixed graphs have no DirectionTag.
+template <typename Graph, typename = void>
+constexpr bool isMixed = true;
+template <typename Graph>
+constexpr bool isMixed<Graph, std::void_t<typename Graph::DirectionTag>> = false;
+
+template <typename Graph>
+constexpr bool isUndirected()
+{
+    if constexpr (isMixed<Graph>)
+        return false;
+    else
+        return std::is_same_v<typename Graph::DirectionTag, UndirectedG>;
+}
+
+// Keys spread out so that hashed slots collide and backward shifts run.
+int key(int number)
+{
+    return number * 64;
+}
+
+// Long enough to live on the heap, so a lost or doubly destroyed value shows under ASan.
+std::string edgeValue(unsigned number)
+{
+    return "edge value number " + std::to_string(number) + " of the removal test";
+}
+
+struct Cell
+{
+    std::string value;
+    bool directed;
+};
+
+// What the graph must hold: every stored cell, so an undirected edge is two cells (one for a
+// self loop), exactly as the matrix keeps it.
+struct Model
+{
+    std::set<int> vertices;
+    std::map<std::pair<int, int>, Cell> cells;
+
+    void removeVertex(int vertex)
+    {
+        vertices.erase(vertex);
+        for (auto cell = cells.begin(); cell != cells.end();)
+        {
+            if (cell->first.first == vertex || cell->first.second == vertex)
+                cell = cells.erase(cell);
+            else
+                ++cell;
+        }
+    }
+};
+
+template <typename Graph>
+const std::string &storedValue(const Graph &graph, int src, int dest)
+{
+    if constexpr (isMixed<Graph>)
+    {
+        static thread_local std::string value;
+        value = graph.getEdgeValue(src, dest);
+        return value;
+    }
+    else
+    {
+        return graph.getEdge(src, dest);
+    }
+}
+
+template <typename Graph>
+void checkModel(const Graph &graph, const Model &model)
+{
+    CHECK(graph.getVertices().size() == model.vertices.size());
+    CHECK((std::set<int>(graph.getVertices().begin(), graph.getVertices().end()) == model.vertices));
+    for (int number = 0; number < keyCount; ++number)
+    {
+        std::optional<VertexHandle> handle = graph.findVertex(key(number));
+        CHECK(handle.has_value() == (model.vertices.count(key(number)) == 1));
+        if (handle)
+            CHECK(graph.getVertex(*handle) == key(number));
+    }
+
+    std::map<int, size_t> out, in, directedOut, directedIn, undirected;
+    for (const auto &[ends, cell] : model.cells)
+    {
+        out[ends.first]++;
+        in[ends.second]++;
+        if (cell.directed)
+        {
+            directedOut[ends.first]++;
+            directedIn[ends.second]++;
+        }
+        else
+        {
+            undirected[ends.first]++;
+        }
+    }
+
+    std::vector<VertexDegree> degrees = graph.degrees();
+    for (int src : model.vertices)
+    {
+        for (int dest : model.vertices)
+        {
+            auto cell = model.cells.find({src, dest});
+            CHECK(graph.hasEdge(src, dest) == (cell != model.cells.end()));
+            if (cell != model.cells.end())
+                CHECK(storedValue(graph, src, dest) == cell->second.value);
+        }
+
+        size_t expectedIn, expectedOut, expectedTotal;
+        if constexpr (isMixed<Graph>)
+        {
+            expectedIn = directedIn[src] + undirected[src];
+            expectedOut = directedOut[src] + undirected[src];
+            expectedTotal = directedIn[src] + directedOut[src] + undirected[src];
+        }
+        else if constexpr (isUndirected<Graph>())
+        {
+            expectedIn = expectedOut = expectedTotal = out[src];
+        }
+        else
+        {
+            expectedIn = in[src];
+            expectedOut = out[src];
+            expectedTotal = in[src] + out[src];
+        }
+        CHECK(graph.indegree(src) == expectedIn);
+        CHECK(graph.outdegree(src) == expectedOut);
+        CHECK(graph.totalDegree(src) == expectedTotal);
+        const VertexDegree &degree = degrees[graph.findVertex(src)->index];
+        CHECK(degree.indegree == expectedIn && degree.outdegree == expectedOut && degree.totalDegree == expectedTotal);
+    }
+}
+
+template <typename Graph>
+void addEdge(Graph &graph, Model &model, int src, int dest, const std::string &value, bool directed)
+{
+    if constexpr (isMixed<Graph>)
+    {
+        graph.addEdge(src, dest, value, directed);
+        model.cells[{src, dest}] = {value, directed};
+        if (!directed)
+            model.cells[{dest, src}] = {value, false};
+    }
+    else
+    {
+        graph.addEdge(src, dest, value);
+        model.cells[{src, dest}] = {value, !isUndirected<Graph>()};
+        if (isUndirected<Graph>())
+            model.cells[{dest, src}] = {value, false};
+    }
+}
+
+template <typename Graph>
+void removeEdge(Graph &graph, Model &model, int src, int dest)
+{
+    graph.removeEdge(src, dest);
+    model.cells.erase({src, dest});
+    // the reverse cell goes too when it is undirected; directed graphs have no such cells
+    auto reverse = model.cells.find({dest, src});
+    if (reverse != model.cells.end() && !reverse->second.directed)
+        model.cells.erase(reverse);
+}
+
+template <typename Graph>
+void updateEdge(Graph &graph, Model &model, int src, int dest, const std::string &value)
+{
+    graph.updateEdge(src, dest, value);
+    Cell &cell = model.cells.at({src, dest});
+    cell.value = value;
+    auto reverse = model.cells.find({dest, src});
+    if (!cell.directed && reverse != model.cells.end())
+        reverse->second.value = value;
+}
+
+template <typename Graph>
+void runRandomOperations(unsigned seed)
+{
+    std::mt19937 rng(seed);
+    auto pick = [&](const auto &container)
+    {
+        auto position = container.begin();
+        std::advance(position, rng() % container.size());
+        return *position;
+    };
+
+    Graph graph;
+    Model model;
+    // a copy taken midway must not see anything done to the graph afterwards
+    Graph copy;
+    Model copyModel;
+
+    for (int operation = 1; operation <= operations; ++operation)
+    {
+        unsigned choice = rng() % 100;
+        if ((choice < 25 && model.vertices.size() < keyCount) || model.vertices.size() < 2)
+        {
+            int vertex = key(static_cast<int>(rng() % keyCount));
+            while (model.vertices.count(vertex))
+            {
+                vertex = key(static_cast<int>(rng() % keyCount));
+            }
+            graph.addVertex(vertex);
+            model.vertices.insert(vertex);
+        }
+        else if (choice < 27)
+        {
+            int vertex = pick(model.vertices);
+            graph.removeVertex(vertex);
+            model.removeVertex(vertex);
+        }
+        else if (choice < 29)
+        {
+            VertexHandle handle = *graph.findVertex(pick(model.vertices));
+            int vertex = graph.getVertex(handle);
+            graph.removeVertex(handle);
+            model.removeVertex(vertex);
+        }
+        else if (choice < 31)
+        {
+            // a few at once, sometimes the same one twice, so holes and moved vertices interleave
+            std::vector<int> batch;
+            size_t count = 1 + rng() % std::min<size_t>(6, model.vertices.size());
+            for (size_t item = 0; item < count; ++item)
+            {
+                batch.push_back(pick(model.vertices));
+            }
+            if (rng() % 2)
+            {
+                graph.removeVertices(batch);
+            }
+            else
+            {
+                std::vector<VertexHandle> handles;
+                for (int vertex : batch)
+                {
+                    handles.push_back(*graph.findVertex(vertex));
+                }
+                graph.removeVertices(handles);
+            }
+            for (int vertex : batch)
+            {
+                model.removeVertex(vertex);
+            }
+        }
+        else if (choice < 75 || model.cells.empty())
+        {
+            addEdge(graph, model, pick(model.vertices), pick(model.vertices), edgeValue(rng()), rng() % 2 == 0);
+        }
+        else if (choice < 88)
+        {
+            auto ends = pick(model.cells).first;
+            removeEdge(graph, model, ends.first, ends.second);
+        }
+        else
+        {
+            auto ends = pick(model.cells).first;
+            updateEdge(graph, model, ends.first, ends.second, edgeValue(rng()));
+        }
+
+        if (operation % 40 == 0)
+            checkModel(graph, model);
+        if (operation == operations / 2)
+        {
+            copy = graph;
+            copyModel = model;
+        }
+    }
+    checkModel(graph, model);
+    checkModel(copy, copyModel);
+}
+
+template <typename Graph>
+void checkGraph()
+{
+    for (unsigned seed = 1; seed <= 3; ++seed)
+    {
+        runRandomOperations<Graph>(seed);
+    }
+}
+
+int main()
+{
+    using Ordered = OrderedVertexIndex<int>;
+    using Hashed = HashedVertexIndex<int>;
+
+    checkGraph<GraphMatrix<int, std::string, DirectedG, Ordered, InlineEdges>>();
+    checkGraph<GraphMatrix<int, std::string, UndirectedG, Hashed, InlineEdges>>();
+    checkGraph<GraphMatrix<int, std::string, DirectedG, Hashed, PooledEdges>>();
+    checkGraph<GraphMatrix<int, std::string, UndirectedG, Ordered, PooledEdges>>();
+    checkGraph<GraphMatrix<int, std::string, UndirectedG, Ordered, TriangularEdges>>();
+    checkGraph<GraphMatrix<int, std::string, UndirectedG, Hashed, TriangularEdges>>();
+    checkGraph<GraphMatrix<int, std::string, DirectedG, Ordered, PagedEdges>>();
+    checkGraph<GraphMatrix<int, std::string, UndirectedG, Hashed, PagedEdges>>();
+    checkGraph<MixedGraphMatrix<int, std::string, Ordered, InlineEdges>>();
+    checkGraph<MixedGraphMatrix<int, std::string, Hashed, PooledEdges>>();
+    checkGraph<MixedGraphMatrix<int, std::string, Hashed, PagedEdges>>();
+
+    std::puts("vertexRemoval: ok");
+    return 0;
+}